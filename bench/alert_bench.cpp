@@ -0,0 +1,157 @@
+// Behavior and cost of the alert engine on synthetic snapshots
+//
+// A handful of rules are driven through raising, holding, dipping below the
+// threshold before their duration passed, clearing and losing their metric, and
+// every event emitted is checked against the one expected. Then a full rule set
+// is evaluated for every GPU per tick to time what the engine costs the sampler.
+#include <stdio.h>
+#include <chrono>  // std::chrono::steady_clock
+#include <utility> // std::pair
+#include <vector>  // std::vector
+
+#include "../src/alert.h"
+
+static constexpr std::size_t GPUS = 64;
+static constexpr std::size_t RULES = 32;
+static constexpr int TICKS = 20000;
+
+struct Expected {
+	std::size_t rule;
+	bool active;
+	bool available;
+};
+
+static int s_failures = 0;
+
+static Snapshot Make(double time, std::initializer_list<std::pair<Metric, float>> values)
+{
+	Snapshot snapshot = {};
+	snapshot.time = time;
+	for (const auto &value : values) {
+		snapshot.values[static_cast<NV_U32>(value.first)] = value.second;
+		snapshot.present |= MetricBit(value.first);
+	}
+	return snapshot;
+}
+
+// Evaluates [snapshot] on GPU 0 and compares the events emitted with [expected]
+static void Step(AlertEngine &engine, std::vector<AlertEngine::Event> &events, const Snapshot &snapshot, std::vector<Expected> expected)
+{
+	events.clear();
+	engine.Evaluate(0, snapshot);
+
+	bool matches = events.size() == expected.size();
+	for (std::size_t i = 0; matches && i < events.size(); i++) {
+		matches = events[i].rule == expected[i].rule && events[i].active == expected[i].active && events[i].available == expected[i].available;
+	}
+	if (!matches) {
+		printf("  at %.2fs expected %zu event(s), got %zu:", snapshot.time, expected.size(), events.size());
+		for (const auto &event : events) {
+			printf(" rule %zu %s%s", event.rule, event.active ? "raised" : "cleared", event.available ? "" : " unavailable");
+		}
+		printf("\n");
+		s_failures++;
+	}
+}
+
+static void CheckBehavior()
+{
+	AlertEngine engine;
+	const auto hot = engine.AddRule({ "hot", Metric::TEMPERATURE_GPU, AlertEngine::Kind::VALUE, AlertEngine::Comparison::ABOVE, 80.0f, 1.0f, Metric::LAST, -1 });
+	const auto heating = engine.AddRule({ "heating", Metric::TEMPERATURE_GPU, AlertEngine::Kind::RATE, AlertEngine::Comparison::ABOVE, 20.0f, 0.0f, Metric::LAST, -1 });
+	const auto limited = engine.AddRule({ "limited", Metric::POWER_USAGE, AlertEngine::Kind::RATIO, AlertEngine::Comparison::ABOVE, 0.95f, 0.0f, Metric::POWER_LIMIT, -1 });
+
+	std::vector<AlertEngine::Event> events;
+	engine.AddSink([&](const AlertEngine &, const AlertEngine::Event &event) { events.push_back(event); });
+	engine.Compile(1);
+
+	auto temperature = [](double time, float value) {
+		return Make(time, { { Metric::TEMPERATURE_GPU, value } });
+	};
+
+	// Raised once the condition held for the duration, held without further events, cleared once
+	Step(engine, events, temperature(0.0, 85.0f), {});
+	Step(engine, events, temperature(0.5, 85.0f), {});
+	Step(engine, events, temperature(1.0, 85.0f), { { hot, true, true } });
+	Step(engine, events, temperature(2.0, 85.0f), {});
+	Step(engine, events, temperature(3.0, 70.0f), { { hot, false, true } });
+
+	// A dip before the duration passed starts it over
+	Step(engine, events, temperature(4.0, 85.0f), {});
+	Step(engine, events, temperature(4.5, 79.0f), {});
+	Step(engine, events, temperature(5.0, 85.0f), {});
+	Step(engine, events, temperature(5.9, 85.0f), {});
+	Step(engine, events, temperature(6.0, 85.0f), { { hot, true, true } });
+
+	// Losing the metric clears the rule, it is raised again once the metric is back for the duration
+	Step(engine, events, Make(7.0, {}), { { hot, false, false } });
+	Step(engine, events, Make(7.5, {}), {});
+	Step(engine, events, temperature(8.0, 85.0f), {});
+	Step(engine, events, temperature(9.0, 85.0f), { { hot, true, true } });
+
+	// Rates need two samples, the first sample after the metric went missing has no rate
+	Step(engine, events, temperature(10.0, 40.0f), { { hot, false, true } });
+	Step(engine, events, temperature(11.0, 65.0f), { { heating, true, true } });
+	Step(engine, events, temperature(12.0, 76.0f), { { heating, false, true } });
+	Step(engine, events, Make(13.0, {}), {});
+	Step(engine, events, temperature(14.0, 20.0f), {});
+	Step(engine, events, temperature(14.5, 40.0f), { { heating, true, true } });
+
+	// Ratios clear as unavailable when only the reference goes missing
+	Step(engine, events, Make(15.0, { { Metric::POWER_USAGE, 99.0f }, { Metric::POWER_LIMIT, 100.0f } }), { { heating, false, false }, { limited, true, true } });
+	Step(engine, events, Make(16.0, { { Metric::POWER_USAGE, 99.0f } }), { { limited, false, false } });
+	Step(engine, events, Make(17.0, { { Metric::POWER_USAGE, 99.0f }, { Metric::POWER_LIMIT, 100.0f } }), { { limited, true, true } });
+	Step(engine, events, Make(18.0, { { Metric::POWER_USAGE, 50.0f }, { Metric::POWER_LIMIT, 100.0f } }), { { limited, false, true } });
+}
+
+static void MeasureEvaluate()
+{
+	const Metric metrics[] = { Metric::TEMPERATURE_GPU, Metric::CURRENT_CLOCK_CORE, Metric::USAGE_GPU, Metric::POWER_USAGE };
+
+	AlertEngine engine;
+	for (std::size_t i = 0; i < RULES; i++) {
+		const auto kind = static_cast<AlertEngine::Kind>(i % 3);
+		engine.AddRule({ "rule", metrics[i % 4], kind, AlertEngine::Comparison::ABOVE, 50.0f + i, 0.5f, Metric::POWER_LIMIT, -1 });
+	}
+	std::size_t event_count = 0;
+	engine.AddSink([&](const AlertEngine &, const AlertEngine::Event &) { event_count++; });
+	engine.Compile(GPUS);
+
+	// Values swing across the thresholds so rules keep raising and clearing
+	std::vector<Snapshot> snapshots(GPUS);
+	using namespace std::chrono;
+	double elapsed = 0.0;
+	for (int tick = 0; tick < TICKS; tick++) {
+		for (std::size_t gpu = 0; gpu < GPUS; gpu++) {
+			const float swing = static_cast<float>((tick * 7 + gpu * 13) % 100);
+			snapshots[gpu] = Make(tick * 0.1, {
+				{ Metric::TEMPERATURE_GPU, swing },
+				{ Metric::CURRENT_CLOCK_CORE, 100.0f - swing },
+				{ Metric::USAGE_GPU, swing },
+				{ Metric::POWER_USAGE, swing },
+				{ Metric::POWER_LIMIT, 100.0f }
+			});
+		}
+
+		const auto start = steady_clock::now();
+		for (std::size_t gpu = 0; gpu < GPUS; gpu++) {
+			engine.Evaluate(gpu, snapshots[gpu]);
+		}
+		elapsed += duration<double>(steady_clock::now() - start).count();
+	}
+
+	printf("%zu rules on %zu GPUs, %d ticks\n", RULES, GPUS, TICKS);
+	printf("  %.2f us per tick, %.1f ns per rule, %zu events\n", elapsed * 1e6 / TICKS, elapsed * 1e9 / TICKS / (RULES * GPUS), event_count);
+}
+
+int main()
+{
+	CheckBehavior();
+	MeasureEvaluate();
+
+	if (s_failures) {
+		printf("FAILED: %d evaluation(s) emitted unexpected events\n", s_failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,121 @@
+// Stress test of the async GPU API with hundreds of operations in flight
+//
+// Updates and fan writes are spread over every simulated GPU, set NVFC_SIM_GPUS to
+// change how many. The same operations are first run synchronously, waiting for
+// the driver thread one at a time, then kept IN_FLIGHT deep on the driver
+// executor while the caller burns through work of its own, which is what the
+// async API buys: the caller's work overlaps the driver round trips instead of
+// adding to them. An update of a GPU submitted while an identical one is queued
+// or running shares its result unless the fan of that GPU was written in
+// between, the executor reports how many were coalesced and how long requests
+// waited.
+#include <stdio.h>
+#include <deque>  // std::deque
+#include <vector> // std::vector
+
+#include "../src/gpu.h"
+#include "../src/executor.h"
+#include "../src/timing.h"
+
+static constexpr int OPERATIONS = 20000;
+static constexpr int IN_FLIGHT = 256;
+
+// Work the caller does per operation, roughly the cost of one Update
+static float Work(float seed)
+{
+	for (int i = 0; i < 2000; i++) {
+		seed = seed * 1.0001f + 0.5f;
+	}
+	return seed;
+}
+
+int main()
+{
+	if (NvAPI_Initialize() != 0) {
+		printf("failed to initialize NvAPI\n");
+		return 1;
+	}
+
+	NV_PHYSICAL_GPU_HANDLE gpu_handles[64];
+	NV_S32 gpu_count = 0;
+	NV_DISPLAY_HANDLE display_handle;
+	if (NvAPI_EnumPhysicalGPUs(gpu_handles, &gpu_count) != 0 || gpu_count == 0 || NvAPI_EnumDisplayHandle(0, &display_handle) != 0) {
+		printf("no GPUs\n");
+		return 1;
+	}
+
+	std::vector<GPU*> gpus;
+	for (NV_S32 i = 0; i < gpu_count; i++) {
+		gpus.push_back(new GPU(i, gpu_handles[i], display_handle));
+	}
+
+	// Every eighth operation writes the fan level, the rest update. A write only keeps
+	// updates of its own GPU from coalescing across it, with 8 GPUs or a multiple the
+	// writes all land on the same GPUs and the updates of the others never see one
+	auto operation = [&](int i) {
+		GPU *gpu = gpus[i % gpus.size()];
+		return i % 8 == 7 ? gpu->SetCustomFanSpeed(30 + i % 50) : gpu->Update();
+	};
+	auto operation_async = [&](int i) {
+		GPU *gpu = gpus[i % gpus.size()];
+		return i % 8 == 7 ? gpu->SetCustomFanSpeedAsync(30 + i % 50) : gpu->UpdateAsync();
+	};
+
+	float sum = 0.0f;
+	int failed = 0;
+
+	double start = MetricTime();
+	for (int i = 0; i < OPERATIONS; i++) {
+		failed += !operation(i);
+		sum += Work(static_cast<float>(i));
+	}
+	const double synchronous = MetricTime() - start;
+
+	// Latency from submitting an operation to its future being ready, sampled when it is collected
+	Histogram latency(OPERATIONS);
+	struct Pending {
+		std::future<bool> future;
+		double submitted;
+	};
+	std::deque<Pending> pending;
+	std::size_t peak = 0;
+
+	start = MetricTime();
+	for (int i = 0; i < OPERATIONS; i++) {
+		if (pending.size() == IN_FLIGHT) {
+			failed += !pending.front().future.get();
+			latency.Record(MetricTime() - pending.front().submitted);
+			pending.pop_front();
+		}
+		pending.push_back({ operation_async(i), MetricTime() });
+		peak = std::max(peak, DriverExecutor::Get().GetPending());
+		sum += Work(static_cast<float>(i));
+	}
+	while (!pending.empty()) {
+		failed += !pending.front().future.get();
+		latency.Record(MetricTime() - pending.front().submitted);
+		pending.pop_front();
+	}
+	const double asynchronous = MetricTime() - start;
+
+	printf("%d operations over %zu GPUs, %d in flight (%g)\n", OPERATIONS, gpus.size(), IN_FLIGHT, sum);
+	printf("  synchronous  %8.2f ms\n", synchronous * 1e3);
+	printf("  asynchronous %8.2f ms, %.2fx\n", asynchronous * 1e3, synchronous / asynchronous);
+	printf("  collected after p50 %.1f us, p99 %.1f us, max %.1f us\n", latency.GetPercentile(50.0) * 1e6, latency.GetPercentile(99.0) * 1e6, latency.GetMax() * 1e6);
+	const auto stats = DriverExecutor::Get().GetStats();
+	printf("  executor queue peaked at %zu, %llu requests in %llu batches\n", peak,
+		static_cast<unsigned long long>(stats.completed), static_cast<unsigned long long>(stats.batches));
+	printf("  coalesced %llu of %llu reads, %.1f%%\n", static_cast<unsigned long long>(stats.coalesced),
+		static_cast<unsigned long long>(stats.reads), stats.GetCoalescingRatio() * 100.0);
+	printf("  executor latency p50 %.1f us, p99 %.1f us\n", stats.latency.GetPercentile(50.0) * 1e6, stats.latency.GetPercentile(99.0) * 1e6);
+
+	for (GPU *gpu : gpus) {
+		delete gpu;
+	}
+
+	if (failed) {
+		printf("FAILED: %d operations failed\n", failed);
+		return 1;
+	}
+	return 0;
+}
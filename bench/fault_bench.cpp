@@ -0,0 +1,156 @@
+// Behavior of NVFC while the driver is slow, stalls or fails
+//
+// Every NvAPI interface is wrapped by the fault injection backend, each scenario
+// sets its rules and runs a 60Hz frame loop the way the UI does: the sampler is
+// polled every frame, the power scheduler ticks a few times a second and the
+// overview is built and rendered in memory with nuklear_raster.h. For
+// every scenario the frame time, the age of the stalest snapshot shown, the
+// updates which failed and the fraction of GPUs the scheduler could control are
+// reported. Set NVFC_SIM_GPUS to change how many GPUs are simulated.
+#include <stdio.h>
+#include <algorithm> // std::max
+#include <chrono>    // std::chrono::duration
+#include <thread>    // std::this_thread::sleep_until
+#include <vector>    // std::vector
+
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_STANDARD_IO
+#define NK_INCLUDE_STANDARD_VARARGS
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_IMPLEMENTATION
+#define NK_PRIVATE
+#include "../src/nuklear.h"
+
+#define NK_RASTER_IMPLEMENTATION
+#include "../src/nuklear_raster.h"
+
+#include "../src/gpu.h"
+#include "../src/nvapi_fault.h"
+#include "../src/power.h"
+#include "../src/publisher.h"
+#include "../src/sampler.h"
+#include "../src/timing.h"
+#include "../src/ui.h"
+
+static constexpr double DURATION = 2.0;
+static constexpr double FRAME = 1.0 / 60.0;
+static constexpr double TICK = 0.25;
+static constexpr float RATED_POWER = 250.0f;
+static constexpr unsigned int WIDTH = 650;
+static constexpr unsigned int HEIGHT = 400;
+
+struct Scenario {
+	const char *name;
+	const char *rules;
+};
+
+static const Scenario kScenarios[] = {
+	{ "baseline",          "" },
+	{ "latency",           "*:latency=0.0005,jitter=0.0005" },
+	{ "policies failing",  "GetPowerPoliciesStatus:error_rate=0.3" },
+	{ "stalls",            "*:stall_rate=0.002,stall=0.05" },
+	{ "cooler down",       "GetCoolerSettings:error_rate=1" },
+};
+
+int main()
+{
+	// Wrap every interface, the scenarios only change the rules
+	NvFaultSetRule("*", NvFaultDefaultRule());
+	if (NvAPI_Initialize() != 0) {
+		printf("failed to initialize NvAPI\n");
+		return 1;
+	}
+
+	NV_PHYSICAL_GPU_HANDLE gpu_handles[64];
+	NV_S32 gpu_count = 0;
+	NV_DISPLAY_HANDLE display_handle;
+	if (NvAPI_EnumPhysicalGPUs(gpu_handles, &gpu_count) != 0 || gpu_count == 0 || NvAPI_EnumDisplayHandle(0, &display_handle) != 0) {
+		printf("no GPUs\n");
+		return 1;
+	}
+
+	std::vector<GPU*> gpus;
+	for (NV_S32 i = 0; i < gpu_count; i++) {
+		gpus.push_back(new GPU(i, gpu_handles[i], display_handle));
+		gpus.back()->Update();
+	}
+
+	struct nk_context *ctx = nk_raster_init(WIDTH, HEIGHT);
+	NameTabs(gpus.size());
+
+	printf("%zu GPUs, %.0fs per scenario at %.0f frames/s\n", gpus.size(), DURATION, 1.0 / FRAME);
+	printf("  %-18s %24s %24s %8s %13s\n", "", "frame p50/p99/max ms", "stalest p50/p99/max ms", "failed", "controllable");
+
+	for (const auto &scenario : kScenarios) {
+		NvFaultClearRules();
+		NvFaultParse(scenario.rules);
+		NvFaultResetStats();
+
+		Sampler sampler({ FRAME, 0.5, {} });
+		PowerScheduler scheduler(gpus.size() * RATED_POWER * 0.8f);
+		for (GPU *gpu : gpus) {
+			sampler.Add(gpu);
+			scheduler.Add(gpu, RATED_POWER);
+		}
+
+		std::vector<History> histories(gpus.size());
+		std::vector<GPUView> views(gpus.size());
+		Publisher publisher;
+		publisher.Subscribe(-1, ALL_METRICS, [&](std::size_t gpu, const Snapshot &snapshot) {
+			histories[gpu].Add(snapshot);
+			views[gpu].Update(snapshot);
+		});
+		sampler.Attach(&publisher);
+
+		Histogram frames(4096);
+		Histogram stalest(4096);
+		std::size_t controllable = 0;
+		std::size_t observed = 0;
+
+		const double start = MetricTime();
+		double next_tick = start;
+		for (double frame = start; frame < start + DURATION; frame += FRAME) {
+			std::this_thread::sleep_until(std::chrono::steady_clock::now() + std::chrono::duration<double>(frame - MetricTime()));
+
+			const double begin = MetricTime();
+			sampler.Poll(begin);
+			if (begin >= next_tick) {
+				scheduler.Tick();
+				for (GPU *gpu : gpus) {
+					controllable += gpu->GetPowerLimit() && gpu->GetPowerUsage();
+				}
+				observed += gpus.size();
+				next_tick += TICK;
+			}
+
+			nk_input_begin(ctx);
+			nk_input_end(ctx);
+			MainWindow(ctx, nk_rect(0, 0, WIDTH, HEIGHT), gpus, histories, views, sampler);
+			nk_raster_render(nk_rgb(45, 45, 45));
+			const double end = MetricTime();
+			frames.Record(end - begin);
+
+			double age = 0.0;
+			for (std::size_t i = 0; i < gpus.size(); i++) {
+				// A GPU without a snapshot yet has been stale since the scenario started
+				const Snapshot &snapshot = sampler.GetSnapshot(i);
+				age = std::max(age, end - (snapshot.sequence ? snapshot.time : start));
+			}
+			stalest.Record(age);
+		}
+
+		const auto report = sampler.GetReport();
+		printf("  %-18s %8.2f %7.2f %7.2f %8.1f %7.1f %7.1f %4llu/%-4llu %12.0f%%\n", scenario.name,
+			frames.GetPercentile(50.0) * 1e3, frames.GetPercentile(99.0) * 1e3, frames.GetMax() * 1e3,
+			stalest.GetPercentile(50.0) * 1e3, stalest.GetPercentile(99.0) * 1e3, stalest.GetMax() * 1e3,
+			static_cast<unsigned long long>(report.failures), static_cast<unsigned long long>(report.samples),
+			observed ? 100.0 * controllable / observed : 0.0);
+	}
+
+	NvFaultLogStats();
+	nk_raster_shutdown();
+	for (GPU *gpu : gpus) {
+		delete gpu;
+	}
+	return 0;
+}
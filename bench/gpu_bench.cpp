@@ -0,0 +1,91 @@
+// Throughput of the GPU getters which read straight from the index map
+//
+// Each getter is called back to back on the data set of one Update, against the
+// simulated driver on Linux or with NVFC_SIMULATE defined. The results are summed
+// so the calls cannot be optimized away. Whole samples, an Update and a snapshot,
+// are then compared between GPU and an EmbeddedGPU reading only the GPU
+// temperature and core clock.
+#include <stdio.h>
+#include <chrono> // std::chrono::steady_clock
+
+#include "../src/gpu.h"
+#include "../src/embedded.h"
+
+static constexpr int ITERATIONS = 10000000;
+static constexpr int SAMPLES = 100000;
+
+static constexpr MetricSet EMBEDDED_METRICS = MetricBit(Metric::TEMPERATURE_GPU) | MetricBit(Metric::CURRENT_CLOCK_CORE);
+
+template<typename Function>
+static void Measure(const char *name, Function function)
+{
+	using namespace std::chrono;
+	float sum = 0.0f;
+	const auto start = steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		sum += function();
+	}
+	const double elapsed = duration<double>(steady_clock::now() - start).count();
+	printf("  %-28s %8.2f ns/call %8.1f M calls/s (%g)\n", name, elapsed * 1e9 / ITERATIONS, ITERATIONS / elapsed / 1e6, sum);
+}
+
+// Update and snapshot of [gpu], which has to provide Update, GetSnapshot and GetDriverCalls
+template<typename Sampled>
+static void MeasureSample(const char *name, Sampled &gpu)
+{
+	using namespace std::chrono;
+	Snapshot snapshot = {};
+	float sum = 0.0f;
+	const uint64_t driver_calls = gpu.GetDriverCalls();
+	const auto start = steady_clock::now();
+	for (int i = 0; i < SAMPLES; i++) {
+		gpu.Update();
+		gpu.GetSnapshot(snapshot);
+		sum += snapshot.Get(Metric::TEMPERATURE_GPU) + snapshot.Get(Metric::CURRENT_CLOCK_CORE);
+	}
+	const double elapsed = duration<double>(steady_clock::now() - start).count();
+	printf("  %-28s %8.2f ns/sample %5.1f driver calls/sample (%g)\n", name, elapsed * 1e9 / SAMPLES,
+		static_cast<double>(gpu.GetDriverCalls() - driver_calls) / SAMPLES, sum);
+}
+
+int main()
+{
+	if (NvAPI_Initialize() != 0) {
+		printf("failed to initialize NvAPI\n");
+		return 1;
+	}
+
+	NV_PHYSICAL_GPU_HANDLE gpu_handles[64];
+	NV_S32 gpu_count = 0;
+	NV_DISPLAY_HANDLE display_handle;
+	if (NvAPI_EnumPhysicalGPUs(gpu_handles, &gpu_count) != 0 || gpu_count == 0 || NvAPI_EnumDisplayHandle(0, &display_handle) != 0) {
+		printf("no GPUs\n");
+		return 1;
+	}
+
+	GPU gpu(0, gpu_handles[0], display_handle);
+	if (!gpu.Update()) {
+		printf("failed to update GPU\n");
+		return 1;
+	}
+
+	printf("%s, %d calls each\n", gpu.GetName().c_str(), ITERATIONS);
+	Measure("GetTemperature(GPU)", [&] { return gpu.GetTemperature(NV_THERMAL_TARGET::GPU).value_or(0.0f); });
+	Measure("GetTemperature(BOARD)", [&] { return gpu.GetTemperature(NV_THERMAL_TARGET::BOARD).value_or(0.0f); });
+	Measure("GetVoltage", [&] { return gpu.GetVoltage().value_or(0.0f); });
+	Measure("GetPowerUsage", [&] { return gpu.GetPowerUsage().value_or(0.0f); });
+	Measure("GetPowerLimit", [&] { return gpu.GetPowerLimit().value_or(GPU::OverclockSetting()).current_value; });
+	Measure("GetThermalLimit", [&] { return gpu.GetThermalLimit().value_or(GPU::OverclockSetting()).current_value; });
+
+	Snapshot snapshot = {};
+	Measure("GetSnapshot", [&] { gpu.GetSnapshot(snapshot); return snapshot.values[0]; });
+
+	printf("temperature and core clock, %d samples each\n", SAMPLES);
+	MeasureSample("GPU", gpu);
+	const NV_U32 subscription = gpu.Subscribe(EMBEDDED_METRICS);
+	MeasureSample("GPU subscribed", gpu);
+	gpu.Unsubscribe(subscription);
+	EmbeddedGPU<EMBEDDED_METRICS> embedded(gpu_handles[0], display_handle);
+	MeasureSample("EmbeddedGPU", embedded);
+	return 0;
+}
@@ -0,0 +1,110 @@
+// Checks that the nvfc.h queries stay O(1) and allocation free
+//
+// Every allocation is counted through the global operator new and malloc is not
+// used by the library, so any query allocating shows up in the count and fails
+// the run. Queries run against the simulated driver on Linux or with
+// NVFC_SIMULATE defined, running with NVFC_SIM_GPUS=1 and NVFC_SIM_GPUS=64 shows
+// the time per call does not grow with the number of GPUs.
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>  // std::atomic
+#include <chrono>  // std::chrono::steady_clock
+#include <new>     // std::bad_alloc
+
+#include "../src/nvfc.h"
+
+static std::atomic<uint64_t> g_allocations { 0 };
+
+void *operator new(std::size_t size)
+{
+	g_allocations++;
+	if (void *pointer = malloc(size ? size : 1)) {
+		return pointer;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept
+{
+	free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+	free(pointer);
+}
+
+static constexpr int ITERATIONS = 1000000;
+
+// Returns the number of allocations made by [function]
+template<typename Function>
+static uint64_t Measure(const char *name, Function function)
+{
+	using namespace std::chrono;
+	const uint64_t allocations = g_allocations;
+	const auto start = steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		function(i);
+	}
+	const double elapsed = duration<double, std::nano>(steady_clock::now() - start).count();
+	printf("  %-28s %8.2f ns/call %8llu allocations\n", name, elapsed / ITERATIONS,
+		static_cast<unsigned long long>(g_allocations - allocations));
+	return g_allocations - allocations;
+}
+
+int main()
+{
+	if (nvfc_init() != NVFC_OK) {
+		printf("nvfc_init failed\n");
+		return 1;
+	}
+
+	const int count = nvfc_get_gpu_count();
+	if (count == 0) {
+		printf("no GPUs\n");
+		return 1;
+	}
+	for (int i = 0; i < count; i++) {
+		nvfc_gpu_update(nvfc_get_gpu(i));
+	}
+	printf("%d GPU(s), %d calls each\n", count, ITERATIONS);
+
+	uint64_t allocations = 0;
+	volatile float sink = 0.0f;
+	allocations += Measure("nvfc_get_gpu", [&](int i) {
+		sink = sink + (nvfc_get_gpu(i % count) != nullptr);
+	});
+	allocations += Measure("nvfc_gpu_get_info", [&](int i) {
+		nvfc_gpu_info info;
+		nvfc_gpu_get_info(nvfc_get_gpu(i % count), &info);
+		sink = sink + info.name[0];
+	});
+	allocations += Measure("nvfc_gpu_get_sample", [&](int i) {
+		nvfc_sample sample;
+		nvfc_gpu_get_sample(nvfc_get_gpu(i % count), &sample);
+		sink = sink + sample.values[NVFC_METRIC_TEMPERATURE_GPU];
+	});
+	allocations += Measure("nvfc_gpu_get_metric", [&](int i) {
+		float value = 0.0f;
+		nvfc_gpu_get_metric(nvfc_get_gpu(i % count), static_cast<nvfc_metric>(i % NVFC_METRIC_COUNT), &value);
+		sink = sink + value;
+	});
+	allocations += Measure("nvfc_gpu_get_power_limit", [&](int i) {
+		nvfc_limit limit = {};
+		nvfc_gpu_get_power_limit(nvfc_get_gpu(i % count), &limit);
+		sink = sink + limit.current_value;
+	});
+	allocations += Measure("nvfc_gpu_get_thermal_limit", [&](int i) {
+		nvfc_limit limit = {};
+		nvfc_gpu_get_thermal_limit(nvfc_get_gpu(i % count), &limit);
+		sink = sink + limit.current_value;
+	});
+
+	nvfc_shutdown();
+
+	if (allocations) {
+		printf("queries allocated\n");
+		return 1;
+	}
+	return 0;
+}
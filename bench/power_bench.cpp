@@ -0,0 +1,198 @@
+// Behavior of the power scheduler
+//
+// Schedule is driven on devices with random loads and budgets, each device
+// applies the limit it was given and draws up to it. The sum of the limits has
+// to fit the budget on every tick, and with the loads held the limits have to
+// settle within a few ticks. Then Tick is run against simulated GPUs which
+// start out over the budget and whose power limit writes sometimes fail. The
+// limits the driver holds have to fit the budget after every tick whose writes
+// all went through, and must never grow past what they were while a decrease
+// is refused. Set NVFC_SIM_GPUS to change how many GPUs are simulated.
+#include <stdio.h>
+#include <algorithm> // std::min, std::max
+#include <cmath>     // std::fabs
+#include <random>    // std::mt19937
+#include <vector>    // std::vector
+
+#include "../src/gpu.h"
+#include "../src/nvapi_fault.h"
+#include "../src/power.h"
+
+static constexpr int SCENARIOS = 2000;
+static constexpr int TICKS = 20;
+
+// Ticks the limits may take to settle once the loads stop changing
+static constexpr int SETTLE_TICKS = 8;
+
+// Change of a limit in watts below which it counts as settled
+static constexpr float SETTLED = 1.0f;
+
+// Slack for float rounding when summing limits, in watts
+static constexpr float EPSILON = 0.01f;
+
+static constexpr int SIM_TICKS = 200;
+static constexpr float RATED_POWER = 250.0f;
+
+static int s_failures = 0;
+
+static void CheckSchedule()
+{
+	std::mt19937 random(1);
+	auto uniform = [&](float low, float high) {
+		return std::uniform_real_distribution<float>(low, high)(random);
+	};
+
+	std::size_t over_budget = 0;
+	std::size_t unsettled = 0;
+	int worst_settle = 0;
+	for (int scenario = 0; scenario < SCENARIOS; scenario++) {
+		const std::size_t count = 1 + random() % 8;
+		std::vector<PowerScheduler::Device> devices(count);
+		std::vector<float> loads(count);
+		std::vector<float> limits(count);
+
+		float floor = 0.0f;
+		for (std::size_t i = 0; i < count; i++) {
+			auto &device = devices[i];
+			device.rated_power = uniform(100.0f, 350.0f);
+			device.min_limit = device.rated_power * 0.5f;
+			device.max_limit = device.rated_power * 1.2f;
+			device.limit = uniform(device.min_limit, device.max_limit);
+			loads[i] = uniform(0.1f, 1.4f) * device.rated_power;
+			device.usage = uniform(0.0f, 100.0f);
+			floor += device.min_limit;
+		}
+
+		// Budgets between the minimum limits and everything the devices could take
+		PowerScheduler scheduler(floor * uniform(1.0f, 1.8f));
+
+		int settled_at = -1;
+		for (int tick = 0; tick < TICKS; tick++) {
+			for (std::size_t i = 0; i < count; i++) {
+				devices[i].power = std::min(loads[i], devices[i].limit);
+			}
+
+			scheduler.Schedule(devices.data(), count, limits.data());
+
+			float sum = 0.0f;
+			float change = 0.0f;
+			for (std::size_t i = 0; i < count; i++) {
+				sum += limits[i];
+				change = std::max(change, std::fabs(limits[i] - devices[i].limit));
+				devices[i].limit = limits[i];
+			}
+
+			if (sum > scheduler.GetBudget() + EPSILON) {
+				if (over_budget++ < 5) {
+					printf("  scenario %d tick %d: %zu limits sum to %.3fW over a budget of %.3fW\n", scenario, tick, count, sum, scheduler.GetBudget());
+				}
+			}
+
+			// The first tick may still move the randomly applied limits
+			if (change < SETTLED) {
+				if (settled_at < 0) {
+					settled_at = tick;
+				}
+			} else {
+				settled_at = -1;
+			}
+		}
+
+		if (settled_at < 0 || settled_at > SETTLE_TICKS) {
+			if (unsettled++ < 5) {
+				printf("  scenario %d: %zu limits did not settle within %d ticks\n", scenario, count, SETTLE_TICKS);
+			}
+		} else {
+			worst_settle = std::max(worst_settle, settled_at);
+		}
+	}
+
+	printf("Schedule, %d scenarios of up to 8 devices, %d ticks each\n", SCENARIOS, TICKS);
+	printf("  %zu tick(s) over budget, %zu scenario(s) unsettled, settled within %d ticks at worst\n", over_budget, unsettled, worst_settle);
+	s_failures += over_budget > 0;
+	s_failures += unsettled > 0;
+}
+
+static void CheckTick()
+{
+	// Writes failing now and then must not leave the driver over budget either
+	NvFaultSetRule("*", NvFaultDefaultRule());
+	NvFaultParse("SetPowerPoliciesStatus:error_rate=0.2");
+	if (NvAPI_Initialize() != 0) {
+		printf("failed to initialize NvAPI\n");
+		s_failures++;
+		return;
+	}
+
+	NV_PHYSICAL_GPU_HANDLE gpu_handles[64];
+	NV_S32 gpu_count = 0;
+	NV_DISPLAY_HANDLE display_handle;
+	if (NvAPI_EnumPhysicalGPUs(gpu_handles, &gpu_count) != 0 || gpu_count == 0 || NvAPI_EnumDisplayHandle(0, &display_handle) != 0) {
+		printf("no GPUs\n");
+		s_failures++;
+		return;
+	}
+
+	std::vector<GPU*> gpus;
+	for (NV_S32 i = 0; i < gpu_count; i++) {
+		gpus.push_back(new GPU(i, gpu_handles[i], display_handle));
+	}
+
+	// Tight enough that the simulated GPUs compete for it
+	PowerScheduler scheduler(gpus.size() * RATED_POWER * 0.7f);
+	for (GPU *gpu : gpus) {
+		scheduler.Add(gpu, RATED_POWER);
+	}
+
+	// What the driver holds, not what the scheduler asked for
+	auto held = [&] {
+		float sum = 0.0f;
+		for (GPU *gpu : gpus) {
+			gpu->Update();
+			const auto limit = gpu->GetPowerLimit();
+			sum += limit ? limit->current_value * RATED_POWER / 100.0f : RATED_POWER;
+		}
+		return sum;
+	};
+
+	std::size_t over_budget = 0;
+	std::size_t failed_ticks = 0;
+	float highest = 0.0f;
+	float before = held();
+	for (int tick = 0; tick < SIM_TICKS; tick++) {
+		const bool written = scheduler.Tick();
+		failed_ticks += !written;
+
+		const float after = held();
+		const float allowed = written ? scheduler.GetBudget() : std::max(scheduler.GetBudget(), before);
+		if (after > allowed + EPSILON) {
+			if (over_budget++ < 5) {
+				printf("  tick %d: the driver holds %.3fW of limits, %.3fW before, over a budget of %.3fW\n", tick, after, before, scheduler.GetBudget());
+			}
+		}
+		if (tick > 0) {
+			highest = std::max(highest, after);
+		}
+		before = after;
+	}
+
+	printf("Tick, %zu simulated GPUs, %d ticks, a fifth of the limit writes failing\n", gpus.size(), SIM_TICKS);
+	printf("  %zu tick(s) over budget, %zu tick(s) with failed writes, at most %.1fW of %.1fW after the first tick\n", over_budget, failed_ticks, highest, scheduler.GetBudget());
+	s_failures += over_budget > 0;
+
+	for (GPU *gpu : gpus) {
+		delete gpu;
+	}
+}
+
+int main()
+{
+	CheckSchedule();
+	CheckTick();
+
+	if (s_failures) {
+		printf("FAILED: %d check(s) of the power scheduler were off\n", s_failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,108 @@
+// Cost of measuring text with the GDI font of the window, Windows only
+//
+// nk_gdifont_get_text_width sums cached advances for plain ASCII and remembers
+// the width of anything else GDI measured. Both paths are timed on the kind of
+// strings the window lays out every frame, against converting the text and
+// calling GetTextExtentPoint32W for every string, which is what measuring cost
+// before the advances and the memo. The widths of both are compared as well.
+#include <stdio.h>
+#include <string.h>
+#include <chrono> // std::chrono::steady_clock
+
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_STANDARD_IO
+#define NK_INCLUDE_STANDARD_VARARGS
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_IMPLEMENTATION
+#define NK_PRIVATE
+#include "../src/nuklear.h"
+
+#define NK_GDI_IMPLEMENTATION
+#include "../src/nuklear_gdi.h"
+
+static constexpr int ITERATIONS = 20000;
+
+// Tab, label and chart text the window shows
+static const char *kASCII[] = {
+	"Overview",
+	"GPU 0",
+	"GPU 12",
+	"Serial:",
+	"0x1B8110DE",
+	"Temperature GPU: 65C (41C - 77C)",
+	"Current Clock Core: 1822 MHz (1395 MHz - 1911 MHz)",
+	"Usage GPU: 97%",
+	"NVIDIA GeForce RTX 3080",
+};
+
+// Text with characters beyond ASCII, GDI measures it once and the memo serves it after
+static const char *kUnicode[] = {
+	"65\xc2\xb0" "C",
+	"\xc3\x9c" "berhitzung",
+	"L\xc3\xbc" "fter 42%",
+	"\xe6\xb8\xa9\xe5\xba\xa6 65C",
+};
+
+// Measures [text] the way it was measured before, converting it and asking GDI every time
+static float Extent(GdiFont *font, const char *text, int len)
+{
+	WCHAR wstr[256];
+	SIZE size;
+	const int wsize = MultiByteToWideChar(CP_UTF8, 0, text, len, wstr, 256);
+	if (!GetTextExtentPoint32W(font->dc, wstr, wsize, &size)) {
+		return -1.0f;
+	}
+	return (float)size.cx;
+}
+
+template <typename Measure>
+static double Time(const char *const *texts, std::size_t count, Measure measure)
+{
+	using namespace std::chrono;
+	float sink = 0.0f;
+	const auto start = steady_clock::now();
+	for (int i = 0; i < ITERATIONS; i++) {
+		for (std::size_t text = 0; text < count; text++) {
+			sink += measure(texts[text], static_cast<int>(strlen(texts[text])));
+		}
+	}
+	const double elapsed = duration<double>(steady_clock::now() - start).count();
+	if (sink < 0.0f) {
+		printf("GDI failed to measure\n");
+	}
+	return elapsed * 1e9 / (ITERATIONS * count);
+}
+
+static void Compare(const char *name, GdiFont *font, const char *const *texts, std::size_t count)
+{
+	const nk_handle handle = nk_handle_ptr(font);
+	const double before = Time(texts, count, [&](const char *text, int len) { return Extent(font, text, len); });
+	const double after = Time(texts, count, [&](const char *text, int len) { return nk_gdifont_get_text_width(handle, 0.0f, text, len); });
+
+	std::size_t mismatches = 0;
+	for (std::size_t text = 0; text < count; text++) {
+		const int len = static_cast<int>(strlen(texts[text]));
+		if (Extent(font, texts[text], len) != nk_gdifont_get_text_width(handle, 0.0f, texts[text], len)) {
+			mismatches++;
+		}
+	}
+
+	printf("  %-8s %10.1f %10.1f %7.1fx %6zu/%zu\n", name, before, after, before / after, mismatches, count);
+}
+
+int main()
+{
+	GdiFont *font = nk_gdifont_create("Roboto", 18);
+	if (!font) {
+		printf("failed to create the font\n");
+		return 1;
+	}
+
+	printf("%d iterations, ns per string\n", ITERATIONS);
+	printf("  %-8s %10s %10s %8s %8s\n", "", "GDI", "nuklear", "speedup", "differ");
+	Compare("ascii", font, kASCII, sizeof kASCII / sizeof *kASCII);
+	Compare("unicode", font, kUnicode, sizeof kUnicode / sizeof *kUnicode);
+
+	nk_gdifont_del(font);
+	return 0;
+}
@@ -0,0 +1,199 @@
+// Behavior and cost of the throttle analyzer on synthetic snapshots
+//
+// A GPU is walked through every throttle reason, including reasons changing
+// between two snapshots, snapshots which were dropped, gaps too long to account
+// and snapshots missing the clocks. The reason and the totals of every reason are
+// checked after each snapshot. Then the analyzer is timed on a stream of snapshots
+// cycling through the reasons.
+#include <stdio.h>
+#include <math.h>
+#include <chrono> // std::chrono::steady_clock
+
+#include "../src/throttle.h"
+
+static constexpr float BOOST = 1800.0f;
+static constexpr float BASE = 1500.0f;
+static constexpr int SNAPSHOTS = 10000000;
+
+using Reason = ThrottleAnalyzer::Reason;
+
+struct Expected {
+	double time;
+	double lost;
+};
+
+static int s_failures = 0;
+
+static bool Near(double a, double b)
+{
+	return fabs(a - b) < 1e-9;
+}
+
+// A GPU below its thermal, power and utilization thresholds unless told otherwise
+static Snapshot Make(uint64_t sequence, double time, float clock, float temperature = 60.0f, float power = 50.0f, float usage = 99.0f)
+{
+	Snapshot snapshot = {};
+	snapshot.sequence = sequence;
+	snapshot.time = time;
+	auto set = [&](Metric metric, float value) {
+		snapshot.values[static_cast<NV_U32>(metric)] = value;
+		snapshot.present |= MetricBit(metric);
+	};
+	set(Metric::CURRENT_CLOCK_CORE, clock);
+	set(Metric::BASE_CLOCK_CORE, BASE);
+	set(Metric::BOOST_CLOCK_CORE, BOOST);
+	set(Metric::TEMPERATURE_GPU, temperature);
+	set(Metric::THERMAL_LIMIT, 84.0f);
+	set(Metric::POWER_USAGE, power);
+	set(Metric::POWER_LIMIT, 100.0f);
+	set(Metric::USAGE_GPU, usage);
+	return snapshot;
+}
+
+// Adds [snapshot] and compares the reason and every total with the expected ones
+static void Step(ThrottleAnalyzer &analyzer, const Snapshot &snapshot, Reason reason, const Expected (&totals)[static_cast<int>(Reason::LAST)], double below_base)
+{
+	const Reason got = analyzer.Add(snapshot);
+	if (got != reason) {
+		printf("  at %.2fs expected reason %s, got %s\n", snapshot.time, ThrottleAnalyzer::ReasonName(reason), ThrottleAnalyzer::ReasonName(got));
+		s_failures++;
+	}
+
+	for (int i = 0; i < static_cast<int>(Reason::LAST); i++) {
+		const auto &actual = analyzer.GetTotals(static_cast<Reason>(i));
+		if (!Near(actual.time, totals[i].time) || !Near(actual.lost, totals[i].lost)) {
+			printf("  at %.2fs expected %s %.3fs lost %.4fs, got %.3fs lost %.4fs\n",
+				snapshot.time,
+				ThrottleAnalyzer::ReasonName(static_cast<Reason>(i)),
+				totals[i].time, totals[i].lost,
+				actual.time, actual.lost);
+			s_failures++;
+		}
+	}
+
+	if (!Near(analyzer.GetBelowBaseTime(), below_base)) {
+		printf("  at %.2fs expected %.3fs below base, got %.3fs\n", snapshot.time, below_base, analyzer.GetBelowBaseTime());
+		s_failures++;
+	}
+}
+
+static void CheckBehavior()
+{
+	ThrottleAnalyzer analyzer;
+
+	// Totals indexed by reason: none, thermal, power, utilization, unknown
+	Expected totals[static_cast<int>(Reason::LAST)] = {};
+	auto &none = totals[static_cast<int>(Reason::NONE)];
+	auto &thermal = totals[static_cast<int>(Reason::THERMAL)];
+	auto &power = totals[static_cast<int>(Reason::POWER)];
+	auto &utilization = totals[static_cast<int>(Reason::UTILIZATION)];
+	auto &unknown = totals[static_cast<int>(Reason::UNKNOWN)];
+	double below_base = 0.0;
+
+	// The first snapshot has nothing to account time to
+	Step(analyzer, Make(1, 0.0, BOOST), Reason::NONE, totals, below_base);
+	none.time += 1.0;
+	Step(analyzer, Make(2, 1.0, BOOST * 0.98f), Reason::NONE, totals, below_base);
+
+	// The time since the previous snapshot goes to the reason of the new one, the lost
+	// throughput to the clock it ran at
+	thermal.time += 1.0;
+	thermal.lost += 1.0 * (BOOST - 1700.0f) / BOOST;
+	Step(analyzer, Make(3, 2.0, 1700.0f, 83.0f, 99.0f), Reason::THERMAL, totals, below_base);
+	power.time += 1.0;
+	power.lost += 1.0 * (BOOST - 1600.0f) / BOOST;
+	Step(analyzer, Make(4, 3.0, 1600.0f, 60.0f, 99.0f), Reason::POWER, totals, below_base);
+	utilization.time += 0.5;
+	utilization.lost += 0.5 * (BOOST - 1400.0f) / BOOST;
+	below_base += 0.5;
+	Step(analyzer, Make(5, 3.5, 1400.0f, 60.0f, 50.0f, 40.0f), Reason::UTILIZATION, totals, below_base);
+	unknown.time += 0.5;
+	unknown.lost += 0.5 * (BOOST - 1700.0f) / BOOST;
+	Step(analyzer, Make(6, 4.0, 1700.0f), Reason::UNKNOWN, totals, below_base);
+
+	// Dropped snapshots skip sequence numbers, the time between the two seen is still accounted
+	power.time += 3.0;
+	power.lost += 3.0 * (BOOST - 1650.0f) / BOOST;
+	Step(analyzer, Make(12, 7.0, 1650.0f, 60.0f, 98.0f), Reason::POWER, totals, below_base);
+
+	// A gap longer than the GPU can be assumed unchanged is not accounted at all
+	Step(analyzer, Make(40, 15.0, 1700.0f, 84.0f), Reason::THERMAL, totals, below_base);
+	thermal.time += 1.0;
+	thermal.lost += 1.0 * (BOOST - 1700.0f) / BOOST;
+	Step(analyzer, Make(41, 16.0, 1700.0f, 84.0f), Reason::THERMAL, totals, below_base);
+
+	// Snapshots at the same time or going back are not accounted either
+	Step(analyzer, Make(42, 16.0, 1700.0f, 84.0f), Reason::THERMAL, totals, below_base);
+	Step(analyzer, Make(43, 15.5, 1700.0f, 84.0f), Reason::THERMAL, totals, below_base);
+	thermal.time += 0.5;
+	thermal.lost += 0.5 * (BOOST - 1700.0f) / BOOST;
+	Step(analyzer, Make(44, 16.0, 1700.0f, 84.0f), Reason::THERMAL, totals, below_base);
+
+	// Losing the clocks breaks the sequence, the next snapshot starts it over
+	Snapshot missing = Make(45, 17.0, 1600.0f, 60.0f, 99.0f);
+	missing.present &= ~MetricBit(Metric::CURRENT_CLOCK_CORE);
+	Step(analyzer, missing, Reason::NONE, totals, below_base);
+	Step(analyzer, Make(46, 18.0, 1600.0f, 60.0f, 99.0f), Reason::POWER, totals, below_base);
+	power.time += 1.0;
+	power.lost += 1.0 * (BOOST - 1600.0f) / BOOST;
+	Step(analyzer, Make(47, 19.0, 1600.0f, 60.0f, 99.0f), Reason::POWER, totals, below_base);
+
+	// So does a boost clock which was never reported
+	Snapshot unknown_boost = Make(48, 20.0, 1400.0f, 60.0f, 50.0f, 40.0f);
+	unknown_boost.values[static_cast<NV_U32>(Metric::BOOST_CLOCK_CORE)] = 0.0f;
+	Step(analyzer, unknown_boost, Reason::NONE, totals, below_base);
+	Step(analyzer, Make(49, 21.0, 1400.0f, 60.0f, 50.0f, 40.0f), Reason::UTILIZATION, totals, below_base);
+	utilization.time += 1.0;
+	utilization.lost += 1.0 * (BOOST - 1400.0f) / BOOST;
+	below_base += 1.0;
+	Step(analyzer, Make(50, 22.0, 1400.0f, 60.0f, 50.0f, 40.0f), Reason::UTILIZATION, totals, below_base);
+
+	// Without the limits a clock drop can only be explained by the usage
+	Snapshot no_limits = Make(51, 23.0, 1600.0f, 90.0f, 120.0f);
+	no_limits.present &= ~(MetricBit(Metric::THERMAL_LIMIT) | MetricBit(Metric::POWER_LIMIT));
+	unknown.time += 1.0;
+	unknown.lost += 1.0 * (BOOST - 1600.0f) / BOOST;
+	Step(analyzer, no_limits, Reason::UNKNOWN, totals, below_base);
+
+	analyzer.Reset();
+	const Expected cleared[static_cast<int>(Reason::LAST)] = {};
+	Step(analyzer, Make(52, 24.0, 1700.0f, 84.0f), Reason::THERMAL, cleared, 0.0);
+}
+
+static void MeasureAdd()
+{
+	const Snapshot snapshots[] = {
+		Make(0, 0.0, BOOST),
+		Make(0, 0.0, 1700.0f, 83.0f),
+		Make(0, 0.0, 1600.0f, 60.0f, 99.0f),
+		Make(0, 0.0, 1400.0f, 60.0f, 50.0f, 40.0f),
+		Make(0, 0.0, 1700.0f)
+	};
+
+	ThrottleAnalyzer analyzer;
+	Snapshot snapshot;
+	using namespace std::chrono;
+	const auto start = steady_clock::now();
+	for (int i = 0; i < SNAPSHOTS; i++) {
+		snapshot = snapshots[(i / 7) % 5];
+		snapshot.sequence = i;
+		snapshot.time = i * 0.1;
+		analyzer.Add(snapshot);
+	}
+	const double elapsed = duration<double>(steady_clock::now() - start).count();
+
+	printf("%d snapshots\n", SNAPSHOTS);
+	printf("  %.1f ns per snapshot, %.0fs accounted as thermal\n", elapsed * 1e9 / SNAPSHOTS, analyzer.GetTotals(Reason::THERMAL).time);
+}
+
+int main()
+{
+	CheckBehavior();
+	MeasureAdd();
+
+	if (s_failures) {
+		printf("FAILED: %d check(s) of the throttle analyzer were off\n", s_failures);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,160 @@
+// Cost of building and rendering the frames of the main window
+//
+// The overview and the details of the first GPU are built the way the window
+// builds them, from simulated GPUs whose histories hold a full chart window of
+// synthetic samples, and rendered in memory with nuklear_raster.h. Both are
+// measured for 1, 8 and 64 GPUs at the default window size and at 1920x1080.
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm> // std::max
+#include <vector>    // std::vector
+
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_STANDARD_IO
+#define NK_INCLUDE_STANDARD_VARARGS
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_IMPLEMENTATION
+#define NK_PRIVATE
+#include "../src/nuklear.h"
+
+#define NK_RASTER_IMPLEMENTATION
+#include "../src/nuklear_raster.h"
+
+#include "../src/ui.h"
+
+static constexpr int FRAMES = 200;
+static constexpr double SAMPLE_INTERVAL = 0.1;
+
+struct Size {
+	unsigned int width;
+	unsigned int height;
+};
+
+static const Size kSizes[] = { { 650, 400 }, { 1920, 1080 } };
+static const std::size_t kCounts[] = { 1, 8, 64 };
+
+// Fills [history] with a chart window of samples moving around [snapshot]
+static void Fill(History &history, GPUView &view, const Snapshot &snapshot)
+{
+	Snapshot sample = snapshot;
+	const int samples = static_cast<int>(CHART_WINDOW / SAMPLE_INTERVAL);
+	for (int i = 0; i < samples; i++) {
+		const float wave = static_cast<float>(sin(i * 0.05));
+		sample.sequence = i + 1;
+		sample.time = i * SAMPLE_INTERVAL;
+		sample.values[static_cast<NV_U32>(Metric::TEMPERATURE_GPU)] = 60.0f + 15.0f * wave;
+		sample.values[static_cast<NV_U32>(Metric::CURRENT_CLOCK_CORE)] = 1500.0f + 300.0f * wave;
+		sample.values[static_cast<NV_U32>(Metric::CURRENT_CLOCK_MEMORY)] = 5000.0f + 2000.0f * (i % 50 < 25);
+		sample.values[static_cast<NV_U32>(Metric::USAGE_GPU)] = static_cast<float>(i * 7 % 100);
+		sample.values[static_cast<NV_U32>(Metric::FAN_LEVEL)] = 40.0f + 20.0f * wave;
+		history.Add(sample);
+	}
+	view.Update(sample);
+}
+
+struct Result {
+	double build;
+	double build_max;
+	double render;
+	double render_max;
+	std::size_t commands;
+};
+
+static Result Measure(struct nk_context *ctx, const Size &size, const std::vector<GPU*> &gpus, const std::vector<History> &histories, const std::vector<GPUView> &views, const Sampler &sampler)
+{
+	Result result = {};
+	const struct nk_rect bounds = nk_rect(0, 0, static_cast<float>(size.width), static_cast<float>(size.height));
+
+	// The first frames lay the window out and grow the command buffer
+	for (int frame = -10; frame < FRAMES; frame++) {
+		nk_input_begin(ctx);
+		nk_input_end(ctx);
+
+		const double start = MetricTime();
+		MainWindow(ctx, bounds, gpus, histories, views, sampler);
+		const double built = MetricTime();
+		const std::size_t commands = ctx->memory.allocated;
+		nk_raster_render(nk_rgb(45, 45, 45));
+		const double rendered = MetricTime();
+
+		if (frame >= 0) {
+			result.build += built - start;
+			result.build_max = std::max(result.build_max, built - start);
+			result.render += rendered - built;
+			result.render_max = std::max(result.render_max, rendered - built);
+			result.commands = commands;
+		}
+	}
+
+	result.build /= FRAMES;
+	result.render /= FRAMES;
+	return result;
+}
+
+int main()
+{
+	// Enough GPUs for the largest count unless set otherwise
+	setenv("NVFC_SIM_GPUS", "64", 0);
+	if (NvAPI_Initialize() != 0) {
+		printf("failed to initialize NvAPI\n");
+		return 1;
+	}
+
+	NV_PHYSICAL_GPU_HANDLE gpu_handles[64];
+	NV_S32 gpu_count = 0;
+	NV_DISPLAY_HANDLE display_handle;
+	if (NvAPI_EnumPhysicalGPUs(gpu_handles, &gpu_count) != 0 || gpu_count == 0 || NvAPI_EnumDisplayHandle(0, &display_handle) != 0) {
+		printf("no GPUs\n");
+		return 1;
+	}
+
+	std::vector<GPU*> all;
+	for (NV_S32 i = 0; i < gpu_count; i++) {
+		all.push_back(new GPU(i, gpu_handles[i], display_handle));
+	}
+
+	struct nk_context *ctx = nk_raster_init(kSizes[0].width, kSizes[0].height);
+
+	printf("%d frames each, times in ms per frame\n", FRAMES);
+	printf("  %4s %10s %-9s %15s %15s %10s\n", "GPUs", "window", "panel", "build mean/max", "render mean/max", "commands");
+
+	for (const std::size_t count : kCounts) {
+		if (count > all.size()) {
+			continue;
+		}
+
+		const std::vector<GPU*> gpus(all.begin(), all.begin() + count);
+		Sampler sampler({ SAMPLE_INTERVAL, SAMPLE_INTERVAL, {} });
+		for (GPU *gpu : gpus) {
+			sampler.Add(gpu);
+		}
+		sampler.Poll(MetricTime());
+		NameTabs(count);
+
+		std::vector<History> histories(count);
+		std::vector<GPUView> views(count);
+		for (std::size_t i = 0; i < count; i++) {
+			Fill(histories[i], views[i], sampler.GetSnapshot(i));
+		}
+
+		for (const auto &size : kSizes) {
+			nk_raster_resize(size.width, size.height);
+			for (const int tab : { -1, 0 }) {
+				g_tab = tab;
+				const Result result = Measure(ctx, size, gpus, histories, views, sampler);
+				printf("  %4zu %5ux%-4u %-9s %7.3f %7.3f %7.3f %7.3f %8.1fK\n", count, size.width, size.height,
+					tab < 0 ? "overview" : "details",
+					result.build * 1e3, result.build_max * 1e3,
+					result.render * 1e3, result.render_max * 1e3,
+					result.commands / 1024.0);
+			}
+		}
+	}
+
+	nk_raster_shutdown();
+	for (GPU *gpu : all) {
+		delete gpu;
+	}
+	return 0;
+}
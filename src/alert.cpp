@@ -0,0 +1,150 @@
+#include "alert.h"
+#include "log.h"
+
+std::size_t AlertEngine::AddRule(const Rule &rule)
+{
+	m_rules.push_back(rule);
+	return m_rules.size() - 1;
+}
+
+void AlertEngine::AddSink(Sink sink)
+{
+	m_sinks.push_back(std::move(sink));
+}
+
+void AlertEngine::Compile(std::size_t gpu_count)
+{
+	m_compiled.clear();
+	m_ranges.clear();
+
+	// Rules are laid out grouped by GPU so evaluating one snapshot is a linear walk
+	for (std::size_t gpu = 0; gpu < gpu_count; gpu++) {
+		const std::size_t begin = m_compiled.size();
+		for (std::size_t i = 0; i < m_rules.size(); i++) {
+			const auto &rule = m_rules[i];
+			if (rule.gpu >= 0 && static_cast<std::size_t>(rule.gpu) != gpu) {
+				continue;
+			}
+			m_compiled.push_back({
+				static_cast<NV_U32>(rule.metric),
+				static_cast<NV_U32>(rule.reference),
+				rule.kind,
+				rule.comparison,
+				rule.threshold,
+				rule.duration,
+				i
+			});
+		}
+		m_ranges.push_back({ begin, m_compiled.size() });
+	}
+
+	m_states.assign(m_compiled.size(), State {});
+
+	// Every rule emits at most one event per evaluation
+	m_events.clear();
+	m_events.reserve(m_compiled.size());
+}
+
+void AlertEngine::Evaluate(std::size_t gpu, const Snapshot &snapshot)
+{
+	if (gpu >= m_ranges.size()) {
+		return;
+	}
+
+	const auto range = m_ranges[gpu];
+	for (std::size_t i = range.begin; i < range.end; i++) {
+		const auto &compiled = m_compiled[i];
+		auto &state = m_states[i];
+
+		// A rule firing on a metric which went missing would otherwise never clear
+		auto unavailable = [&] {
+			state.pending = false;
+			state.has_previous = false;
+			if (state.active) {
+				state.active = false;
+				m_events.push_back({ compiled.rule, gpu, false, false, 0.0f, snapshot.time });
+			}
+		};
+
+		if (!(snapshot.present & (MetricSet(1) << compiled.metric))) {
+			unavailable();
+			continue;
+		}
+
+		const float value = snapshot.values[compiled.metric];
+		float observed = value;
+		switch (compiled.kind) {
+		case Kind::VALUE:
+			break;
+		case Kind::RATE: {
+			const bool has_previous = state.has_previous;
+			const double elapsed = snapshot.time - state.previous_time;
+			const float previous = state.previous;
+			state.has_previous = true;
+			state.previous = value;
+			state.previous_time = snapshot.time;
+			if (!has_previous || elapsed <= 0.0) {
+				continue;
+			}
+			observed = static_cast<float>((value - previous) / elapsed);
+		} break;
+		case Kind::RATIO: {
+			const float reference = snapshot.values[compiled.reference];
+			if (!(snapshot.present & (MetricSet(1) << compiled.reference))) {
+				unavailable();
+				continue;
+			}
+			if (reference == 0.0f) {
+				continue;
+			}
+			observed = value / reference;
+		} break;
+		}
+
+		const bool condition = compiled.comparison == Comparison::ABOVE
+			? observed > compiled.threshold
+			: observed < compiled.threshold;
+
+		if (condition) {
+			if (!state.pending) {
+				state.pending = true;
+				state.since = snapshot.time;
+			}
+			if (!state.active && snapshot.time - state.since >= compiled.duration) {
+				state.active = true;
+				m_events.push_back({ compiled.rule, gpu, true, true, observed, snapshot.time });
+			}
+		} else {
+			state.pending = false;
+			if (state.active) {
+				state.active = false;
+				m_events.push_back({ compiled.rule, gpu, false, true, observed, snapshot.time });
+			}
+		}
+	}
+
+	for (const auto &event : m_events) {
+		for (const auto &sink : m_sinks) {
+			sink(*this, event);
+		}
+	}
+	m_events.clear();
+}
+
+void AlertEngine::LogSink(const AlertEngine &engine, const Event &event)
+{
+	const auto &rule = engine.GetRule(event.rule);
+	if (!event.available) {
+		Log::write("alert '%s' cleared on GPU %zu (%s unavailable)",
+			rule.name.c_str(),
+			event.gpu,
+			MetricName(rule.metric));
+		return;
+	}
+	Log::write("alert '%s' %s on GPU %zu (%s: %.2f)",
+		rule.name.c_str(),
+		event.active ? "raised" : "cleared",
+		event.gpu,
+		MetricName(rule.metric),
+		event.value);
+}
@@ -0,0 +1,103 @@
+#ifndef ALERT_H
+#define ALERT_H
+#include <functional> // std::function
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+#include "metric.h"
+
+// Evaluates alert rules against every new snapshot of a GPU
+//
+// Rules are added up front and compiled into flat per-GPU arrays, evaluation
+// then walks the rules of one GPU without allocating. Events are edge triggered,
+// one event is emitted when a rule starts firing and one when it stops, either
+// because its condition no longer holds or because a metric it compares went
+// missing from the snapshot.
+class AlertEngine {
+public:
+	enum class Kind {
+		VALUE, // the metric itself
+		RATE,  // change of the metric per second
+		RATIO  // the metric divided by the reference metric
+	};
+
+	enum class Comparison {
+		ABOVE,
+		BELOW
+	};
+
+	struct Rule {
+		std::string name;
+		Metric metric;
+		Kind kind;
+		Comparison comparison;
+		float threshold;
+		float duration;      // seconds the condition has to hold before the rule fires
+		Metric reference;    // only used by Kind::RATIO
+		int gpu;             // index of the GPU this rule applies to, -1 for all
+	};
+
+	struct Event {
+		std::size_t rule;    // index returned by AddRule
+		std::size_t gpu;
+		bool active;         // true when the rule started firing, false when it stopped
+		bool available;      // false when the rule stopped because its metrics went missing
+		float value;         // the value which was compared against the threshold, 0 when not available
+		double time;
+	};
+
+	using Sink = std::function<void(const AlertEngine &, const Event &)>;
+
+	std::size_t AddRule(const Rule &rule);
+	void AddSink(Sink sink);
+
+	// Expands all rules for [gpu_count] GPUs, has to be called after adding
+	// rules and before evaluating, resets the state of every rule
+	void Compile(std::size_t gpu_count);
+
+	void Evaluate(std::size_t gpu, const Snapshot &snapshot);
+
+	const Rule &GetRule(std::size_t rule) const;
+
+	// Sink writing every event to the log
+	static void LogSink(const AlertEngine &engine, const Event &event);
+
+private:
+	struct Compiled {
+		NV_U32 metric;
+		NV_U32 reference;
+		Kind kind;
+		Comparison comparison;
+		float threshold;
+		float duration;
+		std::size_t rule;
+	};
+
+	struct State {
+		bool pending;        // the condition holds but not for long enough yet
+		bool active;
+		bool has_previous;
+		float previous;
+		double previous_time;
+		double since;
+	};
+
+	struct Range {
+		std::size_t begin;
+		std::size_t end;
+	};
+
+	std::vector<Rule> m_rules;
+	std::vector<Sink> m_sinks;
+	std::vector<Compiled> m_compiled;
+	std::vector<State> m_states;
+	std::vector<Range> m_ranges;
+	std::vector<Event> m_events;
+};
+
+inline const AlertEngine::Rule &AlertEngine::GetRule(std::size_t rule) const
+{
+	return m_rules[rule];
+}
+
+#endif
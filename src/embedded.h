@@ -0,0 +1,307 @@
+#ifndef EMBEDDED_H
+#define EMBEDDED_H
+#include <stdint.h>
+
+#include "nvapi.h"
+#include "metric.h"
+#include "load.h"
+
+// Storage for one NvAPI structure, empty when the structure is never loaded
+template<bool ENABLED, typename T>
+struct EmbeddedSlot {
+	T value;
+};
+
+template<typename T>
+struct EmbeddedSlot<false, T> {
+};
+
+// GPU reading a set of metrics fixed at compile time
+//
+// Meant for embedding NVFC where the metrics are known up front, a game watching
+// its GPU temperature and core clock for instance. Only the NvAPI structures
+// needed by METRICS are stored, only their driver calls are issued and only the
+// metrics in METRICS are decoded, everything else is compiled out. The GPU class
+// stays the one to use when the metrics change at runtime.
+//
+//   EmbeddedGPU<MetricBit(Metric::TEMPERATURE_GPU) | MetricBit(Metric::CURRENT_CLOCK_CORE)> gpu(physical, display);
+template<MetricSet METRICS>
+class EmbeddedGPU {
+public:
+	static_assert(METRICS != 0 && (METRICS & ~ALL_METRICS) == 0, "METRICS must name at least one metric");
+
+	// Every NvAPI structure needed by METRICS
+	static constexpr NV_U32 LOADS = GetLoadsForMetrics(METRICS);
+
+	EmbeddedGPU(NV_PHYSICAL_GPU_HANDLE physical_gpu_handle, NV_DISPLAY_HANDLE display_handle);
+
+	// Issues the driver calls needed by METRICS, returns false when one of them failed
+	bool Update();
+
+	// Decodes METRICS from the last Update into [snapshot], bumping its sequence and
+	// stamping it with the current time
+	void GetSnapshot(Snapshot &snapshot) const;
+
+	// Number of driver calls issued by Update so far
+	uint64_t GetDriverCalls() const;
+
+private:
+	static constexpr bool Needs(NV_U32 loads);
+	static constexpr bool Wants(Metric metric);
+
+	bool Loaded(NV_U32 load, NV_STATUS status);
+
+	NV_PHYSICAL_GPU_HANDLE m_physical_gpu_handle;
+	NV_DISPLAY_HANDLE m_display_handle;
+	NV_U32 m_loaded;
+	uint64_t m_driver_calls;
+
+	EmbeddedSlot<Needs(LOAD_CURRENT_FREQUENCIES), NV_CLOCK_FREQUENCIES_V2> m_current_frequencies;
+	EmbeddedSlot<Needs(LOAD_BASE_FREQUENCIES), NV_CLOCK_FREQUENCIES_V2> m_base_frequencies;
+	EmbeddedSlot<Needs(LOAD_BOOST_FREQUENCIES), NV_CLOCK_FREQUENCIES_V2> m_boost_frequencies;
+	EmbeddedSlot<Needs(LOAD_DYNAMIC_PSTATES), NV_DYNAMIC_PSTATES_V1> m_dynamic_pstates;
+	EmbeddedSlot<Needs(LOAD_POWER_POLICIES_INFO), NV_GPU_POWER_POLICIES_INFO_V1> m_power_policies_info;
+	EmbeddedSlot<Needs(LOAD_POWER_POLICIES_STATUS), NV_GPU_POWER_POLICIES_STATUS_V1> m_power_policies_status;
+	EmbeddedSlot<Needs(LOAD_POWER_TOPOLOGY_STATUS), NV_GPU_POWER_TOPOLOGY_STATUS_V1> m_power_topology_status;
+	EmbeddedSlot<Needs(LOAD_VOLTAGE_DOMAINS_STATUS), NV_GPU_VOLTAGE_DOMAINS_STATUS_V1> m_voltage_domain_status;
+	EmbeddedSlot<Needs(LOAD_THERMAL_SETTINGS), NV_GPU_THERMAL_SETTINGS_V2> m_thermal_settings;
+	EmbeddedSlot<Needs(LOAD_THERMAL_POLICIES_INFO), NV_GPU_THERMAL_POLICIES_INFO_V2> m_thermal_policies_info;
+	EmbeddedSlot<Needs(LOAD_THERMAL_POLICIES_STATUS), NV_GPU_THERMAL_POLICIES_STATUS_V2> m_thermal_policies_status;
+	EmbeddedSlot<Needs(LOAD_COOLER_SETTINGS), NV_GPU_COOLER_SETTINGS_V2> m_cooler_settings;
+	EmbeddedSlot<Needs(LOAD_MEMORY_INFO), NV_MEMORY_INFO_V2> m_memory_info;
+};
+
+template<MetricSet METRICS>
+constexpr bool EmbeddedGPU<METRICS>::Needs(NV_U32 loads)
+{
+	return (GetLoadsForMetrics(METRICS) & loads) == loads;
+}
+
+template<MetricSet METRICS>
+constexpr bool EmbeddedGPU<METRICS>::Wants(Metric metric)
+{
+	return (METRICS & MetricBit(metric)) != 0;
+}
+
+template<MetricSet METRICS>
+EmbeddedGPU<METRICS>::EmbeddedGPU(NV_PHYSICAL_GPU_HANDLE physical_gpu_handle, NV_DISPLAY_HANDLE display_handle)
+	: m_physical_gpu_handle { physical_gpu_handle }
+	, m_display_handle      { display_handle }
+	, m_loaded              { 0 }
+	, m_driver_calls        { 0 }
+{
+}
+
+template<MetricSet METRICS>
+bool EmbeddedGPU<METRICS>::Loaded(NV_U32 load, NV_STATUS status)
+{
+	m_driver_calls++;
+	if (status == 0) {
+		m_loaded |= load;
+	}
+	return status == 0 || (load & LOAD_OPTIONAL) != 0;
+}
+
+template<MetricSet METRICS>
+bool EmbeddedGPU<METRICS>::Update()
+{
+	m_loaded = 0;
+
+	bool status = true;
+	if constexpr (Needs(LOAD_CURRENT_FREQUENCIES)) {
+		status &= Loaded(LOAD_CURRENT_FREQUENCIES, LoadClockFrequencies(m_physical_gpu_handle, &m_current_frequencies.value, NV_CLOCK_FREQUENCY_TYPE::CURRENT));
+	}
+	if constexpr (Needs(LOAD_BASE_FREQUENCIES)) {
+		status &= Loaded(LOAD_BASE_FREQUENCIES, LoadClockFrequencies(m_physical_gpu_handle, &m_base_frequencies.value, NV_CLOCK_FREQUENCY_TYPE::BASE));
+	}
+	if constexpr (Needs(LOAD_BOOST_FREQUENCIES)) {
+		status &= Loaded(LOAD_BOOST_FREQUENCIES, LoadClockFrequencies(m_physical_gpu_handle, &m_boost_frequencies.value, NV_CLOCK_FREQUENCY_TYPE::BOOST));
+	}
+	if constexpr (Needs(LOAD_DYNAMIC_PSTATES)) {
+		status &= Loaded(LOAD_DYNAMIC_PSTATES, LoadGPUDynamicPStates(m_physical_gpu_handle, &m_dynamic_pstates.value));
+	}
+	if constexpr (Needs(LOAD_POWER_POLICIES_INFO)) {
+		status &= Loaded(LOAD_POWER_POLICIES_INFO, LoadGPUPowerPoliciesInfo(m_physical_gpu_handle, &m_power_policies_info.value));
+	}
+	if constexpr (Needs(LOAD_POWER_POLICIES_STATUS)) {
+		status &= Loaded(LOAD_POWER_POLICIES_STATUS, LoadGPUPowerPoliciesStatus(m_physical_gpu_handle, &m_power_policies_status.value));
+	}
+	if constexpr (Needs(LOAD_POWER_TOPOLOGY_STATUS)) {
+		status &= Loaded(LOAD_POWER_TOPOLOGY_STATUS, LoadGPUPowerTopologyStatus(m_physical_gpu_handle, &m_power_topology_status.value));
+	}
+	if constexpr (Needs(LOAD_VOLTAGE_DOMAINS_STATUS)) {
+		status &= Loaded(LOAD_VOLTAGE_DOMAINS_STATUS, LoadGPUVoltageDomainsStatus(m_physical_gpu_handle, &m_voltage_domain_status.value));
+	}
+	if constexpr (Needs(LOAD_THERMAL_SETTINGS)) {
+		status &= Loaded(LOAD_THERMAL_SETTINGS, LoadGPUThermalSettingsV2(m_physical_gpu_handle, &m_thermal_settings.value));
+	}
+	if constexpr (Needs(LOAD_THERMAL_POLICIES_INFO)) {
+		status &= Loaded(LOAD_THERMAL_POLICIES_INFO, LoadGPUThermalPoliciesInfoV2(m_physical_gpu_handle, &m_thermal_policies_info.value));
+	}
+	if constexpr (Needs(LOAD_THERMAL_POLICIES_STATUS)) {
+		status &= Loaded(LOAD_THERMAL_POLICIES_STATUS, LoadGPUThermalPoliciesStatusV2(m_physical_gpu_handle, &m_thermal_policies_status.value));
+	}
+	if constexpr (Needs(LOAD_COOLER_SETTINGS)) {
+		status &= Loaded(LOAD_COOLER_SETTINGS, LoadGPUCoolerSettingsV2(m_physical_gpu_handle, 0, &m_cooler_settings.value));
+	}
+	if constexpr (Needs(LOAD_MEMORY_INFO)) {
+		status &= Loaded(LOAD_MEMORY_INFO, NvAPI_GetMemoryInfo(m_display_handle, &m_memory_info.value));
+	}
+	return status;
+}
+
+template<MetricSet METRICS>
+void EmbeddedGPU<METRICS>::GetSnapshot(Snapshot &snapshot) const
+{
+	snapshot.sequence++;
+	snapshot.time = MetricTime();
+	snapshot.present = 0;
+
+	// Wants is a constant for every metric, so the optimizer drops the metrics
+	// not asked for within a structure which is loaded
+	auto store = [&](Metric metric, float value) {
+		if (Wants(metric)) {
+			snapshot.values[static_cast<NV_U32>(metric)] = value;
+			snapshot.present |= MetricBit(metric);
+		}
+	};
+
+	if constexpr (Needs(LOAD_THERMAL_SETTINGS)) {
+		if (m_loaded & LOAD_THERMAL_SETTINGS) {
+			const auto &settings = m_thermal_settings.value;
+			auto temperature = [&](Metric metric, NV_THERMAL_TARGET target) {
+				for (NV_U32 i = 0; i < settings.count; i++) {
+					if (settings.sensor[i].target == target) {
+						store(metric, static_cast<float>(settings.sensor[i].current_temperature));
+						return;
+					}
+				}
+			};
+			if constexpr (Wants(Metric::TEMPERATURE_GPU)) {
+				temperature(Metric::TEMPERATURE_GPU, NV_THERMAL_TARGET::GPU);
+			}
+			if constexpr (Wants(Metric::TEMPERATURE_MEMORY)) {
+				temperature(Metric::TEMPERATURE_MEMORY, NV_THERMAL_TARGET::MEMORY);
+			}
+			if constexpr (Wants(Metric::TEMPERATURE_POWER_SUPPLY)) {
+				temperature(Metric::TEMPERATURE_POWER_SUPPLY, NV_THERMAL_TARGET::POWER_SUPPLY);
+			}
+			if constexpr (Wants(Metric::TEMPERATURE_BOARD)) {
+				temperature(Metric::TEMPERATURE_BOARD, NV_THERMAL_TARGET::BOARD);
+			}
+		}
+	}
+
+	if constexpr (Needs(LOAD_VOLTAGE_DOMAINS_STATUS)) {
+		if (m_loaded & LOAD_VOLTAGE_DOMAINS_STATUS) {
+			const auto &status = m_voltage_domain_status.value;
+			for (NV_U32 i = 0; i < status.count; i++) {
+				if (status.entries[i].voltage_domain == 0) {
+					store(Metric::VOLTAGE, status.entries[i].current_voltage / 1'000'000.0f);
+					break;
+				}
+			}
+		}
+	}
+
+	auto clocks = [&](NV_U32 load, const NV_CLOCK_FREQUENCIES_V2 &frequencies, Metric core, Metric memory, Metric shader) {
+		if (m_loaded & load) {
+			auto clock = [&](Metric metric, NV_CLOCK_SYSTEM system) {
+				const auto &entry = frequencies.entries[static_cast<std::size_t>(system)];
+				if (entry.present) {
+					store(metric, entry.frequency / 1000.0f);
+				}
+			};
+			clock(core, NV_CLOCK_SYSTEM::GPU);
+			clock(memory, NV_CLOCK_SYSTEM::MEMORY);
+			clock(shader, NV_CLOCK_SYSTEM::SHADER);
+		}
+	};
+	if constexpr (Needs(LOAD_CURRENT_FREQUENCIES)) {
+		clocks(LOAD_CURRENT_FREQUENCIES, m_current_frequencies.value, Metric::CURRENT_CLOCK_CORE, Metric::CURRENT_CLOCK_MEMORY, Metric::CURRENT_CLOCK_SHADER);
+	}
+	if constexpr (Needs(LOAD_BASE_FREQUENCIES)) {
+		clocks(LOAD_BASE_FREQUENCIES, m_base_frequencies.value, Metric::BASE_CLOCK_CORE, Metric::BASE_CLOCK_MEMORY, Metric::BASE_CLOCK_SHADER);
+	}
+	if constexpr (Needs(LOAD_BOOST_FREQUENCIES)) {
+		clocks(LOAD_BOOST_FREQUENCIES, m_boost_frequencies.value, Metric::BOOST_CLOCK_CORE, Metric::BOOST_CLOCK_MEMORY, Metric::BOOST_CLOCK_SHADER);
+	}
+
+	if constexpr (Needs(LOAD_DYNAMIC_PSTATES)) {
+		if (m_loaded & LOAD_DYNAMIC_PSTATES) {
+			auto usage = [&](Metric metric, NV_DYNAMIC_PSTATES_SYSTEM system) {
+				const auto &state = m_dynamic_pstates.value.pstates[static_cast<std::size_t>(system)];
+				if (state.present) {
+					store(metric, static_cast<float>(state.value));
+				}
+			};
+			usage(Metric::USAGE_GPU, NV_DYNAMIC_PSTATES_SYSTEM::GPU);
+			usage(Metric::USAGE_FB, NV_DYNAMIC_PSTATES_SYSTEM::FB);
+			usage(Metric::USAGE_VID, NV_DYNAMIC_PSTATES_SYSTEM::VID);
+			usage(Metric::USAGE_BUS, NV_DYNAMIC_PSTATES_SYSTEM::BUS);
+		}
+	}
+
+	if constexpr (Needs(LOAD_MEMORY_INFO)) {
+		if (m_loaded & LOAD_MEMORY_INFO) {
+			const auto total_memory = m_memory_info.value.values[0];
+			const auto free_memory = m_memory_info.value.values[4];
+			store(Metric::MEMORY_TOTAL, static_cast<float>(total_memory) / 1024.0f);
+			store(Metric::MEMORY_FREE, static_cast<float>(free_memory) / 1024.0f);
+			store(Metric::MEMORY_USED, static_cast<float>(total_memory - free_memory) / 1024.0f);
+		}
+	}
+
+	if constexpr (Needs(LOAD_POWER_TOPOLOGY_STATUS)) {
+		if (m_loaded & LOAD_POWER_TOPOLOGY_STATUS) {
+			const auto &status = m_power_topology_status.value;
+			for (NV_U32 i = 0; i < status.count; i++) {
+				if (status.entries[i].domain == 0) {
+					store(Metric::POWER_USAGE, status.entries[i].power / 1000.0f);
+					break;
+				}
+			}
+		}
+	}
+
+	if constexpr (Wants(Metric::POWER_LIMIT)) {
+		if ((m_loaded & (LOAD_POWER_POLICIES_INFO | LOAD_POWER_POLICIES_STATUS)) == (LOAD_POWER_POLICIES_INFO | LOAD_POWER_POLICIES_STATUS)) {
+			const auto &status = m_power_policies_status.value;
+			for (NV_U32 i = 0; i < status.count; i++) {
+				if (status.entries[i].pstate == 0) {
+					store(Metric::POWER_LIMIT, status.entries[i].power / 1000.0f);
+					break;
+				}
+			}
+		}
+	}
+
+	if constexpr (Wants(Metric::THERMAL_LIMIT)) {
+		if ((m_loaded & (LOAD_THERMAL_POLICIES_INFO | LOAD_THERMAL_POLICIES_STATUS)) == (LOAD_THERMAL_POLICIES_INFO | LOAD_THERMAL_POLICIES_STATUS)) {
+			const auto &status = m_thermal_policies_status.value;
+			for (NV_U32 i = 0; i < status.count; i++) {
+				// Limits the driver does not let us change are not reported, like GPU::GetThermalLimit
+				if (static_cast<NV_THERMAL_CONTROLLER>(status.entries[i].controller) == NV_THERMAL_CONTROLLER::GPU_INTERNAL) {
+					if (m_thermal_policies_info.value.entries[i].max > 0) {
+						store(Metric::THERMAL_LIMIT, status.entries[i].value / 256.0f);
+					}
+					break;
+				}
+			}
+		}
+	}
+
+	if constexpr (Needs(LOAD_COOLER_SETTINGS)) {
+		if ((m_loaded & LOAD_COOLER_SETTINGS) && m_cooler_settings.value.count > 0) {
+			store(Metric::FAN_LEVEL, static_cast<float>(m_cooler_settings.value.coolers[0].current_level));
+		}
+	}
+}
+
+template<MetricSet METRICS>
+inline uint64_t EmbeddedGPU<METRICS>::GetDriverCalls() const
+{
+	return m_driver_calls;
+}
+
+#endif
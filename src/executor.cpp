@@ -0,0 +1,211 @@
+#include <algorithm> // std::max
+
+#include "executor.h"
+#include "metric.h"
+
+// Latency window, enough to cover a few seconds of a busy queue
+static constexpr uint32_t kLatencyWindow = 4096;
+
+// Executor whose requests the current thread runs, if any
+static thread_local const DriverExecutor *s_running = nullptr;
+
+double DriverExecutor::Stats::GetCoalescingRatio() const
+{
+	return reads ? static_cast<double>(coalesced) / reads : 0.0;
+}
+
+void DriverExecutor::Request::Adopt(Request &)
+{
+	// Only reads are ever coalesced
+}
+
+DriverExecutor::DriverExecutor()
+	: m_head       { nullptr }
+	, m_depth      { 0 }
+	, m_peak_depth { 0 }
+	, m_submitted  { 0 }
+	, m_reads      { 0 }
+	, m_sleeping   { false }
+	, m_stopping   { false }
+	, m_global_generation { 0 }
+	, m_running    { nullptr }
+	, m_stats      { 0, 0, 0, 0, 0, 0, 0, Histogram(kLatencyWindow) }
+{
+	m_thread = std::thread(&DriverExecutor::Run, this);
+}
+
+DriverExecutor::~DriverExecutor()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_ready.notify_one();
+	m_thread.join();
+}
+
+void DriverExecutor::Push(Request *request)
+{
+	request->submitted = MetricTime();
+
+	m_submitted++;
+	if (request->read) {
+		m_reads++;
+	}
+	const std::size_t depth = ++m_depth;
+	std::size_t peak = m_peak_depth.load();
+	while (depth > peak && !m_peak_depth.compare_exchange_weak(peak, depth)) {
+	}
+
+	request->followers = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(m_generation_mutex);
+		if (!request->read) {
+			if (request->object) {
+				m_generations[request->object]++;
+			} else {
+				m_global_generation++;
+			}
+		} else {
+			const auto generation = m_generations.find(request->object);
+			request->generation = m_global_generation + (generation != m_generations.end() ? generation->second : 0);
+
+			// An identical read of the same generation is running, its result is as fresh as ours would be
+			if (m_running && m_running->object == request->object && m_running->operation == request->operation
+				&& m_running->generation == request->generation) {
+				request->next = m_running->followers;
+				m_running->followers = request;
+				return;
+			}
+		}
+	}
+
+	request->next = m_head.load();
+	while (!m_head.compare_exchange_weak(request->next, request)) {
+	}
+
+	// Only a sleeping driver thread needs the lock, it checks the stack after
+	// announcing it sleeps so either it sees this request or we see it sleeping
+	if (m_sleeping.load()) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_ready.notify_one();
+	}
+}
+
+void DriverExecutor::Run()
+{
+	s_running = this;
+	for (;;) {
+		Request *batch = m_head.exchange(nullptr);
+		if (!batch) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_sleeping.store(true);
+			m_ready.wait(lock, [this] { return m_stopping || m_head.load() != nullptr; });
+			m_sleeping.store(false);
+			if (m_head.load() == nullptr) {
+				return;
+			}
+			continue;
+		}
+
+		// The stack holds the newest request first
+		Request *oldest = nullptr;
+		while (batch) {
+			Request *next = batch->next;
+			batch->next = oldest;
+			oldest = batch;
+			batch = next;
+		}
+		Execute(oldest);
+	}
+}
+
+void DriverExecutor::Execute(Request *batch)
+{
+	// The stats lock is only taken between driver calls, so reading the stats never waits on the driver
+	uint64_t coalesced = 0;
+	m_leaders.clear();
+	for (Request *request = batch; request; request = request->next) {
+		if (!request->read) {
+			request->Run();
+		} else {
+			auto leader = std::find_if(m_leaders.begin(), m_leaders.end(), [&](const Request *other) {
+				return other->object == request->object && other->operation == request->operation
+					&& other->generation == request->generation;
+			});
+			if (leader != m_leaders.end()) {
+				request->Adopt(**leader);
+				coalesced++;
+			} else {
+				{
+					std::lock_guard<std::mutex> lock(m_generation_mutex);
+					m_running = request;
+				}
+				request->Run();
+
+				Request *followers;
+				{
+					std::lock_guard<std::mutex> lock(m_generation_mutex);
+					m_running = nullptr;
+					followers = request->followers;
+				}
+				while (followers) {
+					Request *next = followers->next;
+					followers->Adopt(*request);
+					Complete(followers);
+					delete followers;
+					coalesced++;
+					followers = next;
+				}
+				m_leaders.push_back(request);
+			}
+		}
+		Complete(request);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_stats_mutex);
+		m_stats.coalesced += coalesced;
+		m_stats.batches++;
+	}
+
+	// Leaders are only released once nothing can adopt their result any more
+	while (batch) {
+		Request *next = batch->next;
+		delete batch;
+		batch = next;
+	}
+}
+
+void DriverExecutor::Complete(Request *request)
+{
+	const double latency = MetricTime() - request->submitted;
+	{
+		std::lock_guard<std::mutex> lock(m_stats_mutex);
+		m_stats.latency.Record(latency);
+		m_stats.completed++;
+	}
+	m_depth--;
+}
+
+bool DriverExecutor::IsDriverThread() const
+{
+	return s_running == this;
+}
+
+DriverExecutor::Stats DriverExecutor::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_stats_mutex);
+	Stats stats = m_stats;
+	stats.submitted = m_submitted.load();
+	stats.reads = m_reads.load();
+	stats.depth = m_depth.load();
+	stats.peak_depth = m_peak_depth.load();
+	return stats;
+}
+
+DriverExecutor &DriverExecutor::Get()
+{
+	static DriverExecutor executor;
+	return executor;
+}
@@ -0,0 +1,229 @@
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+#include <stdint.h>
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <exception>          // std::exception_ptr, std::current_exception
+#include <functional>         // std::function
+#include <future>             // std::future, std::promise, std::packaged_task
+#include <mutex>              // std::mutex
+#include <thread>             // std::thread
+#include <type_traits>        // std::is_void
+#include <unordered_map>      // std::unordered_map
+#include <utility>            // std::move
+#include <vector>             // std::vector
+
+#include "timing.h"
+
+// Runs driver calls on one dedicated thread
+//
+// Submit queues a function and hands back a future for its result, so a caller
+// can keep driver round trips in flight while it does other work and collect
+// the results later. Functions run one at a time in submission order, which
+// also keeps the driver from being entered by two threads at once.
+//
+// Requests are pushed onto a lock free stack, the driver thread takes the whole
+// stack at once and runs it oldest first. Reads submitted with SubmitRead which
+// name the same object and operation are coalesced: a read submitted while an
+// identical one is running is answered with its result without being queued,
+// and of identical reads queued in one batch only the first runs. Every write,
+// anything submitted with Submit, starts a new generation of the object it
+// writes, or of every object when it names none. Reads only share a result
+// within a generation, so no read is answered with a result from before a write
+// submitted ahead of it, while reads of other objects keep coalescing.
+class DriverExecutor {
+public:
+	struct Stats {
+		uint64_t submitted;
+		uint64_t completed;
+		uint64_t reads;          // submitted with SubmitRead
+		uint64_t coalesced;      // reads answered without running, with the result of an identical read
+		uint64_t batches;        // times the driver thread took the queue
+		std::size_t depth;       // requests queued or running
+		std::size_t peak_depth;
+		Histogram latency;       // from submission to the result being ready
+
+		double GetCoalescingRatio() const;
+	};
+
+	DriverExecutor();
+
+	// Runs whatever is still queued, then stops the thread
+	~DriverExecutor();
+
+	template<typename Function>
+	auto Submit(Function function) -> std::future<decltype(function())>;
+
+	// Like Submit for a write which only changes [object]
+	template<typename Function>
+	auto Submit(const void *object, Function function) -> std::future<decltype(function())>;
+
+	// Like Submit but coalesced with identical reads, [object] and [operation] identify
+	// the read and every read sharing them has to return the same type
+	template<typename Function>
+	auto SubmitRead(const void *object, uint32_t operation, Function function) -> std::future<decltype(function())>;
+
+	// Requests queued or running
+	std::size_t GetPending() const;
+
+	// True on the thread running the requests
+	bool IsDriverThread() const;
+
+	Stats GetStats() const;
+
+	// Executor shared by the async methods of GPU
+	static DriverExecutor &Get();
+
+private:
+	struct Request {
+		virtual ~Request() = default;
+		virtual void Run() = 0;
+
+		// Completes with the result of [leader], a read of the same object and operation which ran
+		virtual void Adopt(Request &leader);
+
+		Request *next;
+		const void *object;
+		uint32_t operation;
+		bool read;
+		double submitted;
+		uint64_t generation;     // writes to the object submitted before this read
+		Request *followers;      // reads which joined this one while it was running
+	};
+
+	template<typename Result>
+	struct Task : Request {
+		Task(std::packaged_task<Result()> &&task);
+		void Run() override;
+
+		std::packaged_task<Result()> task;
+	};
+
+	template<typename Result>
+	struct Read : Request {
+		Read(std::function<Result()> &&function);
+		void Run() override;
+		void Adopt(Request &leader) override;
+
+		std::function<Result()> function;
+		std::promise<Result> promise;
+		Result result;
+		std::exception_ptr error;  // thrown by the function instead of a result
+	};
+
+	void Push(Request *request);
+	void Run();
+	void Execute(Request *batch);
+	void Complete(Request *request);
+
+	// Written by submitting threads
+	std::atomic<Request*> m_head;
+	std::atomic<std::size_t> m_depth;
+	std::atomic<std::size_t> m_peak_depth;
+	std::atomic<uint64_t> m_submitted;
+	std::atomic<uint64_t> m_reads;
+	std::atomic<bool> m_sleeping;
+	bool m_stopping;
+	std::mutex m_mutex;
+	std::condition_variable m_ready;
+
+	// Generations of the objects written and the read running on the driver thread, only
+	// touched for a moment when a request is pushed and around running a read
+	std::mutex m_generation_mutex;
+	std::unordered_map<const void*, uint64_t> m_generations;
+	uint64_t m_global_generation;
+	Request *m_running;
+
+	// Written by the driver thread
+	mutable std::mutex m_stats_mutex;
+	Stats m_stats;
+
+	// Reads of the current batch which ran, reused between batches
+	std::vector<Request*> m_leaders;
+
+	std::thread m_thread;
+};
+
+template<typename Result>
+DriverExecutor::Task<Result>::Task(std::packaged_task<Result()> &&task)
+	: task { std::move(task) }
+{
+}
+
+template<typename Result>
+void DriverExecutor::Task<Result>::Run()
+{
+	// The packaged task hands an exception to the future itself
+	task();
+}
+
+template<typename Result>
+DriverExecutor::Read<Result>::Read(std::function<Result()> &&function)
+	: function { std::move(function) }
+	, result   {}
+{
+}
+
+template<typename Result>
+void DriverExecutor::Read<Result>::Run()
+{
+	// An exception escaping would end the driver thread and leave every waiter hanging
+	try {
+		result = function();
+		promise.set_value(result);
+	} catch (...) {
+		error = std::current_exception();
+		promise.set_exception(error);
+	}
+}
+
+template<typename Result>
+void DriverExecutor::Read<Result>::Adopt(Request &leader)
+{
+	const auto &read = static_cast<Read<Result>&>(leader);
+	if (read.error) {
+		promise.set_exception(read.error);
+	} else {
+		promise.set_value(read.result);
+	}
+}
+
+template<typename Function>
+auto DriverExecutor::Submit(Function function) -> std::future<decltype(function())>
+{
+	return Submit(nullptr, std::move(function));
+}
+
+template<typename Function>
+auto DriverExecutor::Submit(const void *object, Function function) -> std::future<decltype(function())>
+{
+	using Result = decltype(function());
+	auto request = new Task<Result>(std::packaged_task<Result()>(std::move(function)));
+	request->object = object;
+	request->operation = 0;
+	request->read = false;
+	auto future = request->task.get_future();
+	Push(request);
+	return future;
+}
+
+template<typename Function>
+auto DriverExecutor::SubmitRead(const void *object, uint32_t operation, Function function) -> std::future<decltype(function())>
+{
+	using Result = decltype(function());
+	static_assert(!std::is_void<Result>::value, "a coalesced read has to return its result");
+	auto request = new Read<Result>(std::function<Result()>(std::move(function)));
+	request->object = object;
+	request->operation = operation;
+	request->read = true;
+	auto future = request->promise.get_future();
+	Push(request);
+	return future;
+}
+
+inline std::size_t DriverExecutor::GetPending() const
+{
+	return m_depth.load();
+}
+
+#endif
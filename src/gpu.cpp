@@ -1,176 +1,329 @@
-#include <sstream> // std::stringstream
-#include <iomanip> // std::setfill, std::setw
+#include <sstream>   // std::stringstream
+#include <iomanip>   // std::setfill, std::setw
+#include <algorithm> // std::clamp, std::min, std::max
+#include <tuple>     // std::tuple
+#include <cstdio>    // snprintf
+#include <cmath>     // std::exp2, std::isfinite
 
 #include "gpu.h"
-
-struct GPU::DataSet {
-	std::array<NV_CLOCK_FREQUENCIES_V2, static_cast<std::size_t>(NV_CLOCK_FREQUENCY_TYPE::LAST)> m_frequencies;
-	NV_DYNAMIC_PSTATES_V1 m_dynamic_pstates;
-	NV_GPU_PSTATES20_V2 m_pstates20;
-	NV_GPU_POWER_POLICIES_INFO_V1 m_power_policies_info;
-	NV_GPU_POWER_POLICIES_STATUS_V1 m_power_policies_status;
-	NV_GPU_VOLTAGE_DOMAINS_STATUS_V1 m_voltage_domain_status;
-	NV_GPU_THERMAL_SETTINGS_V2 m_thermal_settings;
-	NV_GPU_THERMAL_POLICIES_INFO_V2 m_thermal_policies_info;
-	NV_GPU_THERMAL_POLICIES_STATUS_V2 m_thermal_policies_status;
-	NV_GPU_COOLER_SETTINGS_V2 m_cooler_settings;
-	NV_MEMORY_INFO_V2 m_memory_info;
-};
-
-GPU::OverclockSetting::OverclockSetting() : OverclockSetting(0.0f, 0.0f, 0.0f, false)
+#include "load.h"
+#include "executor.h"
+#include "log.h"
+
+// Consecutive failures of a load before its retries are spaced out, doubling from
+// the first delay up to the last, in seconds
+static constexpr NV_U32 kBackoffAfter = 3;
+static constexpr double kBackoffFirst = 1.0;
+static constexpr double kBackoffLast = 60.0;
+
+// Position of [load] in the per load arrays
+static NV_U32 LoadIndex(NV_U32 load)
 {
+	NV_U32 index = 0;
+	while (!(load & 1)) {
+		load >>= 1;
+		index++;
+	}
+	return index;
 }
 
-GPU::OverclockSetting::OverclockSetting(float min, float current, float max, bool editable)
-	: editable      { editable }
-	, min_value     { min }
-	, current_value { current }
-	, max_value     { max }
+static const char *LoadName(NV_U32 load)
 {
+	switch (load) {
+	case LOAD_CURRENT_FREQUENCIES:
+		return "current frequencies";
+	case LOAD_BASE_FREQUENCIES:
+		return "base frequencies";
+	case LOAD_BOOST_FREQUENCIES:
+		return "boost frequencies";
+	case LOAD_DYNAMIC_PSTATES:
+		return "dynamic pstates";
+	case LOAD_PSTATES20:
+		return "pstates";
+	case LOAD_POWER_POLICIES_INFO:
+		return "power policies info";
+	case LOAD_POWER_POLICIES_STATUS:
+		return "power policies status";
+	case LOAD_POWER_TOPOLOGY_STATUS:
+		return "power topology status";
+	case LOAD_VOLTAGE_DOMAINS_STATUS:
+		return "voltage domains status";
+	case LOAD_THERMAL_SETTINGS:
+		return "thermal settings";
+	case LOAD_THERMAL_POLICIES_INFO:
+		return "thermal policies info";
+	case LOAD_THERMAL_POLICIES_STATUS:
+		return "thermal policies status";
+	case LOAD_COOLER_SETTINGS:
+		return "cooler settings";
+	case LOAD_MEMORY_INFO:
+		return "memory info";
+	}
+	return "unknown";
 }
 
-bool LoadClockFrequencies(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_CLOCK_FREQUENCIES_V2 *frequencies,
-	NV_CLOCK_FREQUENCY_TYPE type)
-{
-	*frequencies = {};
-	frequencies->clock_type = static_cast<NV_U32>(type);
-	return NvAPI_GPU_GetAllClockFrequencies(physical_gpu_handle, frequencies) == 0;
-}
+// Positions of the entries the getters read within the arrays of a data set
+//
+// Every new data set inherits the positions of the previous one, an array is only
+// searched again when its count changed or the entry at the known position no
+// longer is the one looked for, so the getters read straight from an index.
+struct IndexMap {
+	NV_S32 sensors[4];                   // GPU, memory, power supply and board sensor
+	NV_S32 voltage_domain;               // domain 0
+	NV_S32 power_topology;               // domain 0, the GPU itself
+	NV_S32 power_policy;                 // pstate 0
+	NV_S32 thermal_policy;               // internal thermal controller
+
+	// Counts the positions were resolved against, ~0 forces resolving
+	NV_U32 sensor_count;
+	NV_U32 voltage_domain_count;
+	NV_U32 power_topology_count;
+	NV_U32 power_policy_count;
+	NV_U32 thermal_policy_count;
+
+	IndexMap();
+};
 
-bool LoadGPUThermalSettingsV2(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_GPU_THERMAL_SETTINGS_V2 *thermal_settings)
+IndexMap::IndexMap()
+	: sensors              { -1, -1, -1, -1 }
+	, voltage_domain       { -1 }
+	, power_topology       { -1 }
+	, power_policy         { -1 }
+	, thermal_policy       { -1 }
+	, sensor_count         { ~0u }
+	, voltage_domain_count { ~0u }
+	, power_topology_count { ~0u }
+	, power_policy_count   { ~0u }
+	, thermal_policy_count { ~0u }
 {
-	*thermal_settings = {};
-	return NvAPI_GPU_GetThermalSettings(physical_gpu_handle, NV_THERMAL_TARGET::ALL, thermal_settings) == 0;
 }
 
-bool LoadGPUDynamicPStates(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_DYNAMIC_PSTATES_V1 *pstates)
+// Slot of [target] in IndexMap::sensors, -1 for targets without one
+static int SensorSlot(NV_THERMAL_TARGET target)
 {
-	*pstates = {};
-	return NvAPI_GPU_GetDynamicPStates(physical_gpu_handle, pstates) == 0;
+	switch (target) {
+	case NV_THERMAL_TARGET::GPU:
+		return 0;
+	case NV_THERMAL_TARGET::MEMORY:
+		return 1;
+	case NV_THERMAL_TARGET::POWER_SUPPLY:
+		return 2;
+	case NV_THERMAL_TARGET::BOARD:
+		return 3;
+	default:
+		break;
+	}
+	return -1;
 }
 
-bool LoadGPUPStates20V2(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_GPU_PSTATES20_V2 *pstates20)
+// Position of the first of [count] entries satisfying [matches], [index] is kept
+// while [count] is what it was resolved against and its entry still matches
+template<typename Matches>
+static NV_S32 Resolve(NV_S32 index, NV_U32 &resolved_count, NV_U32 count, Matches matches)
 {
-	*pstates20 = { };
-	return NvAPI_GPU_GetPStates20(physical_gpu_handle, pstates20) == 0;
+	if (count == resolved_count && (index < 0 || matches(static_cast<NV_U32>(index)))) {
+		return index;
+	}
+	resolved_count = count;
+	for (NV_U32 i = 0; i < count; i++) {
+		if (matches(i)) {
+			return static_cast<NV_S32>(i);
+		}
+	}
+	return -1;
 }
 
-bool LoadGPUPowerPoliciesInfo(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_GPU_POWER_POLICIES_INFO_V1 *power_policies_info)
-{
-	*power_policies_info = {};
-	return NvAPI_GPU_GetPowerPoliciesInfo(physical_gpu_handle, power_policies_info) == 0;
-}
+struct GPU::DataSet {
+	std::array<NV_CLOCK_FREQUENCIES_V2, static_cast<std::size_t>(NV_CLOCK_FREQUENCY_TYPE::LAST)> m_frequencies;
+	NV_DYNAMIC_PSTATES_V1 m_dynamic_pstates;
+	NV_GPU_PSTATES20_V2 m_pstates20;
+	NV_GPU_POWER_POLICIES_INFO_V1 m_power_policies_info;
+	NV_GPU_POWER_POLICIES_STATUS_V1 m_power_policies_status;
+	NV_GPU_POWER_TOPOLOGY_STATUS_V1 m_power_topology_status;
+	NV_GPU_VOLTAGE_DOMAINS_STATUS_V1 m_voltage_domain_status;
+	NV_GPU_THERMAL_SETTINGS_V2 m_thermal_settings;
+	NV_GPU_THERMAL_POLICIES_INFO_V2 m_thermal_policies_info;
+	NV_GPU_THERMAL_POLICIES_STATUS_V2 m_thermal_policies_status;
+	NV_GPU_COOLER_SETTINGS_V2 m_cooler_settings;
+	NV_MEMORY_INFO_V2 m_memory_info;
+	NV_U32 m_loaded;
+	IndexMap m_indices;
+
+	// State of every load, carried over from one data set to the next
+	struct Field {
+		double time;       // MetricTime of the last successful load, 0 when it never loaded
+		NV_STATUS status;  // status of the last attempt
+		NV_U32 failures;   // consecutive failed attempts
+		double retry;      // MetricTime before which the load is not attempted again
+	};
+	std::array<Field, LOAD_COUNT> m_fields;
 
-bool LoadGPUPowerPoliciesStatus(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_GPU_POWER_POLICIES_STATUS_V1 *power_policies_status)
-{
-	*power_policies_status = {};
-	return NvAPI_GPU_GetPowerPoliciesStatus(physical_gpu_handle, power_policies_status) == 0;
-}
+	bool Has(NV_U32 loads) const;
+	void Index(const IndexMap &previous);
 
-bool LoadGPUVoltageDomainsStatus(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_GPU_VOLTAGE_DOMAINS_STATUS_V1 *voltage_domain_status)
-{
-	*voltage_domain_status = {};
-	return NvAPI_GPU_GetVoltageDomainStatus(physical_gpu_handle, voltage_domain_status) == 0;
-}
+	// Takes the structure of [load] over from [previous]
+	void Inherit(NV_U32 load, const DataSet &previous);
+};
 
-bool LoadGPUThermalPoliciesInfoV2(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_GPU_THERMAL_POLICIES_INFO_V2 *thermal_policies_info)
+inline bool GPU::DataSet::Has(NV_U32 loads) const
 {
-	*thermal_policies_info = {};
-	return NvAPI_GPU_GetThermalPoliciesInfo(physical_gpu_handle, thermal_policies_info) == 0;
+	return (m_loaded & loads) == loads;
 }
 
-bool LoadGPUThermalPoliciesStatusV2(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-    NV_GPU_THERMAL_POLICIES_STATUS_V2 *thermal_policies_status)
+GPU::OverclockSetting::OverclockSetting() : OverclockSetting(0.0f, 0.0f, 0.0f, false)
 {
-	*thermal_policies_status = {};
-	return NvAPI_GPU_GetThermalPoliciesStatus(physical_gpu_handle, thermal_policies_status) == 0;
 }
 
-bool LoadGPUCoolerSettingsV2(
-	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
-	NV_S32 cooler_index,
-	NV_GPU_COOLER_SETTINGS_V2 *cooler_settings)
+GPU::OverclockSetting::OverclockSetting(float min, float current, float max, bool editable)
+	: editable      { editable }
+	, min_value     { min }
+	, current_value { current }
+	, max_value     { max }
 {
-	*cooler_settings = {};
-	return NvAPI_GPU_GetCoolerSettings(physical_gpu_handle, cooler_index, cooler_settings) == 0;
 }
 
 GPU::OverclockSetting GetPowerLimit(
 	const NV_GPU_POWER_POLICIES_INFO_V1 *const info,
 	const NV_GPU_POWER_POLICIES_STATUS_V1 *const status,
-	NV_U32 pstate = 0)
-{
-	for (NV_U32 i = 0; i < status->count; i++) {
-		const auto &status_entry = status->entries[i];
-		const auto &info_entry = info->entries[i];
-		if (status_entry.pstate == pstate) {
-			// NOTE(dweiler): unlock thermal limits, power policy values are multiples of 1000
-			return {
-				static_cast<float>(info_entry.min_power) / 1000.0f,
-				static_cast<float>(status_entry.power) / 1000.0f,
-				static_cast<float>(info_entry.max_power) / 1000.0f
-			};
-		}
+	NV_S32 index)
+{
+	if (index < 0) {
+		return {};
 	}
-	return {};
+
+	// NOTE(dweiler): unlock thermal limits, power policy values are multiples of 1000
+	const auto &status_entry = status->entries[index];
+	const auto &info_entry = info->entries[index];
+	return {
+		static_cast<float>(info_entry.min_power) / 1000.0f,
+		static_cast<float>(status_entry.power) / 1000.0f,
+		static_cast<float>(info_entry.max_power) / 1000.0f
+	};
 }
 
 std::tuple<GPU::OverclockSetting, GPU::OverclockFlag> GetThermalLimit(
 	const NV_GPU_THERMAL_POLICIES_INFO_V2 *const info,
 	const NV_GPU_THERMAL_POLICIES_STATUS_V2 *const status,
-	const NV_THERMAL_CONTROLLER controller = NV_THERMAL_CONTROLLER::GPU_INTERNAL)
-{
-	for (NV_U32 i = 0; i < status->count; i++) {
-		const auto &status_entry = status->entries[i];
-		const auto &info_entry = info->entries[i];
-		if (static_cast<NV_THERMAL_CONTROLLER>(status_entry.controller) == controller) {
-			// NOTE(dweiler): unlike power limits, thermal policy values are multiples of 256
-			return {
-				{
-					info_entry.min / 256.0f,
-					status_entry.value / 256.0f,
-					info_entry.max / 256.0f,
-					info_entry.max > 0
-				},
-				{
-					static_cast<bool>(info_entry.default_flags & 1),
-					static_cast<bool>(status_entry.flags & 1)
-				}
-			};
-		}
+	NV_S32 index)
+{
+	if (index < 0) {
+		return {};
 	}
 
-	return {};
+	// NOTE(dweiler): unlike power limits, thermal policy values are multiples of 256
+	const auto &status_entry = status->entries[index];
+	const auto &info_entry = info->entries[index];
+	return {
+		{
+			info_entry.min / 256.0f,
+			status_entry.value / 256.0f,
+			info_entry.max / 256.0f,
+			info_entry.max > 0
+		},
+		{
+			static_cast<bool>(info_entry.default_flags & 1),
+			static_cast<bool>(status_entry.flags & 1)
+		}
+	};
+}
+
+void GPU::DataSet::Inherit(NV_U32 load, const DataSet &previous)
+{
+	const auto current = static_cast<std::size_t>(NV_CLOCK_FREQUENCY_TYPE::CURRENT);
+	const auto base = static_cast<std::size_t>(NV_CLOCK_FREQUENCY_TYPE::BASE);
+	const auto boost = static_cast<std::size_t>(NV_CLOCK_FREQUENCY_TYPE::BOOST);
+	switch (load) {
+	case LOAD_CURRENT_FREQUENCIES:
+		m_frequencies[current] = previous.m_frequencies[current];
+		break;
+	case LOAD_BASE_FREQUENCIES:
+		m_frequencies[base] = previous.m_frequencies[base];
+		break;
+	case LOAD_BOOST_FREQUENCIES:
+		m_frequencies[boost] = previous.m_frequencies[boost];
+		break;
+	case LOAD_DYNAMIC_PSTATES:
+		m_dynamic_pstates = previous.m_dynamic_pstates;
+		break;
+	case LOAD_PSTATES20:
+		m_pstates20 = previous.m_pstates20;
+		break;
+	case LOAD_POWER_POLICIES_INFO:
+		m_power_policies_info = previous.m_power_policies_info;
+		break;
+	case LOAD_POWER_POLICIES_STATUS:
+		m_power_policies_status = previous.m_power_policies_status;
+		break;
+	case LOAD_POWER_TOPOLOGY_STATUS:
+		m_power_topology_status = previous.m_power_topology_status;
+		break;
+	case LOAD_VOLTAGE_DOMAINS_STATUS:
+		m_voltage_domain_status = previous.m_voltage_domain_status;
+		break;
+	case LOAD_THERMAL_SETTINGS:
+		m_thermal_settings = previous.m_thermal_settings;
+		break;
+	case LOAD_THERMAL_POLICIES_INFO:
+		m_thermal_policies_info = previous.m_thermal_policies_info;
+		break;
+	case LOAD_THERMAL_POLICIES_STATUS:
+		m_thermal_policies_status = previous.m_thermal_policies_status;
+		break;
+	case LOAD_COOLER_SETTINGS:
+		m_cooler_settings = previous.m_cooler_settings;
+		break;
+	case LOAD_MEMORY_INFO:
+		m_memory_info = previous.m_memory_info;
+		break;
+	}
+	m_loaded |= load;
 }
 
-NV_U32 GetBestPStateIndex(const NV_GPU_PSTATES20_V2 *pstates)
+void GPU::DataSet::Index(const IndexMap &previous)
 {
-	NV_U32 best_pstate_index = 0;
-	NV_U32 best_pstate_state = UINT32_MAX;
-	for (NV_U32 i = 0; i < pstates->state_count; i++) {
-		if (pstates->states[i].state_num < best_pstate_state) {
-			best_pstate_index = i;
-			best_pstate_state = pstates->states[i].state_num;
+	m_indices = previous;
+
+	// An array which was not loaded has nothing to point into and is searched again once it is
+	auto resolve = [&](NV_U32 load, NV_S32 &index, NV_U32 &resolved_count, NV_U32 count, auto matches) {
+		if (!Has(load)) {
+			index = -1;
+			resolved_count = ~0u;
+			return;
+		}
+		index = Resolve(index, resolved_count, count, matches);
+	};
+
+	if (Has(LOAD_THERMAL_SETTINGS)) {
+		// Sensors are resolved together, the count only moves on after all four are checked
+		const NV_U32 count = m_thermal_settings.count;
+		for (int slot = 0; slot < 4; slot++) {
+			NV_U32 resolved_count = m_indices.sensor_count;
+			m_indices.sensors[slot] = Resolve(m_indices.sensors[slot], resolved_count, count, [&](NV_U32 i) {
+				return SensorSlot(m_thermal_settings.sensor[i].target) == slot;
+			});
+		}
+		m_indices.sensor_count = count;
+	} else {
+		for (auto &sensor : m_indices.sensors) {
+			sensor = -1;
 		}
+		m_indices.sensor_count = ~0u;
 	}
-	return best_pstate_index;
+
+	resolve(LOAD_VOLTAGE_DOMAINS_STATUS, m_indices.voltage_domain, m_indices.voltage_domain_count, m_voltage_domain_status.count, [&](NV_U32 i) {
+		// TODO(dweiler): figure out what the other voltage domains are for
+		return m_voltage_domain_status.entries[i].voltage_domain == 0;
+	});
+	resolve(LOAD_POWER_TOPOLOGY_STATUS, m_indices.power_topology, m_indices.power_topology_count, m_power_topology_status.count, [&](NV_U32 i) {
+		// Domain zero is the GPU itself, the others cover the rest of the board
+		return m_power_topology_status.entries[i].domain == 0;
+	});
+	resolve(LOAD_POWER_POLICIES_INFO | LOAD_POWER_POLICIES_STATUS, m_indices.power_policy, m_indices.power_policy_count, m_power_policies_status.count, [&](NV_U32 i) {
+		return m_power_policies_status.entries[i].pstate == 0;
+	});
+	resolve(LOAD_THERMAL_POLICIES_INFO | LOAD_THERMAL_POLICIES_STATUS, m_indices.thermal_policy, m_indices.thermal_policy_count, m_thermal_policies_status.count, [&](NV_U32 i) {
+		return static_cast<NV_THERMAL_CONTROLLER>(m_thermal_policies_status.entries[i].controller) == NV_THERMAL_CONTROLLER::GPU_INTERNAL;
+	});
 }
 
 std::optional<float> GetUsageForSystem(NV_DYNAMIC_PSTATES_SYSTEM system, const NV_DYNAMIC_PSTATES_V1 *const pstates)
@@ -186,6 +339,10 @@ GPU::GPU(NV_S32 adapter_index, NV_PHYSICAL_GPU_HANDLE physical_gpu_handle, NV_DI
 	: m_adapter_index       { adapter_index }
 	, m_physical_gpu_handle { physical_gpu_handle }
 	, m_display_handle      { display_handle }
+	, m_pci_identifiers     { }
+	, m_driver_calls        { 0 }
+	, m_next_subscription   { 0 }
+	, m_loads               { LOAD_ALL }
 {
 	// Extracting the name is straight forward
 	NV_SHORT_STRING name;
@@ -215,29 +372,34 @@ GPU::GPU(NV_S32 adapter_index, NV_PHYSICAL_GPU_HANDLE physical_gpu_handle, NV_DI
 	if (NvAPI_GPU_GetPCIIdentifiers(m_physical_gpu_handle, &pci_identifiers[0], &pci_identifiers[1], &pci_identifiers[2], &pci_identifiers[3]) == 0) {
 		m_pci_identifiers = std::move(pci_identifiers);
 	}
+
+	// These never change so they are only formatted once
+	for (std::size_t i = 0; i < m_pci_identifiers.size(); i++) {
+		char buffer[16];
+		snprintf(buffer, sizeof buffer, "0x%08x", m_pci_identifiers[i]);
+		m_pci_identifier_strings[i] = buffer;
+	}
+}
+
+GPU::~GPU()
+{
 }
 
 std::optional<float> GPU::GetVoltage() const
 {
-	if (m_data_set) {
-		for (NV_U32 i = 0; i < m_data_set->m_voltage_domain_status.count; i++) {
-			// TODO(dweiler): figure out what the other voltage domains are for
-			if (m_data_set->m_voltage_domain_status.entries[i].voltage_domain == 0) {
-				return this->m_data_set->m_voltage_domain_status.entries[i].current_voltage / 1'000'000.0f;
-			}
-		}
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (m_data_set && m_data_set->m_indices.voltage_domain >= 0) {
+		return m_data_set->m_voltage_domain_status.entries[m_data_set->m_indices.voltage_domain].current_voltage / 1'000'000.0f;
 	}
 	return std::nullopt;
 }
 
 std::optional<float> GPU::GetTemperature(NV_THERMAL_TARGET target) const
 {
-	if (m_data_set) {
-		for (NV_U32 i = 0; i < m_data_set->m_thermal_settings.count; i++) {
-			if (m_data_set->m_thermal_settings.sensor[i].target == target) {
-				return static_cast<float>(m_data_set->m_thermal_settings.sensor[i].current_temperature);
-			}
-		}
+	const int slot = SensorSlot(target);
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (m_data_set && slot >= 0 && m_data_set->m_indices.sensors[slot] >= 0) {
+		return static_cast<float>(m_data_set->m_thermal_settings.sensor[m_data_set->m_indices.sensors[slot]].current_temperature);
 	}
 	return std::nullopt;
 }
@@ -264,6 +426,12 @@ std::optional<GPU::Clocks> GPU::GetBoostClocks() const
 
 std::optional<GPU::Clocks> GPU::GetClocks(NV_CLOCK_FREQUENCY_TYPE type, bool compenate_for_over_clock) const
 {
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	const auto load = LOAD_CURRENT_FREQUENCIES << static_cast<int>(type);
+	if (!m_data_set || !m_data_set->Has(load)) {
+		return std::nullopt;
+	}
+
 	const auto &data_source = m_data_set->m_frequencies[static_cast<int>(type)];
 
 	auto fetch = [&](NV_CLOCK_SYSTEM clock_system) -> std::optional<float>
@@ -288,7 +456,8 @@ std::optional<GPU::Clocks> GPU::GetClocks(NV_CLOCK_FREQUENCY_TYPE type, bool com
 
 std::optional<GPU::Usage> GPU::GetUsage() const
 {
-	if (!m_data_set) {
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (!m_data_set || !m_data_set->Has(LOAD_DYNAMIC_PSTATES)) {
 		return std::nullopt;
 	}
 
@@ -302,7 +471,8 @@ std::optional<GPU::Usage> GPU::GetUsage() const
 
 std::optional<GPU::Memory> GPU::GetMemory() const
 {
-	if (!m_data_set) {
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (!m_data_set || !m_data_set->Has(LOAD_MEMORY_INFO)) {
 		return std::nullopt;
 	}
 
@@ -317,11 +487,166 @@ std::optional<GPU::Memory> GPU::GetMemory() const
 	};
 }
 
+std::optional<float> GPU::GetPowerUsage() const
+{
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (m_data_set && m_data_set->m_indices.power_topology >= 0) {
+		return m_data_set->m_power_topology_status.entries[m_data_set->m_indices.power_topology].power / 1000.0f;
+	}
+	return std::nullopt;
+}
+
+std::optional<GPU::OverclockSetting> GPU::GetPowerLimit() const
+{
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (m_data_set && m_data_set->m_indices.power_policy >= 0) {
+		return ::GetPowerLimit(&m_data_set->m_power_policies_info, &m_data_set->m_power_policies_status, m_data_set->m_indices.power_policy);
+	}
+	return std::nullopt;
+}
+
+std::optional<GPU::OverclockSetting> GPU::GetThermalLimit() const
+{
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (m_data_set && m_data_set->m_indices.thermal_policy >= 0) {
+		const auto limit = std::get<0>(::GetThermalLimit(&m_data_set->m_thermal_policies_info, &m_data_set->m_thermal_policies_status, m_data_set->m_indices.thermal_policy));
+		if (limit.editable) {
+			return limit;
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<float> GPU::GetFanLevel() const
+{
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	// Cooler levels are percentages, every cooler is driven by the same policy so the
+	// first one speaks for all of them
+	if (m_data_set && m_data_set->Has(LOAD_COOLER_SETTINGS) && m_data_set->m_cooler_settings.count > 0) {
+		return static_cast<float>(m_data_set->m_cooler_settings.coolers[0].current_level);
+	}
+	return std::nullopt;
+}
+
+static_assert(static_cast<NV_U32>(Metric::BASE_CLOCK_CORE) == static_cast<NV_U32>(Metric::CURRENT_CLOCK_CORE) + 3 &&
+	static_cast<NV_U32>(Metric::BOOST_CLOCK_CORE) == static_cast<NV_U32>(Metric::CURRENT_CLOCK_CORE) + 6,
+	"GetSnapshot expects the clocks of every frequency type next to each other");
+static_assert(static_cast<NV_U32>(Metric::TEMPERATURE_BOARD) == static_cast<NV_U32>(Metric::TEMPERATURE_GPU) + 3,
+	"GetSnapshot expects the temperatures in the order of the sensor slots");
+static_assert(static_cast<NV_U32>(Metric::USAGE_BUS) == static_cast<NV_U32>(Metric::USAGE_GPU) + 3,
+	"GetSnapshot expects the usages next to each other");
+
+void GPU::GetSnapshot(Snapshot &snapshot) const
+{
+	snapshot.sequence++;
+	snapshot.time = MetricTime();
+	snapshot.present = 0;
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (!m_data_set) {
+		return;
+	}
+
+	const DataSet &data_set = *m_data_set;
+	auto store = [&](Metric metric, float value) {
+		snapshot.values[static_cast<NV_U32>(metric)] = value;
+		snapshot.present |= MetricBit(metric);
+	};
+
+	const IndexMap &indices = data_set.m_indices;
+
+	// Sensor slots are in the order of the temperature metrics
+	for (NV_U32 slot = 0; slot < 4; slot++) {
+		if (indices.sensors[slot] >= 0) {
+			store(static_cast<Metric>(static_cast<NV_U32>(Metric::TEMPERATURE_GPU) + slot),
+				static_cast<float>(data_set.m_thermal_settings.sensor[indices.sensors[slot]].current_temperature));
+		}
+	}
+
+	if (indices.voltage_domain >= 0) {
+		store(Metric::VOLTAGE, data_set.m_voltage_domain_status.entries[indices.voltage_domain].current_voltage / 1'000'000.0f);
+	}
+
+	// Current, base and boost clocks are consecutive in both the loads and the metrics
+	for (NV_U32 type = 0; type < static_cast<NV_U32>(NV_CLOCK_FREQUENCY_TYPE::LAST); type++) {
+		if (!data_set.Has(LOAD_CURRENT_FREQUENCIES << type)) {
+			continue;
+		}
+		const auto &entries = data_set.m_frequencies[type].entries;
+		const NV_U32 first = static_cast<NV_U32>(Metric::CURRENT_CLOCK_CORE) + type * 3;
+		const NV_CLOCK_SYSTEM systems[] = { NV_CLOCK_SYSTEM::GPU, NV_CLOCK_SYSTEM::MEMORY, NV_CLOCK_SYSTEM::SHADER };
+		for (NV_U32 i = 0; i < 3; i++) {
+			const auto &entry = entries[static_cast<std::size_t>(systems[i])];
+			if (entry.present) {
+				store(static_cast<Metric>(first + i), entry.frequency / 1000.0f);
+			}
+		}
+	}
+
+	if (data_set.Has(LOAD_DYNAMIC_PSTATES)) {
+		const NV_DYNAMIC_PSTATES_SYSTEM systems[] = { NV_DYNAMIC_PSTATES_SYSTEM::GPU, NV_DYNAMIC_PSTATES_SYSTEM::FB, NV_DYNAMIC_PSTATES_SYSTEM::VID, NV_DYNAMIC_PSTATES_SYSTEM::BUS };
+		for (NV_U32 i = 0; i < 4; i++) {
+			const auto &state = data_set.m_dynamic_pstates.pstates[static_cast<std::size_t>(systems[i])];
+			if (state.present) {
+				store(static_cast<Metric>(static_cast<NV_U32>(Metric::USAGE_GPU) + i), static_cast<float>(state.value));
+			}
+		}
+	}
+
+	if (data_set.Has(LOAD_MEMORY_INFO)) {
+		const auto total_memory = data_set.m_memory_info.values[0];
+		const auto free_memory = data_set.m_memory_info.values[4];
+		store(Metric::MEMORY_TOTAL, static_cast<float>(total_memory) / 1024.0f);
+		store(Metric::MEMORY_FREE, static_cast<float>(free_memory) / 1024.0f);
+		store(Metric::MEMORY_USED, static_cast<float>(std::max(total_memory - free_memory, static_cast<NV_U32>(0))) / 1024.0f);
+	}
+
+	if (indices.power_topology >= 0) {
+		store(Metric::POWER_USAGE, data_set.m_power_topology_status.entries[indices.power_topology].power / 1000.0f);
+	}
+
+	if (indices.power_policy >= 0) {
+		store(Metric::POWER_LIMIT, data_set.m_power_policies_status.entries[indices.power_policy].power / 1000.0f);
+	}
+
+	if (indices.thermal_policy >= 0) {
+		const auto limit = std::get<0>(::GetThermalLimit(&data_set.m_thermal_policies_info, &data_set.m_thermal_policies_status, indices.thermal_policy));
+		if (limit.editable) {
+			store(Metric::THERMAL_LIMIT, limit.current_value);
+		}
+	}
+
+	if (data_set.Has(LOAD_COOLER_SETTINGS) && data_set.m_cooler_settings.count > 0) {
+		store(Metric::FAN_LEVEL, static_cast<float>(data_set.m_cooler_settings.coolers[0].current_level));
+	}
+}
+
+NV_U32 GPU::GetCoolerCount()
+{
+	if (m_data_set && m_data_set->Has(LOAD_COOLER_SETTINGS)) {
+		return m_data_set->m_cooler_settings.count;
+	}
+
+	// Nobody subscribed to the coolers, fetch them just for this write
+	NV_GPU_COOLER_SETTINGS_V2 cooler_settings;
+	const uint64_t hits = NvAPI_GetThreadCacheHits();
+	const NV_STATUS status = LoadGPUCoolerSettingsV2(m_physical_gpu_handle, 0, &cooler_settings);
+	m_driver_calls += NvAPI_GetThreadCacheHits() == hits;
+	if (status == 0) {
+		return cooler_settings.count;
+	}
+	return 0;
+}
+
 bool GPU::SetDefaultFanSpeed()
 {
+	if (!DriverExecutor::Get().IsDriverThread()) {
+		return SetDefaultFanSpeedAsync().get();
+	}
+
 	bool result = true;
 	NV_GPU_COOLER_LEVELS_V1 cooler_levels = {};
-	for (NV_U32 i = 0; i < m_data_set->m_cooler_settings.count; i++) {
+	const NV_U32 count = GetCoolerCount();
+	for (NV_U32 i = 0; i < count; i++) {
 		cooler_levels.levels[i].policy = 0x20;
 		result &= NvAPI_GPU_SetCoolerLevels(m_physical_gpu_handle, i, &cooler_levels) == 0;
 	}
@@ -330,9 +655,14 @@ bool GPU::SetDefaultFanSpeed()
 
 bool GPU::SetCustomFanSpeed(NV_U32 value)
 {
+	if (!DriverExecutor::Get().IsDriverThread()) {
+		return SetCustomFanSpeedAsync(value).get();
+	}
+
 	bool result = true;
 	NV_GPU_COOLER_LEVELS_V1 cooler_levels = {};
-	for (NV_U32 i = 0; i < m_data_set->m_cooler_settings.count; i++) {
+	const NV_U32 count = GetCoolerCount();
+	for (NV_U32 i = 0; i < count; i++) {
 		cooler_levels.levels[i].policy = 0x01;
 		cooler_levels.levels[i].level = value;
 		result &= NvAPI_GPU_SetCoolerLevels(m_physical_gpu_handle, i, &cooler_levels) == 0;
@@ -340,42 +670,200 @@ bool GPU::SetCustomFanSpeed(NV_U32 value)
 	return result;
 }
 
+bool GPU::SetPowerLimit(float value)
+{
+	if (!DriverExecutor::Get().IsDriverThread()) {
+		return SetPowerLimitAsync(value).get();
+	}
+
+	if (!m_data_set || m_data_set->m_indices.power_policy < 0 || !std::isfinite(value) || value < 0.0f) {
+		return false;
+	}
+
+	// Only the entry for the highest performance state is written, the remaining entries
+	// are passed back to the driver untouched
+	const NV_S32 index = m_data_set->m_indices.power_policy;
+	NV_GPU_POWER_POLICIES_STATUS_V1 power_policies_status = m_data_set->m_power_policies_status;
+	const auto &info_entry = m_data_set->m_power_policies_info.entries[index];
+	// Clamped before the conversion, a value out of range of NV_U32 cannot be converted
+	const float power = std::clamp(value * 1000.0f, static_cast<float>(info_entry.min_power), static_cast<float>(info_entry.max_power));
+	power_policies_status.entries[index].power = static_cast<NV_U32>(power);
+
+	if (NvAPI_GPU_SetPowerPoliciesStatus(m_physical_gpu_handle, &power_policies_status) != 0) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	m_data_set->m_power_policies_status = power_policies_status;
+	return true;
+}
+
+std::future<bool> GPU::SetDefaultFanSpeedAsync()
+{
+	return DriverExecutor::Get().Submit(this, [this] { return SetDefaultFanSpeed(); });
+}
+
+std::future<bool> GPU::SetCustomFanSpeedAsync(NV_U32 value)
+{
+	return DriverExecutor::Get().Submit(this, [this, value] { return SetCustomFanSpeed(value); });
+}
+
+std::future<bool> GPU::SetPowerLimitAsync(float value)
+{
+	return DriverExecutor::Get().Submit(this, [this, value] { return SetPowerLimit(value); });
+}
+
+NV_U32 GPU::Subscribe(MetricSet metrics)
+{
+	const NV_U32 subscription = m_next_subscription++;
+	m_subscriptions.push_back({ subscription, metrics });
+	UpdateLoads();
+	return subscription;
+}
+
+void GPU::Unsubscribe(NV_U32 subscription)
+{
+	m_subscriptions.erase(
+		std::remove_if(m_subscriptions.begin(), m_subscriptions.end(),
+			[&](const Subscription &s) { return s.id == subscription; }),
+		m_subscriptions.end());
+	UpdateLoads();
+}
+
+MetricSet GPU::GetSubscribedMetrics() const
+{
+	if (m_subscriptions.empty()) {
+		return ALL_METRICS;
+	}
+
+	MetricSet metrics = 0;
+	for (const auto &subscription : m_subscriptions) {
+		metrics |= subscription.metrics;
+	}
+	return metrics;
+}
+
+void GPU::UpdateLoads()
+{
+	// Without any subscriptions everything is loaded like before subscriptions existed
+	m_loads = m_subscriptions.empty()
+		? LOAD_ALL
+		: GetLoadsForMetrics(GetSubscribedMetrics());
+}
+
 bool GPU::Update()
 {
+	// Off the driver thread this waits for an update there, which may be one already queued
+	if (!DriverExecutor::Get().IsDriverThread()) {
+		return UpdateAsync().get();
+	}
+
+	const double now = MetricTime();
+	const NV_U32 needed = m_loads;
 	std::unique_ptr<DataSet> data_set(new DataSet);
+	data_set->m_loaded = 0;
+	data_set->m_fields = m_data_set ? m_data_set->m_fields : decltype(data_set->m_fields) {};
+
+	// Issues [function] when [load] is needed and not backing off, returns false only when it was issued and failed
+	NV_U32 attempted = 0;
+	auto load = [&](NV_U32 load, auto function) {
+		auto &field = data_set->m_fields[LoadIndex(load)];
+		if (!(needed & load) || now < field.retry) {
+			return true;
+		}
+		// Responses served from the cache are not driver calls
+		const uint64_t hits = NvAPI_GetThreadCacheHits();
+		attempted |= load;
+		field.status = function();
+		m_driver_calls += NvAPI_GetThreadCacheHits() == hits;
+		if (field.status != 0) {
+			// Interfaces this card keeps rejecting are retried less and less often
+			if (++field.failures >= kBackoffAfter) {
+				field.retry = now + std::min(kBackoffLast, kBackoffFirst * std::exp2(field.failures - kBackoffAfter));
+				if (field.failures == kBackoffAfter) {
+					Log::write("'%s' failed to load %s %u times with status %d, backing off", m_name.c_str(), LoadName(load), field.failures, field.status);
+				}
+			}
+			return false;
+		}
+		field.time = now;
+		field.failures = 0;
+		field.retry = 0.0;
+		data_set->m_loaded |= load;
+		return true;
+	};
 
-	bool frequency_status = true;
+	bool frequency_status = false;
 	const auto current = static_cast<std::size_t>(NV_CLOCK_FREQUENCY_TYPE::CURRENT);
 	const auto base = static_cast<std::size_t>(NV_CLOCK_FREQUENCY_TYPE::BASE);
 	const auto boost = static_cast<std::size_t>(NV_CLOCK_FREQUENCY_TYPE::BOOST);
-	frequency_status &= LoadClockFrequencies(m_physical_gpu_handle, &data_set->m_frequencies[current], NV_CLOCK_FREQUENCY_TYPE::CURRENT);
-	frequency_status &= LoadClockFrequencies(m_physical_gpu_handle, &data_set->m_frequencies[base], NV_CLOCK_FREQUENCY_TYPE::BASE);
-	frequency_status &= LoadClockFrequencies(m_physical_gpu_handle, &data_set->m_frequencies[boost], NV_CLOCK_FREQUENCY_TYPE::BOOST);
+	frequency_status |= load(LOAD_CURRENT_FREQUENCIES, [&] { return LoadClockFrequencies(m_physical_gpu_handle, &data_set->m_frequencies[current], NV_CLOCK_FREQUENCY_TYPE::CURRENT); });
+	frequency_status |= load(LOAD_BASE_FREQUENCIES, [&] { return LoadClockFrequencies(m_physical_gpu_handle, &data_set->m_frequencies[base], NV_CLOCK_FREQUENCY_TYPE::BASE); });
+	frequency_status |= load(LOAD_BOOST_FREQUENCIES, [&] { return LoadClockFrequencies(m_physical_gpu_handle, &data_set->m_frequencies[boost], NV_CLOCK_FREQUENCY_TYPE::BOOST); });
 
-	// When we were able to load all frequency values load the remainder of the data set
+	// When none of the frequencies could be loaded the driver is not answering for this GPU, skip the remainder
 	if (frequency_status) {
-		bool status = true;
-		status &= LoadGPUDynamicPStates(m_physical_gpu_handle, &data_set->m_dynamic_pstates);
-		status &= LoadGPUPStates20V2(m_physical_gpu_handle, &data_set->m_pstates20);
-		status &= LoadGPUPowerPoliciesInfo(m_physical_gpu_handle, &data_set->m_power_policies_info);
-
-		// TODO(dweiler): how come this interface can be called by ASUS Precision XOC without crashing?
-		// we really do need this interface, it used to work too, need to figure out what nvapi is doing
-		// to prevent us from calling it, we can't monitor OC without it...
-		//status &= LoadGPUPowerPoliciesStatus(m_physical_gpu_handle, &data_set->m_power_policies_status);
-		status &= LoadGPUVoltageDomainsStatus(m_physical_gpu_handle, &data_set->m_voltage_domain_status);
-		status &= LoadGPUThermalSettingsV2(m_physical_gpu_handle, &data_set->m_thermal_settings);
-		status &= LoadGPUThermalPoliciesInfoV2(m_physical_gpu_handle, &data_set->m_thermal_policies_info);
-		status &= LoadGPUThermalPoliciesStatusV2(m_physical_gpu_handle, &data_set->m_thermal_policies_status);
-		status &= LoadGPUCoolerSettingsV2(m_physical_gpu_handle, 0, &data_set->m_cooler_settings);
-
-		status &= NvAPI_GetMemoryInfo(m_display_handle, &data_set->m_memory_info) == 0;
-
-		if (status) {
-			m_data_set = std::move(data_set);
-			return true;
+		load(LOAD_DYNAMIC_PSTATES, [&] { return LoadGPUDynamicPStates(m_physical_gpu_handle, &data_set->m_dynamic_pstates); });
+		load(LOAD_PSTATES20, [&] { return LoadGPUPStates20V2(m_physical_gpu_handle, &data_set->m_pstates20); });
+		load(LOAD_POWER_POLICIES_INFO, [&] { return LoadGPUPowerPoliciesInfo(m_physical_gpu_handle, &data_set->m_power_policies_info); });
+		load(LOAD_POWER_POLICIES_STATUS, [&] { return LoadGPUPowerPoliciesStatus(m_physical_gpu_handle, &data_set->m_power_policies_status); });
+		load(LOAD_POWER_TOPOLOGY_STATUS, [&] { return LoadGPUPowerTopologyStatus(m_physical_gpu_handle, &data_set->m_power_topology_status); });
+		load(LOAD_VOLTAGE_DOMAINS_STATUS, [&] { return LoadGPUVoltageDomainsStatus(m_physical_gpu_handle, &data_set->m_voltage_domain_status); });
+		load(LOAD_THERMAL_SETTINGS, [&] { return LoadGPUThermalSettingsV2(m_physical_gpu_handle, &data_set->m_thermal_settings); });
+		load(LOAD_THERMAL_POLICIES_INFO, [&] { return LoadGPUThermalPoliciesInfoV2(m_physical_gpu_handle, &data_set->m_thermal_policies_info); });
+		load(LOAD_THERMAL_POLICIES_STATUS, [&] { return LoadGPUThermalPoliciesStatusV2(m_physical_gpu_handle, &data_set->m_thermal_policies_status); });
+		load(LOAD_COOLER_SETTINGS, [&] { return LoadGPUCoolerSettingsV2(m_physical_gpu_handle, 0, &data_set->m_cooler_settings); });
+		load(LOAD_MEMORY_INFO, [&] { return NvAPI_GetMemoryInfo(m_display_handle, &data_set->m_memory_info); });
+	}
+
+	// Anything needed which was not loaded this time keeps the last good structure
+	const NV_U32 fresh = data_set->m_loaded;
+	if (m_data_set) {
+		const NV_U32 stale = needed & m_data_set->m_loaded & ~fresh;
+		for (NV_U32 load = 1; load & LOAD_ALL; load <<= 1) {
+			if (stale & load) {
+				data_set->Inherit(load, *m_data_set);
+			}
 		}
 	}
 
-	return false;
-}
\ No newline at end of file
+	data_set->Index(m_data_set ? m_data_set->m_indices : IndexMap());
+	{
+		std::lock_guard<std::mutex> lock(m_data_mutex);
+		m_data_set = std::move(data_set);
+	}
+	return (fresh & attempted) != 0;
+}
+
+GPU::MetricStatus GPU::GetMetricStatus(Metric metric) const
+{
+	MetricStatus result = { 0.0, 0, 0.0 };
+	std::lock_guard<std::mutex> lock(m_data_mutex);
+	if (!m_data_set) {
+		return result;
+	}
+
+	// A metric decoded from several structures is as old as the oldest of them
+	const NV_U32 loads = GetLoadsForMetric(metric);
+	bool first = true;
+	for (NV_U32 load = 1; load & LOAD_ALL; load <<= 1) {
+		if (!(loads & load)) {
+			continue;
+		}
+		const auto &field = m_data_set->m_fields[LoadIndex(load)];
+		result.time = first ? field.time : std::min(result.time, field.time);
+		result.status = result.status ? result.status : field.status;
+		result.retry = std::max(result.retry, field.retry);
+		first = false;
+	}
+	return result;
+}
+
+// Operation UpdateAsync is coalesced under on the driver executor
+static constexpr uint32_t kOperationUpdate = 1;
+
+std::future<bool> GPU::UpdateAsync()
+{
+	// Updates of this GPU queued together are answered by one
+	return DriverExecutor::Get().SubmitRead(this, kOperationUpdate, [this] { return Update(); });
+}
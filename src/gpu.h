@@ -1,13 +1,28 @@
 #ifndef GPU_H
 #define GPU_H
 #include <array>    // std::array
+#include <atomic>   // std::atomic
+#include <future>   // std::future
+#include <memory>   // std::unique_ptr
+#include <mutex>    // std::mutex
 #include <optional> // std::optional
+#include <string>   // std::string
+#include <vector>   // std::vector
 
 #include "nvapi.h"
-
+#include "metric.h"
+
+// One NVIDIA GPU and the data set of its last Update
+//
+// Every driver call of Update and the setters is made on the thread of
+// DriverExecutor::Get, a call from any other thread is queued there and waits for
+// it, so the driver is never entered by two threads at once. The getters may be
+// called from any thread while an update runs, they see the data set of the last
+// one which finished.
 class GPU {
 public:
 	using PCIIdentifiers = std::array<NV_U32, 4>;
+	using PCIIdentifierStrings = std::array<std::string, 4>;
 
 	struct OverclockSetting {
 		bool editable;
@@ -53,11 +68,20 @@ public:
 		float used_memory;
 	};
 
+	// Driver data behind a metric, its last good value is served until it loads again
+	struct MetricStatus {
+		double time;       // MetricTime of the last successful load, 0 when it never loaded
+		NV_STATUS status;  // status of the last attempt to load it
+		double retry;      // MetricTime before which Update does not attempt it again
+	};
+
 	GPU(NV_S32 adapter_index, NV_PHYSICAL_GPU_HANDLE physical_gpu_handle, NV_DISPLAY_HANDLE display_handle);
+	~GPU();
 
 	const std::string &GetName() const;
 	const std::string &GetSerialNumber() const;
 	const PCIIdentifiers &GetPCIIdentifiers() const;
+	const PCIIdentifierStrings &GetPCIIdentifierStrings() const;
 	std::optional<float> GetVoltage() const;
 	std::optional<float> GetTemperature(NV_THERMAL_TARGET target) const;
 	std::optional<Clocks> GetCurrentClocks() const;
@@ -66,19 +90,55 @@ public:
 	std::optional<Clocks> GetBoostClocks() const;
 	std::optional<Usage> GetUsage() const;
 	std::optional<Memory> GetMemory() const;
+	std::optional<float> GetPowerUsage() const;
+	std::optional<OverclockSetting> GetPowerLimit() const;
+	std::optional<OverclockSetting> GetThermalLimit() const;
+	std::optional<float> GetFanLevel() const;
 
 	std::optional<OverclockProfile> GetOverclockProfile() const;
 
+	// Decodes every loaded metric of the last Update into [snapshot] in one pass over
+	// the data set, bumping its sequence and stamping it with the current time
+	void GetSnapshot(Snapshot &snapshot) const;
+
 	bool SetDefaultFanSpeed();
 	bool SetCustomFanSpeed(NV_U32 value);
+	bool SetPowerLimit(float value);
 
+	// Registers interest in [metrics], Update only issues the driver calls needed by the
+	// union of all subscriptions, without any subscriptions everything is loaded
+	NV_U32 Subscribe(MetricSet metrics);
+	void Unsubscribe(NV_U32 subscription);
+	MetricSet GetSubscribedMetrics() const;
+
+	// Loads every needed structure, a structure which fails keeps its last good value and
+	// is retried less and less often once it keeps failing. Returns true when anything was
+	// loaded fresh
 	bool Update();
 
+	MetricStatus GetMetricStatus(Metric metric) const;
+
+	// Queue Update and the setters without waiting, the future holds their result
+	std::future<bool> UpdateAsync();
+	std::future<bool> SetDefaultFanSpeedAsync();
+	std::future<bool> SetCustomFanSpeedAsync(NV_U32 value);
+	std::future<bool> SetPowerLimitAsync(float value);
+
+	// Number of driver calls issued by Update so far
+	uint64_t GetDriverCalls() const;
+
 private:
 	std::optional<Clocks> GetClocks(NV_CLOCK_FREQUENCY_TYPE type, bool compenate_for_over_clock = false) const;
+	NV_U32 GetCoolerCount();
+	void UpdateLoads();
 
 	struct DataSet;
 
+	struct Subscription {
+		NV_U32 id;
+		MetricSet metrics;
+	};
+
 	NV_S32 m_adapter_index;
 	NV_PHYSICAL_GPU_HANDLE m_physical_gpu_handle;
 	NV_DISPLAY_HANDLE m_display_handle;
@@ -86,6 +146,15 @@ private:
 	std::string m_name;
 	std::string m_serial_number;
 	PCIIdentifiers m_pci_identifiers;
+	PCIIdentifierStrings m_pci_identifier_strings;
+	std::atomic<uint64_t> m_driver_calls;
+	std::vector<Subscription> m_subscriptions;
+	NV_U32 m_next_subscription;
+	std::atomic<NV_U32> m_loads;
+
+	// Guards replacing and writing m_data_set on the driver thread against the getters,
+	// the driver thread itself reads it without as nothing else writes it
+	mutable std::mutex m_data_mutex;
 };
 
 inline const std::string &GPU::GetName() const
@@ -103,4 +172,14 @@ inline const GPU::PCIIdentifiers &GPU::GetPCIIdentifiers() const
 	return m_pci_identifiers;
 }
 
+inline const GPU::PCIIdentifierStrings &GPU::GetPCIIdentifierStrings() const
+{
+	return m_pci_identifier_strings;
+}
+
+inline uint64_t GPU::GetDriverCalls() const
+{
+	return m_driver_calls;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include <cmath> // std::fmin, std::fmax, NAN
+
+#include "history.h"
+
+// Level [level] of the pyramid starts at this offset in Series::min and Series::max,
+// level one holds capacity / 2 blocks, level two capacity / 4 blocks and so on
+static std::size_t LevelOffset(std::size_t capacity, int level)
+{
+	return capacity - (capacity >> (level - 1));
+}
+
+History::History(std::size_t capacity, MetricSet metrics)
+	: m_capacity { 1 }
+	, m_levels   { 0 }
+	, m_count    { 0 }
+	, m_sequence { 0 }
+	, m_metrics  { metrics }
+{
+	while (m_capacity < capacity) {
+		m_capacity <<= 1;
+		m_levels++;
+	}
+	m_mask = m_capacity - 1;
+
+	m_times.resize(m_capacity);
+	m_series.resize(static_cast<std::size_t>(Metric::LAST));
+	for (NV_U32 i = 0; i < static_cast<NV_U32>(Metric::LAST); i++) {
+		if (Has(static_cast<Metric>(i))) {
+			auto &series = m_series[i];
+			series.values.resize(m_capacity, NAN);
+			series.min.resize(m_capacity, NAN);
+			series.max.resize(m_capacity, NAN);
+		}
+	}
+}
+
+void History::Add(const Snapshot &snapshot)
+{
+	if (m_count != 0 && snapshot.sequence == m_sequence) {
+		return;
+	}
+
+	const uint64_t index = m_count++;
+	m_sequence = snapshot.sequence;
+	m_times[index & m_mask] = snapshot.time;
+
+	for (NV_U32 i = 0; i < static_cast<NV_U32>(Metric::LAST); i++) {
+		const auto metric = static_cast<Metric>(i);
+		if (!Has(metric)) {
+			continue;
+		}
+
+		auto &series = m_series[i];
+		const float value = snapshot.Has(metric) ? snapshot.Get(metric) : NAN;
+		series.values[index & m_mask] = value;
+
+		// The first sample of a block replaces what the block held a full ring ago,
+		// fmin and fmax ignore NaN so gaps never poison a block
+		for (int level = 1; level <= m_levels; level++) {
+			const std::size_t slot = LevelOffset(m_capacity, level) + ((index >> level) & (m_mask >> level));
+			if ((index & ((uint64_t(1) << level) - 1)) == 0) {
+				series.min[slot] = value;
+				series.max[slot] = value;
+			} else {
+				series.min[slot] = std::fmin(series.min[slot], value);
+				series.max[slot] = std::fmax(series.max[slot], value);
+			}
+		}
+	}
+}
+
+uint64_t History::LowerBound(double time) const
+{
+	// First recorded sample at or after [time], timestamps only ever increase
+	uint64_t first = m_count > m_capacity ? m_count - m_capacity : 0;
+	uint64_t count = m_count - first;
+	while (count > 0) {
+		const uint64_t step = count / 2;
+		const uint64_t middle = first + step;
+		if (m_times[middle & m_mask] < time) {
+			first = middle + 1;
+			count -= step + 1;
+		} else {
+			count = step;
+		}
+	}
+	return first;
+}
+
+void History::Range(const Series &series, uint64_t begin, uint64_t end, float &min, float &max) const
+{
+	// Cover [begin, end) with the largest aligned blocks which fit, a block is only
+	// overwritten once a sample a full ring newer than its start arrives so every
+	// block inside the recorded range is intact
+	while (begin < end) {
+		int level = 0;
+		while (level < m_levels
+			&& (begin & ((uint64_t(2) << level) - 1)) == 0
+			&& begin + (uint64_t(2) << level) <= end)
+		{
+			level++;
+		}
+
+		if (level == 0) {
+			const float value = series.values[begin & m_mask];
+			min = std::fmin(min, value);
+			max = std::fmax(max, value);
+		} else {
+			const std::size_t slot = LevelOffset(m_capacity, level) + ((begin >> level) & (m_mask >> level));
+			min = std::fmin(min, series.min[slot]);
+			max = std::fmax(max, series.max[slot]);
+		}
+
+		begin += uint64_t(1) << level;
+	}
+}
+
+void History::Decimate(Metric metric, double start, double end, int columns, float *min, float *max) const
+{
+	for (int column = 0; column < columns; column++) {
+		min[column] = NAN;
+		max[column] = NAN;
+	}
+
+	if (!Has(metric) || columns <= 0 || end <= start) {
+		return;
+	}
+
+	const auto &series = m_series[static_cast<NV_U32>(metric)];
+	const double width = (end - start) / columns;
+
+	uint64_t begin = LowerBound(start);
+	for (int column = 0; column < columns && begin < m_count; column++) {
+		const uint64_t next = LowerBound(start + width * (column + 1));
+		Range(series, begin, next, min[column], max[column]);
+		begin = next;
+	}
+}
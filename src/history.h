@@ -0,0 +1,75 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+#include <vector> // std::vector
+
+#include "metric.h"
+
+// Metrics a history records unless told otherwise
+constexpr MetricSet HISTORY_METRICS =
+	MetricBit(Metric::TEMPERATURE_GPU) |
+	MetricBit(Metric::CURRENT_CLOCK_CORE) |
+	MetricBit(Metric::CURRENT_CLOCK_MEMORY) |
+	MetricBit(Metric::USAGE_GPU) |
+	MetricBit(Metric::FAN_LEVEL);
+
+// Ring buffer of the most recent snapshots of a GPU
+//
+// Next to the raw values every metric keeps a pyramid of min/max over aligned
+// power of two blocks of samples, so the min/max of any range of samples is
+// found by combining a logarithmic number of blocks. This lets a chart reduce
+// any window of history to one min/max pair per pixel column at a cost that
+// depends on the width of the chart rather than on how many samples it covers.
+class History {
+public:
+	// [capacity] is rounded up to a power of two
+	History(std::size_t capacity = 1 << 14, MetricSet metrics = HISTORY_METRICS);
+
+	// Records [snapshot] unless it was already recorded, metrics missing from the
+	// snapshot are recorded as gaps
+	void Add(const Snapshot &snapshot);
+
+	std::size_t GetSize() const;
+	double GetNewestTime() const;
+	bool Has(Metric metric) const;
+
+	// Splits [start, end) seconds into [columns] equal columns and writes the
+	// min/max of [metric] in each column to [min] and [max], columns without any
+	// samples get NaN for both
+	void Decimate(Metric metric, double start, double end, int columns, float *min, float *max) const;
+
+private:
+	struct Series {
+		std::vector<float> values;   // raw samples, indexed by sample index modulo capacity
+		std::vector<float> min;      // block minimums of every level above the raw samples
+		std::vector<float> max;      // block maximums of every level above the raw samples
+	};
+
+	uint64_t LowerBound(double time) const;
+	void Range(const Series &series, uint64_t begin, uint64_t end, float &min, float &max) const;
+
+	std::size_t m_capacity;
+	std::size_t m_mask;
+	int m_levels;
+	uint64_t m_count;                // samples recorded so far
+	uint64_t m_sequence;             // sequence of the last recorded snapshot
+	MetricSet m_metrics;
+	std::vector<double> m_times;
+	std::vector<Series> m_series;    // indexed by metric, empty for metrics not recorded
+};
+
+inline std::size_t History::GetSize() const
+{
+	return m_count < m_capacity ? static_cast<std::size_t>(m_count) : m_capacity;
+}
+
+inline double History::GetNewestTime() const
+{
+	return m_count ? m_times[(m_count - 1) & m_mask] : 0.0;
+}
+
+inline bool History::Has(Metric metric) const
+{
+	return (m_metrics & MetricBit(metric)) != 0;
+}
+
+#endif
@@ -0,0 +1,87 @@
+#include <cmath> // std::isfinite, std::fabs, std::nearbyint
+
+#include "label.h"
+
+// Powers of ten for every supported number of decimals
+static constexpr uint64_t kScales[] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+static constexpr int kMaxDecimals = sizeof kScales / sizeof *kScales - 1;
+
+size_t FormatFixed(char *buffer, size_t size, std::optional<float> value, int decimals, const char *suffix, const char *prefix)
+{
+	if (size == 0) {
+		return 0;
+	}
+
+	size_t length = 0;
+	auto put = [&](char ch) {
+		if (length + 1 < size) {
+			buffer[length++] = ch;
+		}
+	};
+
+	for (const char *ch = prefix; *ch; ch++) {
+		put(*ch);
+	}
+
+	// Values beyond what fits a 64-bit integer once scaled are not worth printing
+	if (!value || !std::isfinite(*value) || std::fabs(*value) >= 1e12f) {
+		put('-');
+	} else {
+		decimals = decimals < 0 ? 0 : (decimals > kMaxDecimals ? kMaxDecimals : decimals);
+		const uint64_t scale = kScales[decimals];
+		// Ties round to even like printf does
+		const uint64_t scaled = static_cast<uint64_t>(std::nearbyint(std::fabs(static_cast<double>(*value)) * scale));
+
+		// Digits come out backwards, least significant first
+		char digits[32];
+		int count = 0;
+		uint64_t rest = scaled;
+		do {
+			digits[count++] = static_cast<char>('0' + rest % 10);
+			rest /= 10;
+		} while (rest != 0 || count <= decimals);
+
+		if (*value < 0.0f && scaled != 0) {
+			put('-');
+		}
+		while (count > 0) {
+			if (count == decimals) {
+				put('.');
+			}
+			put(digits[--count]);
+		}
+	}
+
+	for (const char *ch = suffix; *ch; ch++) {
+		put(*ch);
+	}
+
+	buffer[length] = '\0';
+	return length;
+}
+
+Label::Label(int decimals, const char *suffix, const char *prefix)
+	: m_decimals  { decimals }
+	, m_suffix    { suffix }
+	, m_prefix    { prefix }
+	, m_formatted { false }
+	, m_text      { }
+{
+}
+
+const char *Label::Format(std::optional<float> value)
+{
+	Update(value);
+	return m_text;
+}
+
+bool Label::Update(std::optional<float> value)
+{
+	if (m_formatted && value == m_value) {
+		return false;
+	}
+	FormatFixed(m_text, sizeof m_text, value, m_decimals, m_suffix, m_prefix);
+	m_value = value;
+	m_formatted = true;
+	return true;
+}
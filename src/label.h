@@ -0,0 +1,37 @@
+#ifndef LABEL_H
+#define LABEL_H
+#include <stddef.h> // size_t
+#include <stdint.h>
+#include <optional> // std::optional
+
+// Writes [prefix], [value] with [decimals] fixed decimals and [suffix] to [buffer]
+// without going through printf, a missing or non finite value is written as "-".
+// Returns the length of the text, which is truncated to fit [size]
+size_t FormatFixed(char *buffer, size_t size, std::optional<float> value, int decimals, const char *suffix = "", const char *prefix = "");
+
+// Text of a value which is only reformatted when the value changes
+class Label {
+public:
+	Label(int decimals = 0, const char *suffix = "", const char *prefix = "");
+
+	const char *Format(std::optional<float> value);
+
+	// Reformats the text when [value] changed, returns true if it did
+	bool Update(std::optional<float> value);
+	const char *Get() const;
+
+private:
+	int m_decimals;
+	const char *m_suffix;
+	const char *m_prefix;
+	bool m_formatted;
+	std::optional<float> m_value;
+	char m_text[64];
+};
+
+inline const char *Label::Get() const
+{
+	return m_text;
+}
+
+#endif
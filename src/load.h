@@ -0,0 +1,180 @@
+#ifndef LOAD_H
+#define LOAD_H
+
+#include "nvapi.h"
+#include "metric.h"
+
+// Every NvAPI structure Update can load, one driver call each
+enum : NV_U32 {
+	LOAD_CURRENT_FREQUENCIES      = 1 << 0,
+	LOAD_BASE_FREQUENCIES         = 1 << 1,
+	LOAD_BOOST_FREQUENCIES        = 1 << 2,
+	LOAD_DYNAMIC_PSTATES          = 1 << 3,
+	LOAD_PSTATES20                = 1 << 4,
+	LOAD_POWER_POLICIES_INFO      = 1 << 5,
+	LOAD_POWER_POLICIES_STATUS    = 1 << 6,
+	LOAD_POWER_TOPOLOGY_STATUS    = 1 << 7,
+	LOAD_VOLTAGE_DOMAINS_STATUS   = 1 << 8,
+	LOAD_THERMAL_SETTINGS         = 1 << 9,
+	LOAD_THERMAL_POLICIES_INFO    = 1 << 10,
+	LOAD_THERMAL_POLICIES_STATUS  = 1 << 11,
+	LOAD_COOLER_SETTINGS          = 1 << 12,
+	LOAD_MEMORY_INFO              = 1 << 13,
+	LOAD_COUNT                    = 14,
+	LOAD_ALL                      = (1 << LOAD_COUNT) - 1,
+
+	// Power status and topology are not exposed by every board, so failing to load them
+	// should not throw away the rest of an embedded GPU's data
+	LOAD_OPTIONAL = LOAD_POWER_POLICIES_STATUS | LOAD_POWER_TOPOLOGY_STATUS
+};
+
+constexpr NV_U32 GetLoadsForMetric(Metric metric)
+{
+	switch (metric) {
+	case Metric::TEMPERATURE_GPU:
+	case Metric::TEMPERATURE_MEMORY:
+	case Metric::TEMPERATURE_POWER_SUPPLY:
+	case Metric::TEMPERATURE_BOARD:
+		return LOAD_THERMAL_SETTINGS;
+	case Metric::VOLTAGE:
+		return LOAD_VOLTAGE_DOMAINS_STATUS;
+	case Metric::CURRENT_CLOCK_CORE:
+	case Metric::CURRENT_CLOCK_MEMORY:
+	case Metric::CURRENT_CLOCK_SHADER:
+		return LOAD_CURRENT_FREQUENCIES;
+	case Metric::BASE_CLOCK_CORE:
+	case Metric::BASE_CLOCK_MEMORY:
+	case Metric::BASE_CLOCK_SHADER:
+		return LOAD_BASE_FREQUENCIES;
+	case Metric::BOOST_CLOCK_CORE:
+	case Metric::BOOST_CLOCK_MEMORY:
+	case Metric::BOOST_CLOCK_SHADER:
+		return LOAD_BOOST_FREQUENCIES;
+	case Metric::USAGE_GPU:
+	case Metric::USAGE_FB:
+	case Metric::USAGE_VID:
+	case Metric::USAGE_BUS:
+		return LOAD_DYNAMIC_PSTATES;
+	case Metric::MEMORY_TOTAL:
+	case Metric::MEMORY_FREE:
+	case Metric::MEMORY_USED:
+		return LOAD_MEMORY_INFO;
+	case Metric::POWER_USAGE:
+		return LOAD_POWER_TOPOLOGY_STATUS;
+	case Metric::POWER_LIMIT:
+		return LOAD_POWER_POLICIES_INFO | LOAD_POWER_POLICIES_STATUS;
+	case Metric::THERMAL_LIMIT:
+		return LOAD_THERMAL_POLICIES_INFO | LOAD_THERMAL_POLICIES_STATUS;
+	case Metric::FAN_LEVEL:
+		return LOAD_COOLER_SETTINGS;
+	case Metric::LAST:
+		break;
+	}
+	return 0;
+}
+
+constexpr NV_U32 GetLoadsForMetrics(MetricSet metrics)
+{
+	NV_U32 loads = 0;
+	for (NV_U32 i = 0; i < static_cast<NV_U32>(Metric::LAST); i++) {
+		if (metrics & MetricBit(static_cast<Metric>(i))) {
+			loads |= GetLoadsForMetric(static_cast<Metric>(i));
+		}
+	}
+	return loads;
+}
+
+// Fetch one NvAPI structure each, returning the status the driver answered with
+
+inline NV_STATUS LoadClockFrequencies(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_CLOCK_FREQUENCIES_V2 *frequencies,
+	NV_CLOCK_FREQUENCY_TYPE type)
+{
+	*frequencies = {};
+	frequencies->clock_type = static_cast<NV_U32>(type);
+	return NvAPI_GPU_GetAllClockFrequencies(physical_gpu_handle, frequencies);
+}
+
+inline NV_STATUS LoadGPUThermalSettingsV2(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_THERMAL_SETTINGS_V2 *thermal_settings)
+{
+	*thermal_settings = {};
+	return NvAPI_GPU_GetThermalSettings(physical_gpu_handle, NV_THERMAL_TARGET::ALL, thermal_settings);
+}
+
+inline NV_STATUS LoadGPUDynamicPStates(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_DYNAMIC_PSTATES_V1 *pstates)
+{
+	*pstates = {};
+	return NvAPI_GPU_GetDynamicPStates(physical_gpu_handle, pstates);
+}
+
+inline NV_STATUS LoadGPUPStates20V2(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_PSTATES20_V2 *pstates20)
+{
+	*pstates20 = { };
+	return NvAPI_GPU_GetPStates20(physical_gpu_handle, pstates20);
+}
+
+inline NV_STATUS LoadGPUPowerPoliciesInfo(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_POLICIES_INFO_V1 *power_policies_info)
+{
+	*power_policies_info = {};
+	return NvAPI_GPU_GetPowerPoliciesInfo(physical_gpu_handle, power_policies_info);
+}
+
+inline NV_STATUS LoadGPUPowerPoliciesStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_POLICIES_STATUS_V1 *power_policies_status)
+{
+	*power_policies_status = {};
+	return NvAPI_GPU_GetPowerPoliciesStatus(physical_gpu_handle, power_policies_status);
+}
+
+inline NV_STATUS LoadGPUPowerTopologyStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_TOPOLOGY_STATUS_V1 *power_topology_status)
+{
+	*power_topology_status = {};
+	return NvAPI_GPU_ClientPowerTopologyGetStatus(physical_gpu_handle, power_topology_status);
+}
+
+inline NV_STATUS LoadGPUVoltageDomainsStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_VOLTAGE_DOMAINS_STATUS_V1 *voltage_domain_status)
+{
+	*voltage_domain_status = {};
+	return NvAPI_GPU_GetVoltageDomainStatus(physical_gpu_handle, voltage_domain_status);
+}
+
+inline NV_STATUS LoadGPUThermalPoliciesInfoV2(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_THERMAL_POLICIES_INFO_V2 *thermal_policies_info)
+{
+	*thermal_policies_info = {};
+	return NvAPI_GPU_GetThermalPoliciesInfo(physical_gpu_handle, thermal_policies_info);
+}
+
+inline NV_STATUS LoadGPUThermalPoliciesStatusV2(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+    NV_GPU_THERMAL_POLICIES_STATUS_V2 *thermal_policies_status)
+{
+	*thermal_policies_status = {};
+	return NvAPI_GPU_GetThermalPoliciesStatus(physical_gpu_handle, thermal_policies_status);
+}
+
+inline NV_STATUS LoadGPUCoolerSettingsV2(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_S32 cooler_index,
+	NV_GPU_COOLER_SETTINGS_V2 *cooler_settings)
+{
+	*cooler_settings = {};
+	return NvAPI_GPU_GetCoolerSettings(physical_gpu_handle, cooler_index, cooler_settings);
+}
+
+#endif
@@ -1,9 +1,17 @@
 #include <algorithm>
+#include <stdlib.h>
+#include <string.h>
 #include <unordered_map>
 
 #include "nvapi.h"
+#include "nvapi_fault.h"
 #include "log.h"
 #include "gpu.h"
+#include "publisher.h"
+#include "sampler.h"
+#include "history.h"
+#include "view.h"
+#include "timing.h"
 
 static const char *ThermalController(NV_THERMAL_CONTROLLER controller) {
 	switch (controller) {
@@ -64,12 +72,69 @@ static const char *ThermalTarget(NV_THERMAL_TARGET target) {
 #define NK_PRIVATE
 #include "nuklear.h"
 
+#ifdef _WIN32
+// The five detail charts stroke two points of 4 bytes per column, ui_bench measures 42 bytes per pixel of width
+#define NK_GDI_MEMORY_PER_PIXEL 48
 #define NK_GDI_IMPLEMENTATION
 #include "nuklear_gdi.h"
+#else
+#define NK_RASTER_IMPLEMENTATION
+#include "nuklear_raster.h"
+
+#define NK_X11_IMPLEMENTATION
+#include "nuklear_x11.h"
+#endif
+
+#include "ui.h"
 
 int WINDOW_WIDTH = 650;
 int WINDOW_HEIGHT = 400;
 
+// F3 toggles the timing panel, F4 writes the timing to TIMING_DUMP
+static bool g_show_timing = false;
+static constexpr const char *TIMING_DUMP = "nvfc-timing.json";
+
+static void DumpTiming(const FrameTiming &timing, const char *path)
+{
+	if (timing.Dump(path)) {
+		Log::write("wrote frame timing to %s", path);
+	} else {
+		Log::write("failed to write frame timing to %s", path);
+	}
+}
+
+static void TimingPanel(struct nk_context *ctx, const FrameTiming &timing)
+{
+	const struct nk_rect bounds = nk_rect(static_cast<float>(WINDOW_WIDTH - 360), 40, 350, 240);
+	if (nk_begin(ctx, "Timing", bounds, NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_TITLE | NK_WINDOW_NO_SCROLLBAR)) {
+		static const char *header[] = { "us", "last", "p50", "p99", "max" };
+		nk_layout_row_begin(ctx, NK_STATIC, 16, 5);
+		for (std::size_t i = 0; i < 5; i++) {
+			nk_layout_row_push(ctx, i == 0 ? 100.0f : 55.0f);
+			nk_label(ctx, header[i], i == 0 ? NK_TEXT_LEFT : NK_TEXT_RIGHT);
+		}
+		nk_layout_row_end(ctx);
+
+		for (uint32_t stage = 0; stage < static_cast<uint32_t>(Stage::LAST); stage++) {
+			const Histogram &histogram = timing.Get(static_cast<Stage>(stage));
+			const double values[] = { histogram.GetLast(), histogram.GetPercentile(50.0), histogram.GetPercentile(99.0), histogram.GetMax() };
+
+			nk_layout_row_begin(ctx, NK_STATIC, 16, 5);
+			nk_layout_row_push(ctx, 100);
+			nk_label(ctx, StageName(static_cast<Stage>(stage)), NK_TEXT_LEFT);
+			for (double value : values) {
+				char text[32];
+				snprintf(text, sizeof text, "%.0f", value * 1e6);
+				nk_layout_row_push(ctx, 55);
+				nk_label(ctx, text, NK_TEXT_RIGHT);
+			}
+			nk_layout_row_end(ctx);
+		}
+	}
+	nk_end(ctx);
+}
+
+#ifdef _WIN32
 static LRESULT CALLBACK
 WindowProc(HWND wnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
@@ -97,10 +162,15 @@ int WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, char*, int nShowCmd)
 	main();
 }
 
+#endif
+
 int main() {
-	GdiFont* font;
 	struct nk_context *ctx;
+	int running = 1;
+	int needs_refresh = 1;
 
+#ifdef _WIN32
+	GdiFont* font;
 	WNDCLASSW wc;
 	ATOM atom;
 	RECT rect = { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT };
@@ -108,8 +178,6 @@ int main() {
 	DWORD exstyle = WS_EX_APPWINDOW;
 	HWND wnd;
 	HDC dc;
-	int running = 1;
-	int needs_refresh = 1;
 
 	memset(&wc, 0, sizeof(wc));
 	wc.style = CS_DBLCLKS;
@@ -130,9 +198,36 @@ int main() {
 	/* GUI */
 	font = nk_gdifont_create("Roboto", 18);
 	ctx = nk_gdi_init(font, dc, WINDOW_WIDTH, WINDOW_HEIGHT);
+#else
+	Display *display = XOpenDisplay(NULL);
+	if (!display) {
+		Log::write("failed to open display '%s'", XDisplayName(NULL));
+		return 1;
+	}
+
+	Window wnd = XCreateSimpleWindow(display, DefaultRootWindow(display), 0, 0,
+		WINDOW_WIDTH, WINDOW_HEIGHT, 0, 0, BlackPixel(display, DefaultScreen(display)));
+	XSelectInput(display, wnd, ExposureMask | StructureNotifyMask | KeyPressMask | KeyReleaseMask
+		| ButtonPressMask | ButtonReleaseMask | PointerMotionMask);
+	XStoreName(display, wnd, "NVFC");
+
+	// Closing the window is a message from the window manager rather than the window being destroyed
+	Atom wm_delete_window = XInternAtom(display, "WM_DELETE_WINDOW", False);
+	XSetWMProtocols(display, wnd, &wm_delete_window, 1);
+	XMapWindow(display, wnd);
+
+	/* GUI */
+	ctx = nk_x11_init(display, wnd, WINDOW_WIDTH, WINDOW_HEIGHT);
+	Log::write("presenting frames %s", nk_x11_is_shared() ? "through MIT-SHM" : "with XPutImage");
+#endif
 
 	NV_STATUS initialize = NvAPI_Initialize();
 
+	// Serve repeated driver reads from memory for this many seconds
+	if (const char *window = getenv("NVFC_CACHE")) {
+		NvAPI_SetCacheWindow(atof(window));
+	}
+
 	NV_SHORT_STRING version = {};
 	if (NvAPI_GetInterfaceVersionString(version) == 0) {
 		Log::write("NvAPI version: %s", version);
@@ -171,215 +266,135 @@ int main() {
 		}
 	}
 
-	int close = 0;
-	int once = 0;
+	// Sample quickly while the cards are busy or close to throttling and back off when idle
+	Sampler sampler({ 0.1, 2.0, { { Metric::TEMPERATURE_GPU, 85.0f, 5.0f } } });
+	for (GPU *gpu : gpus) {
+		sampler.Add(gpu);
+	}
+
+	NameTabs(gpus.size());
+
+	std::vector<History> histories(gpus.size());
+	std::vector<GPUView> views(gpus.size());
+
+	// Every stage of the loop is timed, samples and input are timed until the frame showing them is presented
+	FrameTiming timing;
+	double newest_sample = 0.0;
+
+	// Histories and views only hear about the GPUs which were actually sampled
+	Publisher publisher;
+	publisher.Subscribe(-1, ALL_METRICS, [&](std::size_t gpu, const Snapshot &snapshot) {
+		histories[gpu].Add(snapshot);
+		views[gpu].Update(snapshot);
+		newest_sample = std::max(newest_sample, snapshot.time);
+	});
+	sampler.Attach(&publisher);
+
 	while (running) {
+		const double frame_start = MetricTime();
+		bool input = false;
+
 		nk_input_begin(ctx);
+#ifdef _WIN32
 		MSG msg;
 		if (PeekMessageW(&msg, NULL, 0, 0, PM_REMOVE)) {
 			if (msg.message == WM_QUIT) {
 				running = 0;
 			} else {
+				if (msg.message == WM_KEYDOWN && msg.wParam == VK_F3) {
+					g_show_timing = !g_show_timing;
+				} else if (msg.message == WM_KEYDOWN && msg.wParam == VK_F4) {
+					DumpTiming(timing, TIMING_DUMP);
+				}
+				input = (msg.message >= WM_KEYFIRST && msg.message <= WM_KEYLAST)
+					|| (msg.message >= WM_MOUSEFIRST && msg.message <= WM_MOUSELAST);
 				TranslateMessage(&msg);
 				DispatchMessageW(&msg);
 			}
 		}
-		nk_input_end(ctx);
-
-		struct nk_style *s = &ctx->style;
-		s->text.color = nk_rgba(255, 255, 255, 255);
-		s->window.border_color = nk_rgba(45, 45, 45, 255);
-		s->window.header.active = nk_style_item_color(nk_rgba(45, 45, 45, 255));
-		s->window.background = nk_rgba(50, 57, 61, 255);
-		s->window.fixed_background = nk_style_item_color(nk_rgba(50, 57, 61, 255));
-
-		for (GPU *gpu : gpus) {
-			gpu->Update();
-
-			if (close) break;
-
-			std::string name = gpu->GetName();
-
-			if (nk_window_is_closed(ctx, &name[0])) {
-				if (!once) once = 1; else running = 0;
+#else
+		while (XPending(display)) {
+			XEvent event;
+			XNextEvent(display, &event);
+			if (event.type == ClientMessage && static_cast<Atom>(event.xclient.data.l[0]) == wm_delete_window) {
+				running = 0;
+			} else if (event.type == ConfigureNotify) {
+				WINDOW_WIDTH = event.xconfigure.width;
+				WINDOW_HEIGHT = event.xconfigure.height;
+			} else if (event.type == KeyPress && XLookupKeysym(&event.xkey, 0) == XK_F3) {
+				g_show_timing = !g_show_timing;
+			} else if (event.type == KeyPress && XLookupKeysym(&event.xkey, 0) == XK_F4) {
+				DumpTiming(timing, TIMING_DUMP);
 			}
+			input |= event.type == KeyPress || event.type == KeyRelease || event.type == ButtonPress
+				|| event.type == ButtonRelease || event.type == MotionNotify;
+			nk_x11_handle_event(&event);
+		}
+#endif
+		nk_input_end(ctx);
+		const double pumped = MetricTime();
 
-			if (nk_begin(ctx, &name[0], nk_rect(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT),
-				NK_WINDOW_BORDER||NK_WINDOW_TITLE))
-			{
-				nk_layout_row_begin(ctx, NK_STATIC, 16, 2);
-				{
-					nk_layout_row_push(ctx, 150);
-					nk_label(ctx, "Serial:", NK_TEXT_LEFT);
-
-					nk_layout_row_push(ctx, 100);
-					nk_label(ctx, gpu->GetSerialNumber().c_str(), NK_TEXT_LEFT);
-				}
-				nk_layout_row_end(ctx);
-
-				auto identifiers = gpu->GetPCIIdentifiers();
-				nk_layout_row_begin(ctx, NK_STATIC, 16, 8);
-				{
-					nk_layout_row_push(ctx, 150);
-					nk_label(ctx, "PCI:", NK_TEXT_LEFT);
-
-					char buffer[1024];
-					nk_layout_row_push(ctx, 100);
-					snprintf(buffer, sizeof buffer, "0x%08x", identifiers[0]);
-					nk_label(ctx, buffer, NK_TEXT_LEFT);
-
-					nk_layout_row_push(ctx, 100);
-					snprintf(buffer, sizeof buffer, "0x%08x", identifiers[1]);
-					nk_label(ctx, buffer, NK_TEXT_LEFT);
-
-					nk_layout_row_push(ctx, 100);
-					snprintf(buffer, sizeof buffer, "0x%08x", identifiers[2]);
-					nk_label(ctx, buffer, NK_TEXT_LEFT);
-
-					nk_layout_row_push(ctx, 100);
-					snprintf(buffer, sizeof buffer, "0x%08x", identifiers[3]);
-					nk_label(ctx, buffer, NK_TEXT_LEFT);
-				}
-				nk_layout_row_end(ctx);
-
-				auto temp_gpu          = gpu->GetTemperature(NV_THERMAL_TARGET::GPU);
-				auto temp_memory       = gpu->GetTemperature(NV_THERMAL_TARGET::MEMORY);
-				auto temp_power_supply = gpu->GetTemperature(NV_THERMAL_TARGET::POWER_SUPPLY);
-				auto temp_board        = gpu->GetTemperature(NV_THERMAL_TARGET::BOARD);
-
-				auto temp = [&](const char *type, float value) {
-					nk_layout_row_begin(ctx, NK_STATIC, 16, 3);
-					{
-						nk_layout_row_push(ctx, 150);
-						nk_label(ctx, "Temperature:", NK_TEXT_LEFT);
-
-						char fmt[1024];
-						snprintf(fmt, sizeof fmt, "%.2fC", value);
-						nk_layout_row_push(ctx, 100); // 100px
-						nk_label(ctx, fmt, NK_TEXT_LEFT);
-
-						nk_layout_row_push(ctx, 100);
-						nk_label(ctx, type, NK_TEXT_LEFT);
-					}
-					nk_layout_row_end(ctx);
-				};
-
-				if (temp_gpu)          temp("GPU", *temp_gpu);
-				if (temp_memory)       temp("MEMORY", *temp_memory);
-				if (temp_power_supply) temp("POWER SUPPLY", *temp_power_supply);
-				if (temp_board)        temp("BOARD", *temp_board);
-
-				auto voltage = gpu->GetVoltage();
-				if (voltage) {
-					nk_layout_row_begin(ctx, NK_STATIC, 16, 2);
-					{
-						nk_layout_row_push(ctx, 150);
-						nk_label(ctx, "Voltage:", NK_TEXT_LEFT);
-
-						char format[1024];
-						snprintf(format, sizeof format, "%.2fV", *voltage);
-
-						nk_layout_row_push(ctx, 100);
-						nk_label(ctx, format, NK_TEXT_LEFT);
-					}
-					nk_layout_row_end(ctx);		
-				}
+		const bool sampled = sampler.Poll(pumped);
+		const double polled = MetricTime();
 
-				auto current_clocks = gpu->GetCurrentClocks();
-				auto base_clocks = gpu->GetBaseClocks();
-				auto boost_clocks = gpu->GetBoostClocks();
-
-				auto clock = [&](const char *line, const char *type, float value) {
-					nk_layout_row_begin(ctx, NK_STATIC, 16, 3);
-					{
-						nk_layout_row_push(ctx, 150);
-						nk_label(ctx, line, NK_TEXT_LEFT);
-
-						char fmt[1024];
-						snprintf(fmt, sizeof fmt, "%.2f MHz", value);
-						nk_layout_row_push(ctx, 100); // 100px
-						nk_label(ctx, fmt, NK_TEXT_LEFT);
-
-						nk_layout_row_push(ctx, 100);
-						nk_label(ctx, type, NK_TEXT_LEFT);
-					}
-					nk_layout_row_end(ctx);
-				};
-
-				if (current_clocks->core_clock)    clock("Current Clock:", "CORE", *current_clocks->core_clock);//Log::write(" Current Clock: %.2f MHz (Core)", *current_clocks->core_clock);
-				if (current_clocks->memory_clock)  clock("Current Clock:", "MEMORY", *current_clocks->memory_clock);//Log::write(" Current Clock: %.2f MHz (Memory)", *current_clocks->memory_clock);
-				if (current_clocks->shader_clock)  clock("Current Clock:", "SHADER", *current_clocks->shader_clock);//Log::write(" Current Clock: %.2f MHz (Shader)", *current_clocks->shader_clock);
-				if (base_clocks->core_clock)       clock("Base Clock:",    "CORE", *base_clocks->core_clock);//Log::write(" Base Clock:    %.2f MHz (Core)", *base_clocks->core_clock);
-				if (base_clocks->memory_clock)     clock("Base Clock:",    "MEMORY", *base_clocks->memory_clock);//Log::write(" Base Clock:    %.2f MHz (Memory)", *base_clocks->memory_clock);
-				if (base_clocks->shader_clock)     clock("Base Clock:",    "SHADER", *base_clocks->shader_clock);//Log::write(" Base Clock:    %.2f MHz (Shader)", *base_clocks->shader_clock);
-				if (boost_clocks->core_clock)      clock("Boost Clock:",   "CORE", *boost_clocks->core_clock);//Log::write(" boost Clock:    %.2f MHz (Core)", *boost_clocks->core_clock);
-				if (boost_clocks->memory_clock)    clock("Boost Clock:",   "MEMORY", *boost_clocks->memory_clock);//Log::write(" boost Clock:    %.2f MHz (Memory)", *boost_clocks->memory_clock);
-				if (boost_clocks->shader_clock)    clock("Boost Clock:",   "SHADER", *boost_clocks->shader_clock);//Log::write(" boost Clock:    %.2f MHz (Shader)", *boost_clocks->shader_clock);
-
-				auto usage_widget = [&](const char *type, float usage) {
-					nk_layout_row_begin(ctx, NK_STATIC, 16, 2);
-					{
-						nk_layout_row_push(ctx, 150);
-						nk_label(ctx, type, NK_TEXT_LEFT);
-
-						char format[1024];
-						snprintf(format, sizeof format, "%.2f%%", usage);
-
-						nk_layout_row_push(ctx, 150);
-						nk_label(ctx, format, NK_TEXT_LEFT);
-					}
-					nk_layout_row_end(ctx);		
-				};
-
-				auto usage = gpu->GetUsage();
-				if (usage) {
-					if (usage->gpu_usage) usage_widget("GPU:", *usage->gpu_usage);
-					if (usage->fb_usage)  usage_widget("Framebuffer:", *usage->fb_usage);
-					if (usage->vid_usage) usage_widget("Video Engine:", *usage->vid_usage);
-					if (usage->bus_usage) usage_widget("Bus:", *usage->bus_usage);
-				}
+		MainWindow(ctx, nk_rect(0, 0, static_cast<float>(WINDOW_WIDTH), static_cast<float>(WINDOW_HEIGHT)), gpus, histories, views, sampler);
 
-				auto memory_widget = [&](const char *type, float value) {
-					nk_layout_row_begin(ctx, NK_STATIC, 16, 2);
-					{
-						nk_layout_row_push(ctx, 150);
-						nk_label(ctx, type, NK_TEXT_LEFT);
-
-						char fmt[1024];
-						snprintf(fmt, sizeof fmt, "%.2f MiB", value);
-						nk_layout_row_push(ctx, 150); // 100px
-						nk_label(ctx, fmt, NK_TEXT_LEFT);
-					}
-					nk_layout_row_end(ctx);
-				};
-
-				auto memory = gpu->GetMemory();
-				if (memory) {
-					memory_widget("Total Memory:", memory->total_memory);
-					memory_widget("Free Memory:", memory->free_memory);
-					memory_widget("Used Memory:", memory->used_memory);
-
-					nk_layout_row_begin(ctx, NK_STATIC, 16, 2);
-					{
-						nk_layout_row_push(ctx, 150);
-						nk_label(ctx, "Memory Load:", NK_TEXT_LEFT);
-
-						char fmt[1024];
-						snprintf(fmt, sizeof fmt, "%.2f%%", 100.0f * memory->used_memory / memory->total_memory);
-						nk_layout_row_push(ctx, 150); // 100px
-						nk_label(ctx, fmt, NK_TEXT_LEFT);
-					}
-					nk_layout_row_end(ctx);
-				}
-			}
-			nk_end(ctx);
+		if (g_show_timing) {
+			TimingPanel(ctx, timing);
+		}
+		const double built = MetricTime();
+
+#ifdef _WIN32
+		nk_gdi_draw(nk_rgb(45,45,45));
+		const double rendered = MetricTime();
+		nk_gdi_present();
+		const double presented = MetricTime();
+
+		const struct nk_gdi_stats stats = nk_gdi_get_stats();
+		if (stats.memory_exhausted) {
+			Log::write("nuklear arena exhausted after %llu bytes, grew it to %llu bytes",
+				static_cast<unsigned long long>(stats.memory_peak),
+				static_cast<unsigned long long>(stats.memory_size));
+		}
+#else
+		nk_x11_draw(nk_rgb(45,45,45));
+		const double rendered = MetricTime();
+		nk_x11_present();
+		const double presented = MetricTime();
+#endif
 
-			break;
+		timing.Record(Stage::PUMP, pumped - frame_start);
+		timing.Record(Stage::POLL, polled - pumped);
+		timing.Record(Stage::BUILD, built - polled);
+		timing.Record(Stage::RENDER, rendered - built);
+		timing.Record(Stage::BLIT, presented - rendered);
+		timing.Record(Stage::FRAME, presented - frame_start);
+		if (sampled) {
+			timing.Record(Stage::SAMPLE_AGE, presented - newest_sample);
 		}
+		if (input) {
+			timing.Record(Stage::INPUT_LATENCY, presented - frame_start);
+		}
+	}
 
-		nk_gdi_render(nk_rgb(45,45,45));
+	sampler.LogReport();
+	NvAPI_LogCacheStats();
+	NvFaultLogStats();
+	if (const char *path = getenv("NVFC_TIMING")) {
+		DumpTiming(timing, path);
 	}
 
+#ifdef _WIN32
+	const struct nk_gdi_stats stats = nk_gdi_get_stats();
+	Log::write("nuklear arena peaked at %llu of %llu bytes",
+		static_cast<unsigned long long>(stats.memory_peak),
+		static_cast<unsigned long long>(stats.memory_size));
+#else
+	nk_x11_shutdown();
+	XDestroyWindow(display, wnd);
+	XCloseDisplay(display);
+#endif
+
 #if 0
 	
 
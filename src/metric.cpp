@@ -0,0 +1,68 @@
+#include <chrono> // std::chrono::steady_clock
+
+#include "metric.h"
+
+const char *MetricName(Metric metric)
+{
+	switch (metric) {
+	case Metric::TEMPERATURE_GPU:
+		return "gpu temperature";
+	case Metric::TEMPERATURE_MEMORY:
+		return "memory temperature";
+	case Metric::TEMPERATURE_POWER_SUPPLY:
+		return "power supply temperature";
+	case Metric::TEMPERATURE_BOARD:
+		return "board temperature";
+	case Metric::VOLTAGE:
+		return "voltage";
+	case Metric::CURRENT_CLOCK_CORE:
+		return "current core clock";
+	case Metric::CURRENT_CLOCK_MEMORY:
+		return "current memory clock";
+	case Metric::CURRENT_CLOCK_SHADER:
+		return "current shader clock";
+	case Metric::BASE_CLOCK_CORE:
+		return "base core clock";
+	case Metric::BASE_CLOCK_MEMORY:
+		return "base memory clock";
+	case Metric::BASE_CLOCK_SHADER:
+		return "base shader clock";
+	case Metric::BOOST_CLOCK_CORE:
+		return "boost core clock";
+	case Metric::BOOST_CLOCK_MEMORY:
+		return "boost memory clock";
+	case Metric::BOOST_CLOCK_SHADER:
+		return "boost shader clock";
+	case Metric::USAGE_GPU:
+		return "gpu usage";
+	case Metric::USAGE_FB:
+		return "framebuffer usage";
+	case Metric::USAGE_VID:
+		return "video engine usage";
+	case Metric::USAGE_BUS:
+		return "bus usage";
+	case Metric::MEMORY_TOTAL:
+		return "total memory";
+	case Metric::MEMORY_FREE:
+		return "free memory";
+	case Metric::MEMORY_USED:
+		return "used memory";
+	case Metric::POWER_USAGE:
+		return "power usage";
+	case Metric::POWER_LIMIT:
+		return "power limit";
+	case Metric::THERMAL_LIMIT:
+		return "thermal limit";
+	case Metric::FAN_LEVEL:
+		return "fan level";
+	case Metric::LAST:
+		break;
+	}
+	return "unknown";
+}
+
+double MetricTime()
+{
+	using namespace std::chrono;
+	return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,81 @@
+#ifndef METRIC_H
+#define METRIC_H
+#include <stdint.h>
+#include <type_traits> // std::is_trivially_copyable
+
+#include "nvapi.h"
+
+// Every value NVFC can decode from a GPU
+enum class Metric : NV_U32 {
+	TEMPERATURE_GPU,
+	TEMPERATURE_MEMORY,
+	TEMPERATURE_POWER_SUPPLY,
+	TEMPERATURE_BOARD,
+	VOLTAGE,
+	CURRENT_CLOCK_CORE,
+	CURRENT_CLOCK_MEMORY,
+	CURRENT_CLOCK_SHADER,
+	BASE_CLOCK_CORE,
+	BASE_CLOCK_MEMORY,
+	BASE_CLOCK_SHADER,
+	BOOST_CLOCK_CORE,
+	BOOST_CLOCK_MEMORY,
+	BOOST_CLOCK_SHADER,
+	USAGE_GPU,
+	USAGE_FB,
+	USAGE_VID,
+	USAGE_BUS,
+	MEMORY_TOTAL,
+	MEMORY_FREE,
+	MEMORY_USED,
+	POWER_USAGE,
+	POWER_LIMIT,
+	THERMAL_LIMIT,
+	FAN_LEVEL,
+	LAST
+};
+
+// Bitmask of metrics, bit N is set for the metric with the value N
+typedef uint64_t MetricSet;
+
+static_assert(static_cast<NV_U32>(Metric::LAST) <= 64, "MetricSet cannot hold every metric");
+
+constexpr MetricSet MetricBit(Metric metric)
+{
+	return MetricSet(1) << static_cast<NV_U32>(metric);
+}
+
+constexpr MetricSet ALL_METRICS = (MetricSet(1) << static_cast<NV_U32>(Metric::LAST)) - 1;
+
+// Every decoded metric of a GPU at one point in time
+//
+// Plain data aligned to a cache line, so copying a snapshot is a memcpy of two
+// cache lines
+struct alignas(64) Snapshot {
+	uint64_t sequence;                                   // incremented every time the snapshot is refilled
+	double time;                                         // seconds on a monotonic clock
+	MetricSet present;                                   // metrics which have a valid value
+	float values[static_cast<NV_U32>(Metric::LAST)];
+
+	bool Has(Metric metric) const;
+	float Get(Metric metric) const;
+};
+
+static_assert(std::is_trivially_copyable<Snapshot>::value, "Snapshot must stay plain data");
+
+inline bool Snapshot::Has(Metric metric) const
+{
+	return (present & MetricBit(metric)) != 0;
+}
+
+inline float Snapshot::Get(Metric metric) const
+{
+	return values[static_cast<NV_U32>(metric)];
+}
+
+const char *MetricName(Metric metric);
+
+// Seconds on a monotonic clock
+double MetricTime();
+
+#endif
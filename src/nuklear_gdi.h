@@ -22,6 +22,23 @@ NK_API int nk_gdi_handle_event(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam
 NK_API void nk_gdi_render(struct nk_color clear);
 NK_API void nk_gdi_shutdown(void);
 
+/* nk_gdi_render in two halves, drawing into the back buffer and copying it
+ * to the window, so each can be timed on its own */
+NK_API void nk_gdi_draw(struct nk_color clear);
+NK_API void nk_gdi_present(void);
+
+/* GDI object and context memory usage of the last rendered frame */
+struct nk_gdi_stats {
+    unsigned int cache_hits;
+    unsigned int cache_misses;
+    unsigned int objects_created;
+    nk_size memory_size;     /* size of the context arena */
+    nk_size memory_used;     /* arena used by the frame, commands plus windows */
+    nk_size memory_peak;     /* most arena any frame used so far */
+    int memory_exhausted;    /* the frame ran out of arena, it was regrown to memory_size */
+};
+NK_API struct nk_gdi_stats nk_gdi_get_stats(void);
+
 /* font */
 NK_API GdiFont* nk_gdifont_create(const char *name, int size);
 NK_API void nk_gdifont_del(GdiFont *font);
@@ -40,20 +57,79 @@ NK_API void nk_gdi_set_font(GdiFont *font);
 
 #include <stdlib.h>
 #include <malloc.h>
+#include <string.h>
+
+/* Initial size of the fixed arena the context builds frames in, plus
+ * NK_GDI_MEMORY_PER_PIXEL bytes for every pixel of the widest window the
+ * desktop fits. Frames whose commands grow with the window width, like
+ * charts stroking a few points per column, set that so a maximized window
+ * still fits. An exhausted arena is replaced by a larger one before the next
+ * frame, which drops all window state: scroll offsets, collapsed and moved
+ * windows start over once */
+#ifndef NK_GDI_MEMORY_SIZE
+#define NK_GDI_MEMORY_SIZE (64 * 1024)
+#endif
+#ifndef NK_GDI_MEMORY_PER_PIXEL
+#define NK_GDI_MEMORY_PER_PIXEL 0
+#endif
+
+/* Number of wide pens kept alive between primitives and frames, one pixel
+ * wide lines use the stock DC pen and need no object at all */
+#ifndef NK_GDI_PEN_CACHE_SIZE
+#define NK_GDI_PEN_CACHE_SIZE 16
+#endif
+
+/* Entries in the per font memo of string widths, strings longer than
+ * NK_GDI_WIDTH_MEMO_LENGTH bytes are always measured by GDI */
+#ifndef NK_GDI_WIDTH_MEMO_SIZE
+#define NK_GDI_WIDTH_MEMO_SIZE 64
+#endif
+#ifndef NK_GDI_WIDTH_MEMO_LENGTH
+#define NK_GDI_WIDTH_MEMO_LENGTH 48
+#endif
+
+struct nk_gdi_width {
+    int len;
+    float width;
+    char text[NK_GDI_WIDTH_MEMO_LENGTH];
+};
 
 struct GdiFont {
     struct nk_user_font nk;
     int height;
     HFONT handle;
     HDC dc;
+    /* advance of every ASCII character, text made of these only is measured
+     * without calling into GDI */
+    int advances[128];
+    struct nk_gdi_width widths[NK_GDI_WIDTH_MEMO_SIZE];
+};
+
+struct nk_gdi_pen {
+    HPEN handle;
+    COLORREF color;
+    unsigned short thickness;
+    unsigned int used;
 };
 
 static struct {
     HBITMAP bitmap;
     HDC window_dc;
     HDC memory_dc;
+    HDC image_dc;
+    HGDIOBJ pen;
+    HGDIOBJ image;
+    HGDIOBJ image_default;
+    HFONT font;
     unsigned int width;
     unsigned int height;
+    unsigned int tick;
+    struct nk_gdi_pen pens[NK_GDI_PEN_CACHE_SIZE];
+    struct nk_gdi_stats stats;
+    struct nk_gdi_stats frame_stats;
+    void *memory;
+    nk_size memory_size;
+    nk_size memory_peak;
     struct nk_context ctx;
 } gdi;
 
@@ -106,6 +182,11 @@ nk_delete_image(struct nk_image * image)
     if (image && image->handle.id != 0)
     {
         HBITMAP hbm = (HBITMAP)image->handle.ptr;
+        /* a bitmap cannot be deleted while selected into the image DC */
+        if (gdi.image == hbm) {
+            SelectObject(gdi.image_dc, gdi.image_default);
+            gdi.image = NULL;
+        }
         DeleteObject(hbm);
         memset(image, 0, sizeof(struct nk_image));
     }
@@ -116,17 +197,18 @@ nk_gdi_draw_image(short x, short y, unsigned short w, unsigned short h,
 	struct nk_image img, struct nk_color col)
 {
     HBITMAP	hbm = (HBITMAP)img.handle.ptr;
-    HDC     hDCBits;
     BITMAP  bitmap;
     
-    if (!gdi.memory_dc || !hbm)
+    if (!gdi.memory_dc || !gdi.image_dc || !hbm)
         return;
     
-    hDCBits = CreateCompatibleDC(gdi.memory_dc);
+    /* the image DC lives as long as the backend, only the bitmap changes */
+    if (gdi.image != hbm) {
+        SelectObject(gdi.image_dc, hbm);
+        gdi.image = hbm;
+    }
     GetObject(hbm, sizeof(BITMAP), (LPSTR)&bitmap);
-    SelectObject(hDCBits, hbm);
-    StretchBlt(gdi.memory_dc, x, y, w, h, hDCBits, 0, 0, bitmap.bmWidth, bitmap.bmHeight, SRCCOPY);
-    DeleteDC(hDCBits);
+    StretchBlt(gdi.memory_dc, x, y, w, h, gdi.image_dc, 0, 0, bitmap.bmWidth, bitmap.bmHeight, SRCCOPY);
 }
 
 static COLORREF
@@ -135,6 +217,61 @@ convert_color(struct nk_color c)
     return c.r | (c.g << 8) | (c.b << 16);
 }
 
+static void
+nk_gdi_select_pen(HDC dc, unsigned short line_thickness, COLORREF color)
+{
+    struct nk_gdi_pen *pen = NULL;
+    int i;
+
+    if (line_thickness <= 1) {
+        if (gdi.pen != GetStockObject(DC_PEN)) {
+            SelectObject(dc, GetStockObject(DC_PEN));
+            gdi.pen = GetStockObject(DC_PEN);
+        }
+        SetDCPenColor(dc, color);
+        return;
+    }
+
+    gdi.tick++;
+    for (i = 0; i < NK_GDI_PEN_CACHE_SIZE; ++i) {
+        if (gdi.pens[i].handle && gdi.pens[i].color == color && gdi.pens[i].thickness == line_thickness) {
+            pen = &gdi.pens[i];
+            break;
+        }
+    }
+
+    if (pen) {
+        gdi.stats.cache_hits++;
+    } else {
+        /* replace an empty entry or else the least recently used one */
+        pen = &gdi.pens[0];
+        for (i = 1; i < NK_GDI_PEN_CACHE_SIZE && pen->handle; ++i) {
+            if (!gdi.pens[i].handle || gdi.pens[i].used < pen->used)
+                pen = &gdi.pens[i];
+        }
+
+        gdi.stats.cache_misses++;
+        gdi.stats.objects_created++;
+        if (pen->handle) {
+            /* never delete the pen while it is still selected */
+            if (gdi.pen == pen->handle) {
+                SelectObject(dc, GetStockObject(DC_PEN));
+                gdi.pen = GetStockObject(DC_PEN);
+            }
+            DeleteObject(pen->handle);
+        }
+        pen->handle = CreatePen(PS_SOLID, line_thickness, color);
+        pen->color = color;
+        pen->thickness = line_thickness;
+    }
+    pen->used = gdi.tick;
+
+    if (gdi.pen != pen->handle) {
+        SelectObject(dc, pen->handle);
+        gdi.pen = pen->handle;
+    }
+}
+
 static void
 nk_gdi_scissor(HDC dc, float x, float y, float w, float h)
 {
@@ -147,22 +284,10 @@ nk_gdi_stroke_line(HDC dc, short x0, short y0, short x1,
     short y1, unsigned int line_thickness, struct nk_color col)
 {
     COLORREF color = convert_color(col);
-
-    HPEN pen = NULL;
-    if (line_thickness == 1) {
-        SetDCPenColor(dc, color);
-    } else {
-        pen = CreatePen(PS_SOLID, line_thickness, color);
-        SelectObject(dc, pen);
-    }
+    nk_gdi_select_pen(dc, line_thickness, color);
 
     MoveToEx(dc, x0, y0, NULL);
     LineTo(dc, x1, y1);
-
-    if (pen) {
-        SelectObject(dc, GetStockObject(DC_PEN));
-        DeleteObject(pen);
-    }
 }
 
 static void
@@ -170,14 +295,7 @@ nk_gdi_stroke_rect(HDC dc, short x, short y, unsigned short w,
     unsigned short h, unsigned short r, unsigned short line_thickness, struct nk_color col)
 {
     COLORREF color = convert_color(col);
-
-    HPEN pen = NULL;
-    if (line_thickness == 1) {
-        SetDCPenColor(dc, color);
-    } else {
-        pen = CreatePen(PS_SOLID, line_thickness, color);
-        SelectObject(dc, pen);
-    }
+    nk_gdi_select_pen(dc, line_thickness, color);
 
     HGDIOBJ br = SelectObject(dc, GetStockObject(NULL_BRUSH));
     if (r == 0) {
@@ -186,11 +304,6 @@ nk_gdi_stroke_rect(HDC dc, short x, short y, unsigned short w,
         RoundRect(dc, x, y, x + w, y + h, r, r);
     }
     SelectObject(dc, br);
-
-    if (pen) { 
-        SelectObject(dc, GetStockObject(DC_PEN));
-        DeleteObject(pen);
-    }
 }
 
 static void
@@ -204,7 +317,7 @@ nk_gdi_fill_rect(HDC dc, short x, short y, unsigned short w,
         SetBkColor(dc, color);
         ExtTextOutW(dc, 0, 0, ETO_OPAQUE, &rect, NULL, 0, NULL);
     } else {
-        SetDCPenColor(dc, color);
+        nk_gdi_select_pen(dc, 1, color);
         SetDCBrushColor(dc, color);
         RoundRect(dc, x, y, x + w, y + h, r, r);
     }
@@ -221,7 +334,7 @@ nk_gdi_fill_triangle(HDC dc, short x0, short y0, short x1,
         { x2, y2 },
     };
 
-    SetDCPenColor(dc, color);
+    nk_gdi_select_pen(dc, 1, color);
     SetDCBrushColor(dc, color);
     Polygon(dc, points, 3);
 }
@@ -238,20 +351,9 @@ nk_gdi_stroke_triangle(HDC dc, short x0, short y0, short x1,
         { x0, y0 },
     };
 
-    HPEN pen = NULL;
-    if (line_thickness == 1) {
-        SetDCPenColor(dc, color);
-    } else {
-        pen = CreatePen(PS_SOLID, line_thickness, color);
-        SelectObject(dc, pen);
-    }
+    nk_gdi_select_pen(dc, line_thickness, color);
 
     Polyline(dc, points, 4);
-
-    if (pen) {
-        SelectObject(dc, GetStockObject(DC_PEN));
-        DeleteObject(pen);
-    }
 }
 
 static void
@@ -262,7 +364,7 @@ nk_gdi_fill_polygon(HDC dc, const struct nk_vec2i *pnts, int count, struct nk_co
     POINT points[MAX_POINTS];
     COLORREF color = convert_color(col);
     SetDCBrushColor(dc, color);
-    SetDCPenColor(dc, color);
+    nk_gdi_select_pen(dc, 1, color);
     for (i = 0; i < count && i < MAX_POINTS; ++i) {
         points[i].x = pnts[i].x;
         points[i].y = pnts[i].y;
@@ -276,13 +378,7 @@ nk_gdi_stroke_polygon(HDC dc, const struct nk_vec2i *pnts, int count,
     unsigned short line_thickness, struct nk_color col)
 {
     COLORREF color = convert_color(col);
-    HPEN pen = NULL;
-    if (line_thickness == 1) {
-        SetDCPenColor(dc, color);
-    } else {
-        pen = CreatePen(PS_SOLID, line_thickness, color);
-        SelectObject(dc, pen);
-    }
+    nk_gdi_select_pen(dc, line_thickness, color);
 
     if (count > 0) {
         int i;
@@ -291,11 +387,6 @@ nk_gdi_stroke_polygon(HDC dc, const struct nk_vec2i *pnts, int count,
             LineTo(dc, pnts[i].x, pnts[i].y);
         LineTo(dc, pnts[0].x, pnts[0].y);
     }
-
-    if (pen) {
-        SelectObject(dc, GetStockObject(DC_PEN));
-        DeleteObject(pen);
-    }
 }
 
 static void
@@ -303,13 +394,7 @@ nk_gdi_stroke_polyline(HDC dc, const struct nk_vec2i *pnts,
     int count, unsigned short line_thickness, struct nk_color col)
 {
     COLORREF color = convert_color(col);
-    HPEN pen = NULL;
-    if (line_thickness == 1) {
-        SetDCPenColor(dc, color);
-    } else {
-        pen = CreatePen(PS_SOLID, line_thickness, color);
-        SelectObject(dc, pen);
-    }
+    nk_gdi_select_pen(dc, line_thickness, color);
 
     if (count > 0) {
         int i;
@@ -317,11 +402,6 @@ nk_gdi_stroke_polyline(HDC dc, const struct nk_vec2i *pnts,
         for (i = 1; i < count; ++i)
             LineTo(dc, pnts[i].x, pnts[i].y);
     }
-
-    if (pen) {
-        SelectObject(dc, GetStockObject(DC_PEN));
-        DeleteObject(pen);
-    }
 }
 
 static void
@@ -330,7 +410,7 @@ nk_gdi_fill_circle(HDC dc, short x, short y, unsigned short w,
 {
     COLORREF color = convert_color(col);
     SetDCBrushColor(dc, color);
-    SetDCPenColor(dc, color);
+    nk_gdi_select_pen(dc, 1, color);
     Ellipse(dc, x, y, x + w, y + h);
 }
 
@@ -339,21 +419,10 @@ nk_gdi_stroke_circle(HDC dc, short x, short y, unsigned short w,
     unsigned short h, unsigned short line_thickness, struct nk_color col)
 {
     COLORREF color = convert_color(col);
-    HPEN pen = NULL;
-    if (line_thickness == 1) {
-        SetDCPenColor(dc, color);
-    } else {
-        pen = CreatePen(PS_SOLID, line_thickness, color);
-        SelectObject(dc, pen);
-    }
+    nk_gdi_select_pen(dc, line_thickness, color);
 
     SetDCBrushColor(dc, OPAQUE);
     Ellipse(dc, x, y, x + w, y + h);
-
-    if (pen) {
-        SelectObject(dc, GetStockObject(DC_PEN));
-        DeleteObject(pen);
-    }
 }
 
 static void
@@ -369,21 +438,10 @@ nk_gdi_stroke_curve(HDC dc, struct nk_vec2i p1,
         { p4.x, p4.y },
     };
 
-    HPEN pen = NULL;
-    if (line_thickness == 1) {
-        SetDCPenColor(dc, color);
-    } else {
-        pen = CreatePen(PS_SOLID, line_thickness, color);
-        SelectObject(dc, pen);
-    }
+    nk_gdi_select_pen(dc, line_thickness, color);
 
     SetDCBrushColor(dc, OPAQUE);
     PolyBezier(dc, p, 4);
-
-    if (pen) {
-        SelectObject(dc, GetStockObject(DC_PEN));
-        DeleteObject(pen);
-    }
 }
 
 static void
@@ -402,7 +460,10 @@ nk_gdi_draw_text(HDC dc, short x, short y, unsigned short w, unsigned short h,
     SetBkColor(dc, convert_color(cbg));
     SetTextColor(dc, convert_color(cfg));
 
-    SelectObject(dc, font->handle);
+    if (gdi.font != font->handle) {
+        SelectObject(dc, font->handle);
+        gdi.font = font->handle;
+    }
     ExtTextOutW(dc, x, y, ETO_OPAQUE, NULL, wstr, wsize, NULL);
 }
 
@@ -434,6 +495,8 @@ nk_gdifont_create(const char *name, int size)
     SelectObject(font->dc, font->handle);
     GetTextMetricsW(font->dc, &metric);
     font->height = metric.tmHeight;
+    if (!GetCharWidth32W(font->dc, 0, 127, font->advances))
+        memset(font->advances, 0xff, sizeof(font->advances));
     return font;
 }
 
@@ -441,18 +504,47 @@ static float
 nk_gdifont_get_text_width(nk_handle handle, float height, const char *text, int len)
 {
     GdiFont *font = (GdiFont*)handle.ptr;
+    struct nk_gdi_width *memo = NULL;
     SIZE size;
     int wsize;
     WCHAR* wstr;
+    int width = 0;
+    int i;
     if (!font || !text)
         return 0;
 
+    /* plain ASCII is the sum of the cached advances */
+    for (i = 0; i < len; ++i) {
+        unsigned char c = (unsigned char)text[i];
+        if (c >= 128 || font->advances[c] < 0)
+            break;
+        width += font->advances[c];
+    }
+    if (i == len)
+        return (float)width;
+
+    /* anything else is measured by GDI once and remembered */
+    if (len <= NK_GDI_WIDTH_MEMO_LENGTH) {
+        nk_uint hash = 2166136261u;
+        for (i = 0; i < len; ++i)
+            hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+        memo = &font->widths[hash % NK_GDI_WIDTH_MEMO_SIZE];
+        if (memo->len == len && !memcmp(memo->text, text, len))
+            return memo->width;
+    }
+
     wsize = MultiByteToWideChar(CP_UTF8, 0, text, len, NULL, 0);
     wstr = (WCHAR*)_alloca(wsize * sizeof(wchar_t));
     MultiByteToWideChar(CP_UTF8, 0, text, len, wstr, wsize);
-    if (GetTextExtentPoint32W(font->dc, wstr, wsize, &size))
-        return (float)size.cx;
-    return -1.0f;
+    if (!GetTextExtentPoint32W(font->dc, wstr, wsize, &size))
+        return -1.0f;
+
+    if (memo) {
+        memo->len = len;
+        memo->width = (float)size.cx;
+        memcpy(memo->text, text, len);
+    }
+    return (float)size.cx;
 }
 
 void
@@ -524,6 +616,54 @@ nk_gdi_clipboard_copy(nk_handle usr, const char *text, int len)
     }
 }
 
+/* Builds the context on a fixed arena of [size] bytes so frames never allocate,
+ * falls back to the default allocator when the arena cannot be allocated */
+static void
+nk_gdi_init_memory(nk_size size, const struct nk_user_font *font)
+{
+    gdi.memory = malloc(size);
+    if (gdi.memory && nk_init_fixed(&gdi.ctx, gdi.memory, size, font)) {
+        gdi.memory_size = size;
+    } else {
+        free(gdi.memory);
+        gdi.memory = NULL;
+        gdi.memory_size = 0;
+        nk_init_default(&gdi.ctx, font);
+    }
+    gdi.ctx.clip.copy = nk_gdi_clipboard_copy;
+    gdi.ctx.clip.paste = nk_gdi_clipboard_paste;
+}
+
+static void
+nk_gdi_update_memory(void)
+{
+    struct nk_memory_status status;
+    nk_size used;
+
+    nk_buffer_info(&status, &gdi.ctx.memory);
+
+    /* commands grow from the front of the arena, windows and panels from the back */
+    used = status.allocated + (status.size - gdi.ctx.memory.size);
+    gdi.memory_peak = NK_MAX(gdi.memory_peak, used);
+
+    gdi.stats.memory_used = used;
+    gdi.stats.memory_peak = gdi.memory_peak;
+    gdi.stats.memory_size = status.size;
+    gdi.stats.memory_exhausted = gdi.memory && status.needed > status.size;
+}
+
+static void
+nk_gdi_grow_memory(void)
+{
+    /* window state is lost, everything else is rebuilt by the next frame anyway */
+    const struct nk_user_font *font = gdi.ctx.style.font;
+    nk_size size = NK_MAX(gdi.memory_size * 2, gdi.ctx.memory.needed + gdi.ctx.memory.needed / 2);
+    nk_free(&gdi.ctx);
+    free(gdi.memory);
+    nk_gdi_init_memory(size, font);
+    gdi.stats.memory_size = gdi.memory_size;
+}
+
 NK_API struct nk_context*
 nk_gdi_init(GdiFont *gdifont, HDC window_dc, unsigned int width, unsigned int height)
 {
@@ -535,13 +675,14 @@ nk_gdi_init(GdiFont *gdifont, HDC window_dc, unsigned int width, unsigned int he
     gdi.bitmap = CreateCompatibleBitmap(window_dc, width, height);
     gdi.window_dc = window_dc;
     gdi.memory_dc = CreateCompatibleDC(window_dc);
+    gdi.image_dc = CreateCompatibleDC(window_dc);
+    gdi.image_default = GetCurrentObject(gdi.image_dc, OBJ_BITMAP);
     gdi.width = width;
     gdi.height = height;
     SelectObject(gdi.memory_dc, gdi.bitmap);
 
-    nk_init_default(&gdi.ctx, font);
-    gdi.ctx.clip.copy = nk_gdi_clipboard_copy;
-    gdi.ctx.clip.paste = nk_gdi_clipboard_paste;
+    nk_gdi_init_memory(NK_GDI_MEMORY_SIZE + (nk_size)NK_GDI_MEMORY_PER_PIXEL
+        * NK_MAX(width, (unsigned int)GetSystemMetrics(SM_CXVIRTUALSCREEN)), font);
     return &gdi.ctx;
 }
 
@@ -741,22 +882,41 @@ nk_gdi_handle_event(HWND wnd, UINT msg, WPARAM wparam, LPARAM lparam)
     return 0;
 }
 
+NK_API struct nk_gdi_stats
+nk_gdi_get_stats(void)
+{
+    return gdi.frame_stats;
+}
+
 NK_API void
 nk_gdi_shutdown(void)
 {
+    int i;
+    SelectObject(gdi.memory_dc, GetStockObject(DC_PEN));
+    for (i = 0; i < NK_GDI_PEN_CACHE_SIZE; ++i) {
+        if (gdi.pens[i].handle)
+            DeleteObject(gdi.pens[i].handle);
+    }
+    memset(gdi.pens, 0, sizeof(gdi.pens));
+    DeleteDC(gdi.image_dc);
     DeleteObject(gdi.memory_dc);
     DeleteObject(gdi.bitmap);
     nk_free(&gdi.ctx);
+    free(gdi.memory);
+    gdi.memory = NULL;
 }
 
 NK_API void
-nk_gdi_render(struct nk_color clear)
+nk_gdi_draw(struct nk_color clear)
 {
     const struct nk_command *cmd;
 
     HDC memory_dc = gdi.memory_dc;
     SelectObject(memory_dc, GetStockObject(DC_PEN));
     SelectObject(memory_dc, GetStockObject(DC_BRUSH));
+    gdi.pen = GetStockObject(DC_PEN);
+    gdi.font = NULL;
+    memset(&gdi.stats, 0, sizeof(gdi.stats));
     nk_gdi_clear(memory_dc, clear);
 
     nk_foreach(cmd, &gdi.ctx)
@@ -834,8 +994,24 @@ nk_gdi_render(struct nk_color clear)
         default: break;
         }
     }
-    nk_gdi_blit(gdi.window_dc);
+    nk_gdi_update_memory();
     nk_clear(&gdi.ctx);
+    if (gdi.stats.memory_exhausted)
+        nk_gdi_grow_memory();
+    gdi.frame_stats = gdi.stats;
+}
+
+NK_API void
+nk_gdi_present(void)
+{
+    nk_gdi_blit(gdi.window_dc);
+}
+
+NK_API void
+nk_gdi_render(struct nk_color clear)
+{
+    nk_gdi_draw(clear);
+    nk_gdi_present();
 }
 
 #endif
@@ -0,0 +1,780 @@
+/*
+ * Nuklear - 1.32.0 - public domain
+ * no warrenty implied; use at your own risk.
+ * authored from 2015-2016 by Micha Mettke
+ */
+/*
+ * ==============================================================
+ *
+ *                              API
+ *
+ * ===============================================================
+ */
+#ifndef NK_RASTER_H_
+#define NK_RASTER_H_
+
+/* Software renderer drawing into a 32-bit 0xAARRGGBB framebuffer in memory,
+ * needs no window system so the UI can be rendered, measured and captured
+ * anywhere. Text uses a baked 8x16 bitmap font covering printable ASCII. */
+NK_API struct nk_context* nk_raster_init(unsigned int width, unsigned int height);
+NK_API void nk_raster_resize(unsigned int width, unsigned int height);
+NK_API void nk_raster_render(struct nk_color clear);
+NK_API void nk_raster_shutdown(void);
+
+/* Renders into [pixels] owned by the caller instead of the internal
+ * framebuffer, [pitch] is in pixels. Passing NULL or resizing goes back to
+ * an internal framebuffer */
+NK_API void nk_raster_set_target(nk_uint *pixels, unsigned int width, unsigned int height, unsigned int pitch);
+
+/* pitch is in pixels, every row starts 16 byte aligned */
+NK_API const nk_uint* nk_raster_get_pixels(unsigned int *width, unsigned int *height, unsigned int *pitch);
+NK_API int nk_raster_write_ppm(const char *path);
+
+/* font */
+NK_API struct nk_user_font* nk_raster_get_font(void);
+
+/* images drawn with nk_image_ptr point at one of these */
+struct nk_raster_image {
+    unsigned int width;
+    unsigned int height;
+    const nk_uint *pixels;
+};
+
+#endif
+
+/*
+ * ==============================================================
+ *
+ *                          IMPLEMENTATION
+ *
+ * ===============================================================
+ */
+#ifdef NK_RASTER_IMPLEMENTATION
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NK_RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+#define NK_RASTER_GLYPH_WIDTH 8
+#define NK_RASTER_GLYPH_HEIGHT 16
+
+/* Most edges a single scanline of a filled polygon may cross */
+#define NK_RASTER_MAX_CROSSINGS 64
+
+/* Segments a curve or arc is flattened into */
+#define NK_RASTER_SEGMENTS 16
+
+/* Printable ASCII rasterised from DejaVu Sans Mono, one byte per row with the
+ * leftmost pixel in the most significant bit */
+static const unsigned char nk_raster_glyphs[95][NK_RASTER_GLYPH_HEIGHT] = {
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /*   */
+    0x00,0x18,0x18,0x18,0x18,0x18,0x08,0x00,0x00,0x18,0x18,0x00,0x00,0x00,0x00,0x00, /* ! */
+    0x00,0x34,0x34,0x34,0x34,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /* " */
+    0x00,0x1a,0x12,0x12,0x7f,0x34,0x24,0xff,0x2c,0x68,0x48,0x00,0x00,0x00,0x00,0x00, /* # */
+    0x08,0x08,0x3c,0x6a,0x68,0x68,0x3c,0x0a,0x0b,0x4a,0x3e,0x08,0x08,0x00,0x00,0x00, /* $ */
+    0x00,0x70,0xd8,0xd8,0x73,0x0c,0x30,0x46,0x09,0x09,0x0f,0x00,0x00,0x00,0x00,0x00, /* % */
+    0x00,0x3c,0x20,0x20,0x30,0x70,0x59,0xcd,0xc7,0x66,0x3f,0x00,0x00,0x00,0x00,0x00, /* & */
+    0x00,0x18,0x18,0x18,0x18,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /* ' */
+    0x04,0x08,0x08,0x18,0x10,0x10,0x10,0x10,0x18,0x08,0x08,0x04,0x00,0x00,0x00,0x00, /* ( */
+    0x10,0x10,0x18,0x08,0x08,0x0c,0x0c,0x08,0x08,0x18,0x10,0x10,0x00,0x00,0x00,0x00, /* ) */
+    0x00,0x08,0x6a,0x3c,0x3c,0x6a,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /* * */
+    0x00,0x00,0x00,0x08,0x08,0x08,0xff,0x08,0x08,0x08,0x00,0x00,0x00,0x00,0x00,0x00, /* + */
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x18,0x10,0x00,0x00,0x00, /* , */
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x3c,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /* - */
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00,0x00,0x00, /* . */
+    0x00,0x02,0x06,0x04,0x0c,0x08,0x08,0x18,0x10,0x30,0x20,0x60,0x40,0x00,0x00,0x00, /* / */
+    0x00,0x3c,0x26,0x62,0x43,0x43,0x5b,0x43,0x62,0x26,0x3c,0x00,0x00,0x00,0x00,0x00, /* 0 */
+    0x00,0x18,0x28,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x3f,0x00,0x00,0x00,0x00,0x00, /* 1 */
+    0x00,0x3c,0x46,0x02,0x06,0x06,0x0c,0x18,0x30,0x60,0x7e,0x00,0x00,0x00,0x00,0x00, /* 2 */
+    0x00,0x3c,0x46,0x02,0x06,0x1c,0x06,0x02,0x02,0x46,0x3c,0x00,0x00,0x00,0x00,0x00, /* 3 */
+    0x00,0x0e,0x0e,0x16,0x36,0x26,0x46,0x7f,0x06,0x06,0x06,0x00,0x00,0x00,0x00,0x00, /* 4 */
+    0x00,0x7e,0x60,0x60,0x7c,0x46,0x02,0x02,0x02,0x46,0x3c,0x00,0x00,0x00,0x00,0x00, /* 5 */
+    0x00,0x1c,0x32,0x60,0x40,0x7c,0x66,0x63,0x63,0x66,0x3c,0x00,0x00,0x00,0x00,0x00, /* 6 */
+    0x00,0x7e,0x02,0x06,0x04,0x0c,0x0c,0x08,0x18,0x10,0x30,0x00,0x00,0x00,0x00,0x00, /* 7 */
+    0x00,0x3c,0x66,0x62,0x66,0x3c,0x66,0x43,0x43,0x66,0x3c,0x00,0x00,0x00,0x00,0x00, /* 8 */
+    0x00,0x3c,0x66,0x42,0x42,0x67,0x3f,0x02,0x02,0x06,0x3c,0x00,0x00,0x00,0x00,0x00, /* 9 */
+    0x00,0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00,0x00,0x00, /* : */
+    0x00,0x00,0x00,0x00,0x18,0x18,0x00,0x00,0x00,0x18,0x18,0x18,0x10,0x00,0x00,0x00, /* ; */
+    0x00,0x00,0x00,0x03,0x0e,0x78,0xe0,0x78,0x0e,0x03,0x00,0x00,0x00,0x00,0x00,0x00, /* < */
+    0x00,0x00,0x00,0x00,0xff,0x00,0x00,0xff,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /* = */
+    0x00,0x00,0x00,0x40,0x78,0x0e,0x03,0x0e,0x78,0x40,0x00,0x00,0x00,0x00,0x00,0x00, /* > */
+    0x00,0x3c,0x26,0x02,0x06,0x0c,0x18,0x18,0x00,0x18,0x18,0x00,0x00,0x00,0x00,0x00, /* ? */
+    0x00,0x1e,0x23,0x41,0xcf,0x9b,0x91,0x91,0x9b,0xcf,0x40,0x30,0x1e,0x00,0x00,0x00, /* @ */
+    0x00,0x18,0x1c,0x34,0x34,0x26,0x26,0x7e,0x42,0x43,0xc1,0x00,0x00,0x00,0x00,0x00, /* A */
+    0x00,0x7c,0x66,0x62,0x66,0x7c,0x62,0x63,0x63,0x63,0x7e,0x00,0x00,0x00,0x00,0x00, /* B */
+    0x00,0x1e,0x32,0x60,0x60,0x60,0x60,0x60,0x60,0x32,0x1e,0x00,0x00,0x00,0x00,0x00, /* C */
+    0x00,0x7c,0x46,0x42,0x43,0x43,0x43,0x43,0x42,0x46,0x7c,0x00,0x00,0x00,0x00,0x00, /* D */
+    0x00,0x7f,0x60,0x60,0x60,0x7e,0x60,0x60,0x60,0x60,0x7f,0x00,0x00,0x00,0x00,0x00, /* E */
+    0x00,0x7f,0x60,0x60,0x60,0x7e,0x60,0x60,0x60,0x60,0x60,0x00,0x00,0x00,0x00,0x00, /* F */
+    0x00,0x1e,0x32,0x60,0x40,0x40,0x47,0x43,0x63,0x33,0x1e,0x00,0x00,0x00,0x00,0x00, /* G */
+    0x00,0x43,0x43,0x43,0x43,0x7f,0x43,0x43,0x43,0x43,0x43,0x00,0x00,0x00,0x00,0x00, /* H */
+    0x00,0x7e,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x7e,0x00,0x00,0x00,0x00,0x00, /* I */
+    0x00,0x3e,0x06,0x06,0x06,0x06,0x06,0x06,0x06,0x4c,0x78,0x00,0x00,0x00,0x00,0x00, /* J */
+    0x00,0x43,0x46,0x4c,0x58,0x78,0x68,0x4c,0x46,0x42,0x43,0x00,0x00,0x00,0x00,0x00, /* K */
+    0x00,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x60,0x7f,0x00,0x00,0x00,0x00,0x00, /* L */
+    0x00,0xe3,0xe7,0xe7,0xd7,0xdb,0xdb,0xc3,0xc3,0xc3,0xc3,0x00,0x00,0x00,0x00,0x00, /* M */
+    0x00,0x63,0x63,0x73,0x53,0x5b,0x4b,0x4f,0x47,0x47,0x47,0x00,0x00,0x00,0x00,0x00, /* N */
+    0x00,0x3c,0x66,0x62,0x43,0x43,0x43,0x43,0x62,0x66,0x3c,0x00,0x00,0x00,0x00,0x00, /* O */
+    0x00,0x7e,0x63,0x63,0x63,0x63,0x7e,0x60,0x60,0x60,0x60,0x00,0x00,0x00,0x00,0x00, /* P */
+    0x00,0x3c,0x66,0x62,0x43,0x43,0x43,0x43,0x62,0x66,0x3c,0x06,0x02,0x00,0x00,0x00, /* Q */
+    0x00,0x7c,0x46,0x42,0x42,0x46,0x7c,0x46,0x42,0x43,0x41,0x00,0x00,0x00,0x00,0x00, /* R */
+    0x00,0x3c,0x62,0x40,0x60,0x38,0x1e,0x02,0x03,0x46,0x3c,0x00,0x00,0x00,0x00,0x00, /* S */
+    0x00,0xff,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x00,0x00,0x00,0x00,0x00, /* T */
+    0x00,0x63,0x63,0x63,0x63,0x63,0x63,0x63,0x62,0x66,0x3c,0x00,0x00,0x00,0x00,0x00, /* U */
+    0x00,0xc3,0x43,0x62,0x62,0x26,0x26,0x34,0x1c,0x1c,0x18,0x00,0x00,0x00,0x00,0x00, /* V */
+    0x00,0xc1,0xc1,0xc1,0xd9,0x5b,0x5f,0x77,0x76,0x66,0x66,0x00,0x00,0x00,0x00,0x00, /* W */
+    0x00,0x43,0x62,0x36,0x1c,0x18,0x1c,0x34,0x26,0x62,0xc3,0x00,0x00,0x00,0x00,0x00, /* X */
+    0x00,0xc3,0x62,0x26,0x34,0x1c,0x18,0x18,0x18,0x18,0x18,0x00,0x00,0x00,0x00,0x00, /* Y */
+    0x00,0x7f,0x03,0x06,0x04,0x0c,0x18,0x10,0x30,0x60,0x7f,0x00,0x00,0x00,0x00,0x00, /* Z */
+    0x1c,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x1c,0x00,0x00,0x00,0x00, /* [ */
+    0x00,0x40,0x60,0x20,0x30,0x10,0x18,0x08,0x08,0x0c,0x04,0x06,0x02,0x00,0x00,0x00, /* backslash */
+    0x38,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x38,0x00,0x00,0x00,0x00, /* ] */
+    0x00,0x18,0x3c,0x26,0x43,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /* ^ */
+    0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0xff,0x00,0x00, /* _ */
+    0x10,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /* ` */
+    0x00,0x00,0x00,0x3c,0x66,0x02,0x3e,0x62,0x42,0x66,0x3a,0x00,0x00,0x00,0x00,0x00, /* a */
+    0x60,0x60,0x60,0x7c,0x66,0x63,0x63,0x63,0x63,0x66,0x7c,0x00,0x00,0x00,0x00,0x00, /* b */
+    0x00,0x00,0x00,0x1e,0x32,0x60,0x60,0x60,0x60,0x32,0x1e,0x00,0x00,0x00,0x00,0x00, /* c */
+    0x02,0x02,0x02,0x3e,0x66,0x42,0x42,0x42,0x42,0x66,0x3e,0x00,0x00,0x00,0x00,0x00, /* d */
+    0x00,0x00,0x00,0x3c,0x62,0x43,0x7f,0x40,0x60,0x62,0x3e,0x00,0x00,0x00,0x00,0x00, /* e */
+    0x0e,0x18,0x18,0x7e,0x18,0x18,0x18,0x18,0x18,0x18,0x18,0x00,0x00,0x00,0x00,0x00, /* f */
+    0x00,0x00,0x00,0x3e,0x66,0x42,0x42,0x42,0x42,0x66,0x3e,0x02,0x26,0x3c,0x00,0x00, /* g */
+    0x60,0x60,0x60,0x7c,0x66,0x62,0x62,0x62,0x62,0x62,0x62,0x00,0x00,0x00,0x00,0x00, /* h */
+    0x08,0x08,0x00,0x38,0x08,0x08,0x08,0x08,0x08,0x08,0x7f,0x00,0x00,0x00,0x00,0x00, /* i */
+    0x08,0x08,0x00,0x38,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x78,0x00,0x00, /* j */
+    0x60,0x60,0x60,0x62,0x64,0x68,0x78,0x6c,0x66,0x62,0x63,0x00,0x00,0x00,0x00,0x00, /* k */
+    0x70,0x10,0x10,0x10,0x10,0x10,0x10,0x10,0x18,0x18,0x0e,0x00,0x00,0x00,0x00,0x00, /* l */
+    0x00,0x00,0x00,0x7e,0x5b,0x4b,0x4b,0x4b,0x4b,0x4b,0x4b,0x00,0x00,0x00,0x00,0x00, /* m */
+    0x00,0x00,0x00,0x7c,0x66,0x62,0x62,0x62,0x62,0x62,0x62,0x00,0x00,0x00,0x00,0x00, /* n */
+    0x00,0x00,0x00,0x3c,0x66,0x62,0x43,0x43,0x62,0x66,0x3c,0x00,0x00,0x00,0x00,0x00, /* o */
+    0x00,0x00,0x00,0x7c,0x66,0x62,0x63,0x63,0x62,0x66,0x7c,0x60,0x60,0x60,0x00,0x00, /* p */
+    0x00,0x00,0x00,0x3e,0x66,0x62,0x42,0x42,0x62,0x66,0x3a,0x02,0x02,0x02,0x00,0x00, /* q */
+    0x00,0x00,0x00,0x3f,0x38,0x30,0x30,0x30,0x30,0x30,0x30,0x00,0x00,0x00,0x00,0x00, /* r */
+    0x00,0x00,0x00,0x3c,0x22,0x60,0x38,0x0e,0x02,0x66,0x3c,0x00,0x00,0x00,0x00,0x00, /* s */
+    0x00,0x10,0x10,0x7e,0x10,0x10,0x10,0x10,0x10,0x18,0x0e,0x00,0x00,0x00,0x00,0x00, /* t */
+    0x00,0x00,0x00,0x62,0x62,0x62,0x62,0x62,0x62,0x66,0x3a,0x00,0x00,0x00,0x00,0x00, /* u */
+    0x00,0x00,0x00,0x43,0x62,0x66,0x26,0x34,0x34,0x1c,0x18,0x00,0x00,0x00,0x00,0x00, /* v */
+    0x00,0x00,0x00,0x81,0xc1,0xd9,0x5b,0x5b,0x76,0x76,0x26,0x00,0x00,0x00,0x00,0x00, /* w */
+    0x00,0x00,0x00,0x62,0x26,0x3c,0x18,0x18,0x34,0x66,0x43,0x00,0x00,0x00,0x00,0x00, /* x */
+    0x00,0x00,0x00,0x43,0x62,0x22,0x26,0x34,0x1c,0x1c,0x18,0x18,0x10,0x70,0x00,0x00, /* y */
+    0x00,0x00,0x00,0x7e,0x06,0x04,0x08,0x18,0x30,0x20,0x7e,0x00,0x00,0x00,0x00,0x00, /* z */
+    0x0e,0x08,0x08,0x08,0x18,0x18,0x70,0x18,0x18,0x08,0x08,0x08,0x0e,0x00,0x00,0x00, /* { */
+    0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x08,0x00,0x00, /* | */
+    0x70,0x18,0x18,0x18,0x18,0x08,0x0e,0x08,0x18,0x18,0x18,0x18,0x70,0x00,0x00,0x00, /* } */
+    0x00,0x00,0x00,0x00,0x00,0x00,0x79,0x0e,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00, /* ~ */
+};
+
+static struct {
+    nk_uint *pixels;
+    unsigned int width;
+    unsigned int height;
+    unsigned int pitch;
+    int owned;
+    int clip_x0, clip_y0, clip_x1, clip_y1;
+    /* x, y pairs of the filled polygon being drawn, only grows */
+    float *points;
+    int point_capacity;
+    struct nk_user_font font;
+    struct nk_context ctx;
+} raster;
+
+static nk_uint
+nk_raster_color(struct nk_color c)
+{
+    return 0xff000000u | ((nk_uint)c.r << 16) | ((nk_uint)c.g << 8) | c.b;
+}
+
+/* d + (s - d) * a / 255 for every channel, rounded */
+static nk_uint
+nk_raster_blend(nk_uint d, nk_uint s, nk_uint a)
+{
+    nk_uint rb = (s & 0xff00ffu) * a + (d & 0xff00ffu) * (255 - a) + 0x800080u;
+    nk_uint g = (s & 0xff00u) * a + (d & 0xff00u) * (255 - a) + 0x8000u;
+    rb = ((rb + ((rb >> 8) & 0xff00ffu)) >> 8) & 0xff00ffu;
+    g = ((g + ((g >> 8) & 0xff00u)) >> 8) & 0xff00u;
+    return 0xff000000u | rb | g;
+}
+
+static void
+nk_raster_span(int x0, int x1, int y, struct nk_color col)
+{
+    nk_uint color = nk_raster_color(col);
+    nk_uint *dst;
+    int count;
+
+    if (y < raster.clip_y0 || y >= raster.clip_y1)
+        return;
+    if (x0 < raster.clip_x0) x0 = raster.clip_x0;
+    if (x1 > raster.clip_x1) x1 = raster.clip_x1;
+    if (x0 >= x1 || col.a == 0)
+        return;
+
+    dst = raster.pixels + (size_t)y * raster.pitch + x0;
+    count = x1 - x0;
+
+    if (col.a == 255) {
+#ifdef NK_RASTER_SSE2
+        __m128i c = _mm_set1_epi32((int)color);
+        for (; count && ((size_t)dst & 15); --count)
+            *dst++ = color;
+        for (; count >= 4; count -= 4, dst += 4)
+            _mm_store_si128((__m128i*)dst, c);
+#endif
+        while (count-- > 0)
+            *dst++ = color;
+    } else {
+#ifdef NK_RASTER_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i src = _mm_mullo_epi16(
+            _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero),
+            _mm_set1_epi16(col.a));
+        const __m128i inv = _mm_set1_epi16(255 - col.a);
+        const __m128i half = _mm_set1_epi16(128);
+        for (; count >= 4; count -= 4, dst += 4) {
+            __m128i d = _mm_loadu_si128((const __m128i*)dst);
+            __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), src), half);
+            __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), src), half);
+            lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+            _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+        }
+#endif
+        for (; count > 0; --count, ++dst)
+            *dst = nk_raster_blend(*dst, color, col.a);
+    }
+}
+
+static void
+nk_raster_plot(int x, int y, struct nk_color col)
+{
+    nk_raster_span(x, x + 1, y, col);
+}
+
+/* Row [y] of a rectangle with rounded corners or of the ellipse inscribed in
+ * it, returns 0 when the row misses the shape */
+static int
+nk_raster_shape_row(int ellipse, float x, float y, float w, float h, float r,
+    int row, int *x0, int *x1)
+{
+    float dy = (float)row + 0.5f - y;
+    float inset = 0;
+
+    if (w <= 0 || h <= 0 || dy < 0 || dy >= h)
+        return 0;
+
+    if (ellipse) {
+        float a = w * 0.5f;
+        float b = h * 0.5f;
+        float t = (dy - b) / b;
+        inset = a - a * (float)sqrt(NK_MAX(0.0f, 1.0f - t * t));
+    } else if (r > 0) {
+        float d = 0;
+        r = NK_MIN(r, NK_MIN(w, h) * 0.5f);
+        if (dy < r)
+            d = r - dy;
+        else if (dy > h - r)
+            d = dy - (h - r);
+        inset = r - (float)sqrt(NK_MAX(0.0f, r * r - d * d));
+    }
+
+    *x0 = (int)floorf(x + inset + 0.5f);
+    *x1 = (int)floorf(x + w - inset + 0.5f);
+    return *x0 < *x1;
+}
+
+static void
+nk_raster_fill_shape(int ellipse, float x, float y, float w, float h, float r,
+    struct nk_color col)
+{
+    int row, x0, x1;
+    for (row = (int)floorf(y); row < (int)ceilf(y + h); ++row) {
+        if (nk_raster_shape_row(ellipse, x, y, w, h, r, row, &x0, &x1))
+            nk_raster_span(x0, x1, row, col);
+    }
+}
+
+/* The outline is the shape minus the shape shrunk by the line thickness */
+static void
+nk_raster_stroke_shape(int ellipse, float x, float y, float w, float h, float r,
+    float thickness, struct nk_color col)
+{
+    int row, x0, x1, i0, i1;
+    thickness = NK_MAX(thickness, 1.0f);
+    for (row = (int)floorf(y); row < (int)ceilf(y + h); ++row) {
+        if (!nk_raster_shape_row(ellipse, x, y, w, h, r, row, &x0, &x1))
+            continue;
+        if (nk_raster_shape_row(ellipse, x + thickness, y + thickness,
+            w - 2 * thickness, h - 2 * thickness, NK_MAX(r - thickness, 0.0f), row, &i0, &i1))
+        {
+            nk_raster_span(x0, i0, row, col);
+            nk_raster_span(i1, x1, row, col);
+        } else {
+            nk_raster_span(x0, x1, row, col);
+        }
+    }
+}
+
+/* Even-odd scanline fill sampling at pixel centers, [points] holds x, y pairs */
+static void
+nk_raster_fill_polygon(const float *points, int count, struct nk_color col)
+{
+    float crossings[NK_RASTER_MAX_CROSSINGS];
+    float top, bottom;
+    int row, i, j;
+
+    if (count < 3)
+        return;
+
+    top = bottom = points[1];
+    for (i = 1; i < count; ++i) {
+        top = NK_MIN(top, points[2 * i + 1]);
+        bottom = NK_MAX(bottom, points[2 * i + 1]);
+    }
+
+    for (row = (int)floorf(top); row < (int)ceilf(bottom); ++row) {
+        float center = (float)row + 0.5f;
+        int found = 0;
+        if (row < raster.clip_y0 || row >= raster.clip_y1)
+            continue;
+
+        for (i = 0, j = count - 1; i < count; j = i++) {
+            float xi = points[2 * i], yi = points[2 * i + 1];
+            float xj = points[2 * j], yj = points[2 * j + 1];
+            if ((yi <= center) != (yj <= center) && found < NK_RASTER_MAX_CROSSINGS) {
+                float x = xi + (center - yi) * (xj - xi) / (yj - yi);
+                int k = found++;
+                while (k > 0 && crossings[k - 1] > x) {
+                    crossings[k] = crossings[k - 1];
+                    --k;
+                }
+                crossings[k] = x;
+            }
+        }
+
+        for (i = 0; i + 1 < found; i += 2) {
+            nk_raster_span((int)ceilf(crossings[i] - 0.5f),
+                (int)ceilf(crossings[i + 1] - 0.5f), row, col);
+        }
+    }
+}
+
+static void
+nk_raster_stroke_line(float x0, float y0, float x1, float y1,
+    float thickness, struct nk_color col)
+{
+    if (thickness <= 1.0f) {
+        /* Bresenham */
+        int ix0 = (int)floorf(x0), iy0 = (int)floorf(y0);
+        int ix1 = (int)floorf(x1), iy1 = (int)floorf(y1);
+        int dx = NK_ABS(ix1 - ix0), sx = ix0 < ix1 ? 1 : -1;
+        int dy = -NK_ABS(iy1 - iy0), sy = iy0 < iy1 ? 1 : -1;
+        int error = dx + dy;
+        for (;;) {
+            int e2 = 2 * error;
+            nk_raster_plot(ix0, iy0, col);
+            if (ix0 == ix1 && iy0 == iy1)
+                break;
+            if (e2 >= dy) { error += dy; ix0 += sx; }
+            if (e2 <= dx) { error += dx; iy0 += sy; }
+        }
+    } else {
+        /* a quad around the line, offset by half the thickness either side */
+        float dx = x1 - x0, dy = y1 - y0;
+        float length = (float)sqrt(dx * dx + dy * dy);
+        float nx, ny;
+        float quad[8];
+        if (length <= 0)
+            return;
+        nx = -dy / length * thickness * 0.5f;
+        ny = dx / length * thickness * 0.5f;
+        quad[0] = x0 + nx; quad[1] = y0 + ny;
+        quad[2] = x1 + nx; quad[3] = y1 + ny;
+        quad[4] = x1 - nx; quad[5] = y1 - ny;
+        quad[6] = x0 - nx; quad[7] = y0 - ny;
+        nk_raster_fill_polygon(quad, 4, col);
+    }
+}
+
+static void
+nk_raster_stroke_points(const struct nk_vec2i *points, int count, int closed,
+    float thickness, struct nk_color col)
+{
+    int i;
+    for (i = 1; i < count; ++i) {
+        nk_raster_stroke_line(points[i - 1].x, points[i - 1].y,
+            points[i].x, points[i].y, thickness, col);
+    }
+    if (closed && count > 2) {
+        nk_raster_stroke_line(points[count - 1].x, points[count - 1].y,
+            points[0].x, points[0].y, thickness, col);
+    }
+}
+
+static void
+nk_raster_fill_points(const struct nk_vec2i *points, int count, struct nk_color col)
+{
+    int i;
+    if (count > raster.point_capacity) {
+        float *grown = (float*)realloc(raster.points, sizeof(float) * 2 * (size_t)count);
+        if (!grown)
+            return;
+        raster.points = grown;
+        raster.point_capacity = count;
+    }
+    for (i = 0; i < count; ++i) {
+        raster.points[2 * i] = points[i].x;
+        raster.points[2 * i + 1] = points[i].y;
+    }
+    nk_raster_fill_polygon(raster.points, count, col);
+}
+
+static void
+nk_raster_stroke_curve(struct nk_vec2i p0, struct nk_vec2i p1,
+    struct nk_vec2i p2, struct nk_vec2i p3, float thickness, struct nk_color col)
+{
+    float x = p0.x, y = p0.y;
+    int i;
+    for (i = 1; i <= NK_RASTER_SEGMENTS; ++i) {
+        float t = (float)i / NK_RASTER_SEGMENTS;
+        float u = 1.0f - t;
+        float w0 = u * u * u, w1 = 3 * u * u * t, w2 = 3 * u * t * t, w3 = t * t * t;
+        float nx = w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x;
+        float ny = w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y;
+        nk_raster_stroke_line(x, y, nx, ny, thickness, col);
+        x = nx;
+        y = ny;
+    }
+}
+
+static void
+nk_raster_arc(short cx, short cy, unsigned short r, float a_min, float a_max,
+    int filled, float thickness, struct nk_color col)
+{
+    float points[2 * (NK_RASTER_SEGMENTS + 2)];
+    int i;
+    for (i = 0; i <= NK_RASTER_SEGMENTS; ++i) {
+        float a = a_min + (a_max - a_min) * i / NK_RASTER_SEGMENTS;
+        points[2 * i] = cx + (float)cos(a) * r;
+        points[2 * i + 1] = cy + (float)sin(a) * r;
+    }
+    if (filled) {
+        points[2 * i] = cx;
+        points[2 * i + 1] = cy;
+        nk_raster_fill_polygon(points, NK_RASTER_SEGMENTS + 2, col);
+    } else {
+        for (i = 1; i <= NK_RASTER_SEGMENTS; ++i) {
+            nk_raster_stroke_line(points[2 * i - 2], points[2 * i - 1],
+                points[2 * i], points[2 * i + 1], thickness, col);
+        }
+    }
+}
+
+static void
+nk_raster_fill_rect_multi_color(short x, short y, unsigned short w, unsigned short h,
+    struct nk_color left, struct nk_color top, struct nk_color right, struct nk_color bottom)
+{
+    /* nuklear passes the top left, top right, bottom right and bottom left corners */
+    int row, column;
+    for (row = 0; row < h; ++row) {
+        float v = h > 1 ? (float)row / (h - 1) : 0;
+        for (column = 0; column < w; ++column) {
+            float u = w > 1 ? (float)column / (w - 1) : 0;
+            struct nk_color c;
+            c.r = (nk_byte)((left.r * (1 - u) + top.r * u) * (1 - v) + (bottom.r * (1 - u) + right.r * u) * v);
+            c.g = (nk_byte)((left.g * (1 - u) + top.g * u) * (1 - v) + (bottom.g * (1 - u) + right.g * u) * v);
+            c.b = (nk_byte)((left.b * (1 - u) + top.b * u) * (1 - v) + (bottom.b * (1 - u) + right.b * u) * v);
+            c.a = (nk_byte)((left.a * (1 - u) + top.a * u) * (1 - v) + (bottom.a * (1 - u) + right.a * u) * v);
+            nk_raster_plot(x + column, y + row, c);
+        }
+    }
+}
+
+static void
+nk_raster_draw_image(short x, short y, unsigned short w, unsigned short h,
+    struct nk_image img, struct nk_color col)
+{
+    const struct nk_raster_image *image = (const struct nk_raster_image*)img.handle.ptr;
+    int row, column;
+    (void)col;
+    if (!image || !image->pixels || !image->width || !image->height)
+        return;
+
+    /* nearest neighbour */
+    for (row = 0; row < h; ++row) {
+        const nk_uint *src = image->pixels + (size_t)(row * image->height / h) * image->width;
+        for (column = 0; column < w; ++column) {
+            nk_uint p = src[column * image->width / w];
+            nk_raster_plot(x + column, y + row, nk_rgba((p >> 16) & 0xff, (p >> 8) & 0xff, p & 0xff, (p >> 24) & 0xff));
+        }
+    }
+}
+
+static int
+nk_raster_glyph_count(const char *text, int len)
+{
+    int count = 0;
+    int i;
+    for (i = 0; i < len; ++i) {
+        /* continuation bytes do not start a glyph */
+        if (((unsigned char)text[i] & 0xc0) != 0x80)
+            ++count;
+    }
+    return count;
+}
+
+static void
+nk_raster_draw_text(short x, short y, unsigned short w, unsigned short h,
+    const char *text, int len, struct nk_color cbg, struct nk_color cfg)
+{
+    int i;
+    /* glyphs are clipped to the box nuklear laid the text out in */
+    const int right = x + w;
+    const int rows = NK_MIN(NK_RASTER_GLYPH_HEIGHT, (int)h);
+    if (!text || !len)
+        return;
+
+    nk_raster_fill_shape(0, x, y, (float)NK_MIN(nk_raster_glyph_count(text, len) * NK_RASTER_GLYPH_WIDTH, (int)w),
+        (float)rows, 0, cbg);
+
+    for (i = 0; i < len && x < right; ++i) {
+        unsigned char c = (unsigned char)text[i];
+        const unsigned char *glyph;
+        int row, column, columns;
+        if ((c & 0xc0) == 0x80)
+            continue;
+        if (c < 32 || c > 126)
+            c = '?';
+
+        glyph = nk_raster_glyphs[c - 32];
+        columns = NK_MIN(NK_RASTER_GLYPH_WIDTH, right - x);
+        for (row = 0; row < rows; ++row) {
+            for (column = 0; column < columns; ++column) {
+                if (glyph[row] & (0x80 >> column))
+                    nk_raster_plot(x + column, y + row, cfg);
+            }
+        }
+        x += NK_RASTER_GLYPH_WIDTH;
+    }
+}
+
+static float
+nk_raster_get_text_width(nk_handle handle, float height, const char *text, int len)
+{
+    (void)handle;
+    (void)height;
+    if (!text)
+        return 0;
+    return (float)(nk_raster_glyph_count(text, len) * NK_RASTER_GLYPH_WIDTH);
+}
+
+static void
+nk_raster_scissor(float x, float y, float w, float h)
+{
+    raster.clip_x0 = NK_MAX((int)x, 0);
+    raster.clip_y0 = NK_MAX((int)y, 0);
+    raster.clip_x1 = NK_MIN((int)(x + w + 1), (int)raster.width);
+    raster.clip_y1 = NK_MIN((int)(y + h + 1), (int)raster.height);
+}
+
+NK_API struct nk_user_font*
+nk_raster_get_font(void)
+{
+    raster.font.userdata = nk_handle_ptr(0);
+    raster.font.height = NK_RASTER_GLYPH_HEIGHT;
+    raster.font.width = nk_raster_get_text_width;
+    return &raster.font;
+}
+
+NK_API void
+nk_raster_resize(unsigned int width, unsigned int height)
+{
+    unsigned int pitch = (width + 3) & ~3u;
+    if (raster.pixels && raster.owned && width == raster.width && height == raster.height)
+        return;
+
+    if (raster.owned)
+        free(raster.pixels);
+    raster.pixels = (nk_uint*)malloc(sizeof(nk_uint) * pitch * height + 16);
+    raster.owned = 1;
+    raster.width = raster.pixels ? width : 0;
+    raster.height = raster.pixels ? height : 0;
+    raster.pitch = pitch;
+}
+
+NK_API void
+nk_raster_set_target(nk_uint *pixels, unsigned int width, unsigned int height, unsigned int pitch)
+{
+    if (!pixels) {
+        nk_raster_resize(width, height);
+        return;
+    }
+
+    if (raster.owned)
+        free(raster.pixels);
+    raster.pixels = pixels;
+    raster.owned = 0;
+    raster.width = width;
+    raster.height = height;
+    raster.pitch = pitch;
+}
+
+NK_API struct nk_context*
+nk_raster_init(unsigned int width, unsigned int height)
+{
+    nk_raster_resize(width, height);
+    nk_init_default(&raster.ctx, nk_raster_get_font());
+    return &raster.ctx;
+}
+
+NK_API const nk_uint*
+nk_raster_get_pixels(unsigned int *width, unsigned int *height, unsigned int *pitch)
+{
+    if (width) *width = raster.width;
+    if (height) *height = raster.height;
+    if (pitch) *pitch = raster.pitch;
+    return raster.pixels;
+}
+
+NK_API int
+nk_raster_write_ppm(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    unsigned int row, column;
+    if (!file)
+        return 0;
+
+    fprintf(file, "P6\n%u %u\n255\n", raster.width, raster.height);
+    for (row = 0; row < raster.height; ++row) {
+        const nk_uint *src = raster.pixels + (size_t)row * raster.pitch;
+        for (column = 0; column < raster.width; ++column) {
+            unsigned char rgb[3];
+            rgb[0] = (unsigned char)(src[column] >> 16);
+            rgb[1] = (unsigned char)(src[column] >> 8);
+            rgb[2] = (unsigned char)src[column];
+            fwrite(rgb, 1, 3, file);
+        }
+    }
+    return fclose(file) == 0;
+}
+
+NK_API void
+nk_raster_shutdown(void)
+{
+    if (raster.owned)
+        free(raster.pixels);
+    raster.pixels = NULL;
+    raster.owned = 0;
+    raster.width = 0;
+    raster.height = 0;
+    free(raster.points);
+    raster.points = NULL;
+    raster.point_capacity = 0;
+    nk_free(&raster.ctx);
+}
+
+NK_API void
+nk_raster_render(struct nk_color clear)
+{
+    const struct nk_command *cmd;
+    unsigned int row;
+
+    if (!raster.pixels)
+        return;
+
+    nk_raster_scissor(0, 0, (float)raster.width, (float)raster.height);
+    for (row = 0; row < raster.height; ++row)
+        nk_raster_span(0, (int)raster.width, (int)row, nk_rgb(clear.r, clear.g, clear.b));
+
+    nk_foreach(cmd, &raster.ctx)
+    {
+        switch (cmd->type) {
+        case NK_COMMAND_NOP: break;
+        case NK_COMMAND_SCISSOR: {
+            const struct nk_command_scissor *s = (const struct nk_command_scissor*)cmd;
+            nk_raster_scissor(s->x, s->y, s->w, s->h);
+        } break;
+        case NK_COMMAND_LINE: {
+            const struct nk_command_line *l = (const struct nk_command_line *)cmd;
+            nk_raster_stroke_line(l->begin.x, l->begin.y, l->end.x, l->end.y,
+                l->line_thickness, l->color);
+        } break;
+        case NK_COMMAND_RECT: {
+            const struct nk_command_rect *r = (const struct nk_command_rect *)cmd;
+            nk_raster_stroke_shape(0, r->x, r->y, r->w, r->h, r->rounding,
+                r->line_thickness, r->color);
+        } break;
+        case NK_COMMAND_RECT_FILLED: {
+            const struct nk_command_rect_filled *r = (const struct nk_command_rect_filled *)cmd;
+            nk_raster_fill_shape(0, r->x, r->y, r->w, r->h, r->rounding, r->color);
+        } break;
+        case NK_COMMAND_CIRCLE: {
+            const struct nk_command_circle *c = (const struct nk_command_circle *)cmd;
+            nk_raster_stroke_shape(1, c->x, c->y, c->w, c->h, 0, c->line_thickness, c->color);
+        } break;
+        case NK_COMMAND_CIRCLE_FILLED: {
+            const struct nk_command_circle_filled *c = (const struct nk_command_circle_filled *)cmd;
+            nk_raster_fill_shape(1, c->x, c->y, c->w, c->h, 0, c->color);
+        } break;
+        case NK_COMMAND_TRIANGLE: {
+            const struct nk_command_triangle *t = (const struct nk_command_triangle*)cmd;
+            struct nk_vec2i points[3];
+            points[0] = t->a; points[1] = t->b; points[2] = t->c;
+            nk_raster_stroke_points(points, 3, 1, t->line_thickness, t->color);
+        } break;
+        case NK_COMMAND_TRIANGLE_FILLED: {
+            const struct nk_command_triangle_filled *t = (const struct nk_command_triangle_filled *)cmd;
+            struct nk_vec2i points[3];
+            points[0] = t->a; points[1] = t->b; points[2] = t->c;
+            nk_raster_fill_points(points, 3, t->color);
+        } break;
+        case NK_COMMAND_POLYGON: {
+            const struct nk_command_polygon *p = (const struct nk_command_polygon*)cmd;
+            nk_raster_stroke_points(p->points, p->point_count, 1, p->line_thickness, p->color);
+        } break;
+        case NK_COMMAND_POLYGON_FILLED: {
+            const struct nk_command_polygon_filled *p = (const struct nk_command_polygon_filled *)cmd;
+            nk_raster_fill_points(p->points, p->point_count, p->color);
+        } break;
+        case NK_COMMAND_POLYLINE: {
+            const struct nk_command_polyline *p = (const struct nk_command_polyline *)cmd;
+            nk_raster_stroke_points(p->points, p->point_count, 0, p->line_thickness, p->color);
+        } break;
+        case NK_COMMAND_TEXT: {
+            const struct nk_command_text *t = (const struct nk_command_text*)cmd;
+            nk_raster_draw_text(t->x, t->y, t->w, t->h, (const char*)t->string,
+                t->length, t->background, t->foreground);
+        } break;
+        case NK_COMMAND_CURVE: {
+            const struct nk_command_curve *q = (const struct nk_command_curve *)cmd;
+            nk_raster_stroke_curve(q->begin, q->ctrl[0], q->ctrl[1], q->end,
+                q->line_thickness, q->color);
+        } break;
+        case NK_COMMAND_RECT_MULTI_COLOR: {
+            const struct nk_command_rect_multi_color *r = (const struct nk_command_rect_multi_color *)cmd;
+            nk_raster_fill_rect_multi_color(r->x, r->y, r->w, r->h, r->left, r->top, r->right, r->bottom);
+        } break;
+        case NK_COMMAND_IMAGE: {
+            const struct nk_command_image *i = (const struct nk_command_image *)cmd;
+            nk_raster_draw_image(i->x, i->y, i->w, i->h, i->img, i->col);
+        } break;
+        case NK_COMMAND_ARC: {
+            const struct nk_command_arc *a = (const struct nk_command_arc *)cmd;
+            nk_raster_arc(a->cx, a->cy, a->r, a->a[0], a->a[1], 0, a->line_thickness, a->color);
+        } break;
+        case NK_COMMAND_ARC_FILLED: {
+            const struct nk_command_arc_filled *a = (const struct nk_command_arc_filled *)cmd;
+            nk_raster_arc(a->cx, a->cy, a->r, a->a[0], a->a[1], 1, 0, a->color);
+        } break;
+        default: break;
+        }
+    }
+    nk_clear(&raster.ctx);
+}
+
+#endif
\ No newline at end of file
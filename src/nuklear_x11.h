@@ -0,0 +1,444 @@
+/*
+ * Nuklear - 1.32.0 - public domain
+ * no warrenty implied; use at your own risk.
+ * authored from 2015-2016 by Micha Mettke
+ */
+/*
+ * ==============================================================
+ *
+ *                              API
+ *
+ * ===============================================================
+ */
+#ifndef NK_X11_H_
+#define NK_X11_H_
+
+#include <X11/Xlib.h>
+
+/* X11 backend on top of the software rasterizer in nuklear_raster.h, which
+ * has to be included with its implementation first. Frames are drawn straight
+ * into an image shared with the X server through MIT-SHM, so presenting a
+ * frame copies nothing through the socket. Servers without MIT-SHM, remote
+ * displays for instance, get the image sent with XPutImage instead. The
+ * window needs a 24 or 32 bit TrueColor visual with 0xRRGGBB pixels. */
+NK_API struct nk_context* nk_x11_init(Display *display, Window window, unsigned int width, unsigned int height);
+NK_API int nk_x11_handle_event(XEvent *event);
+NK_API void nk_x11_render(struct nk_color clear);
+NK_API void nk_x11_shutdown(void);
+
+/* nk_x11_render in two halves, rasterizing into the image and handing it to
+ * the server, so each can be timed on its own */
+NK_API void nk_x11_draw(struct nk_color clear);
+NK_API void nk_x11_present(void);
+
+/* nonzero while frames go through shared memory */
+NK_API int nk_x11_is_shared(void);
+
+#endif
+
+/*
+ * ==============================================================
+ *
+ *                          IMPLEMENTATION
+ *
+ * ===============================================================
+ */
+#ifdef NK_X11_IMPLEMENTATION
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/Xutil.h>
+#include <X11/keysym.h>
+#include <X11/extensions/XShm.h>
+
+/* Longest gap between two left clicks that still makes a double click, X11
+ * has no notion of double clicks so the backend tracks them itself */
+#ifndef NK_X11_DOUBLE_CLICK_MS
+#define NK_X11_DOUBLE_CLICK_MS 400
+#endif
+
+static struct {
+    Display *display;
+    Window window;
+    Visual *visual;
+    int depth;
+    GC gc;
+    XImage *image;
+    XShmSegmentInfo shm;
+    int shared;
+    int shm_failed;
+    int pending;
+    Time last_click;
+    unsigned int width;
+    unsigned int height;
+    struct nk_context *ctx;
+} x11;
+
+static int
+nk_x11_shm_error(Display *display, XErrorEvent *event)
+{
+    (void)display;
+    (void)event;
+    x11.shm_failed = 1;
+    return 0;
+}
+
+static void
+nk_x11_destroy_image(void)
+{
+    if (!x11.image)
+        return;
+
+    /* the server may still be reading the last frame */
+    if (x11.pending) {
+        XSync(x11.display, False);
+        x11.pending = 0;
+    }
+
+    if (x11.shared) {
+        XShmDetach(x11.display, &x11.shm);
+        XSync(x11.display, False);
+        shmdt(x11.shm.shmaddr);
+        x11.image->data = NULL;
+    }
+    XDestroyImage(x11.image);
+    x11.image = NULL;
+    x11.shared = 0;
+    nk_raster_set_target(NULL, 0, 0, 0);
+}
+
+static int
+nk_x11_create_shared_image(unsigned int width, unsigned int height)
+{
+    XErrorHandler handler;
+    XImage *image = XShmCreateImage(x11.display, x11.visual, (unsigned int)x11.depth,
+        ZPixmap, NULL, &x11.shm, width, height);
+    if (!image)
+        return 0;
+
+    x11.shm.shmid = shmget(IPC_PRIVATE, (size_t)image->bytes_per_line * image->height, IPC_CREAT | 0600);
+    if (x11.shm.shmid < 0) {
+        XDestroyImage(image);
+        return 0;
+    }
+
+    x11.shm.shmaddr = image->data = (char*)shmat(x11.shm.shmid, NULL, 0);
+    x11.shm.readOnly = False;
+    if (x11.shm.shmaddr == (char*)-1) {
+        shmctl(x11.shm.shmid, IPC_RMID, NULL);
+        image->data = NULL;
+        XDestroyImage(image);
+        return 0;
+    }
+
+    /* attaching fails asynchronously when the server cannot reach our memory */
+    x11.shm_failed = 0;
+    handler = XSetErrorHandler(nk_x11_shm_error);
+    XShmAttach(x11.display, &x11.shm);
+    XSync(x11.display, False);
+    XSetErrorHandler(handler);
+
+    /* the segment goes away once both sides have detached */
+    shmctl(x11.shm.shmid, IPC_RMID, NULL);
+    if (x11.shm_failed) {
+        shmdt(x11.shm.shmaddr);
+        image->data = NULL;
+        XDestroyImage(image);
+        return 0;
+    }
+
+    x11.image = image;
+    x11.shared = 1;
+    return 1;
+}
+
+static void
+nk_x11_create_image(unsigned int width, unsigned int height)
+{
+    nk_x11_destroy_image();
+    x11.width = width;
+    x11.height = height;
+    if (!width || !height)
+        return;
+
+    if (!x11.shm_failed && XShmQueryExtension(x11.display) &&
+        nk_x11_create_shared_image(width, height)) {
+        /* shared */
+    } else {
+        x11.shm_failed = 1;
+        x11.image = XCreateImage(x11.display, x11.visual, (unsigned int)x11.depth,
+            ZPixmap, 0, NULL, width, height, 32, 0);
+        if (!x11.image)
+            return;
+        x11.image->data = (char*)malloc((size_t)x11.image->bytes_per_line * height);
+        if (!x11.image->data) {
+            XDestroyImage(x11.image);
+            x11.image = NULL;
+            return;
+        }
+    }
+
+    nk_raster_set_target((nk_uint*)x11.image->data, width, height,
+        (unsigned int)x11.image->bytes_per_line / 4);
+}
+
+static void
+nk_x11_blit(void)
+{
+    if (!x11.image)
+        return;
+
+    if (x11.shared) {
+        /* the copy happens when the server gets to the request, the next
+         * frame waits for that before drawing into the image again */
+        XShmPutImage(x11.display, x11.window, x11.gc, x11.image,
+            0, 0, 0, 0, x11.width, x11.height, False);
+        x11.pending = 1;
+    } else {
+        XPutImage(x11.display, x11.window, x11.gc, x11.image,
+            0, 0, 0, 0, x11.width, x11.height);
+    }
+    XFlush(x11.display);
+}
+
+NK_API struct nk_context*
+nk_x11_init(Display *display, Window window, unsigned int width, unsigned int height)
+{
+    XWindowAttributes attributes;
+    XGetWindowAttributes(display, window, &attributes);
+
+    x11.display = display;
+    x11.window = window;
+    x11.visual = attributes.visual;
+    x11.depth = attributes.depth;
+    x11.gc = XCreateGC(display, window, 0, NULL);
+    x11.shm_failed = 0;
+
+    x11.ctx = nk_raster_init(width, height);
+    nk_x11_create_image(width, height);
+    return x11.ctx;
+}
+
+NK_API int
+nk_x11_is_shared(void)
+{
+    return x11.shared;
+}
+
+NK_API int
+nk_x11_handle_event(XEvent *event)
+{
+    struct nk_context *ctx = x11.ctx;
+
+    switch (event->type)
+    {
+    case ConfigureNotify:
+    {
+        unsigned int width = (unsigned int)event->xconfigure.width;
+        unsigned int height = (unsigned int)event->xconfigure.height;
+        if (width != x11.width || height != x11.height)
+            nk_x11_create_image(width, height);
+        return 0;
+    }
+
+    case Expose:
+        if (event->xexpose.count == 0)
+            nk_x11_blit();
+        return 1;
+
+    case KeyPress:
+    case KeyRelease:
+    {
+        int down = event->type == KeyPress;
+        int ctrl = (event->xkey.state & ControlMask) != 0;
+        KeySym sym = XLookupKeysym(&event->xkey, 0);
+
+        switch (sym)
+        {
+        case XK_Shift_L:
+        case XK_Shift_R:
+            nk_input_key(ctx, NK_KEY_SHIFT, down);
+            return 1;
+
+        case XK_Delete:
+            nk_input_key(ctx, NK_KEY_DEL, down);
+            return 1;
+
+        case XK_Return:
+            nk_input_key(ctx, NK_KEY_ENTER, down);
+            return 1;
+
+        case XK_Tab:
+            nk_input_key(ctx, NK_KEY_TAB, down);
+            return 1;
+
+        case XK_Left:
+            if (ctrl)
+                nk_input_key(ctx, NK_KEY_TEXT_WORD_LEFT, down);
+            else
+                nk_input_key(ctx, NK_KEY_LEFT, down);
+            return 1;
+
+        case XK_Right:
+            if (ctrl)
+                nk_input_key(ctx, NK_KEY_TEXT_WORD_RIGHT, down);
+            else
+                nk_input_key(ctx, NK_KEY_RIGHT, down);
+            return 1;
+
+        case XK_BackSpace:
+            nk_input_key(ctx, NK_KEY_BACKSPACE, down);
+            return 1;
+
+        case XK_Home:
+            nk_input_key(ctx, NK_KEY_TEXT_START, down);
+            nk_input_key(ctx, NK_KEY_SCROLL_START, down);
+            return 1;
+
+        case XK_End:
+            nk_input_key(ctx, NK_KEY_TEXT_END, down);
+            nk_input_key(ctx, NK_KEY_SCROLL_END, down);
+            return 1;
+
+        case XK_Page_Down:
+            nk_input_key(ctx, NK_KEY_SCROLL_DOWN, down);
+            return 1;
+
+        case XK_Page_Up:
+            nk_input_key(ctx, NK_KEY_SCROLL_UP, down);
+            return 1;
+
+        case XK_c:
+            if (ctrl) {
+                nk_input_key(ctx, NK_KEY_COPY, down);
+                return 1;
+            }
+            break;
+
+        case XK_v:
+            if (ctrl) {
+                nk_input_key(ctx, NK_KEY_PASTE, down);
+                return 1;
+            }
+            break;
+
+        case XK_x:
+            if (ctrl) {
+                nk_input_key(ctx, NK_KEY_CUT, down);
+                return 1;
+            }
+            break;
+
+        case XK_z:
+            if (ctrl) {
+                nk_input_key(ctx, NK_KEY_TEXT_UNDO, down);
+                return 1;
+            }
+            break;
+
+        case XK_r:
+            if (ctrl) {
+                nk_input_key(ctx, NK_KEY_TEXT_REDO, down);
+                return 1;
+            }
+            break;
+        }
+
+        if (down && !ctrl) {
+            char text[8];
+            int i, length = XLookupString(&event->xkey, text, sizeof(text), NULL, NULL);
+            for (i = 0; i < length; ++i) {
+                if ((unsigned char)text[i] >= 32 && text[i] != 127)
+                    nk_input_char(ctx, text[i]);
+            }
+            return length > 0;
+        }
+        return 0;
+    }
+
+    case ButtonPress:
+    case ButtonRelease:
+    {
+        int down = event->type == ButtonPress;
+        int x = event->xbutton.x;
+        int y = event->xbutton.y;
+
+        switch (event->xbutton.button)
+        {
+        case Button1:
+            if (down) {
+                int twice = event->xbutton.time - x11.last_click < NK_X11_DOUBLE_CLICK_MS;
+                nk_input_button(ctx, NK_BUTTON_DOUBLE, x, y, twice);
+                x11.last_click = twice ? 0 : event->xbutton.time;
+            } else {
+                nk_input_button(ctx, NK_BUTTON_DOUBLE, x, y, 0);
+            }
+            nk_input_button(ctx, NK_BUTTON_LEFT, x, y, down);
+            return 1;
+
+        case Button2:
+            nk_input_button(ctx, NK_BUTTON_MIDDLE, x, y, down);
+            return 1;
+
+        case Button3:
+            nk_input_button(ctx, NK_BUTTON_RIGHT, x, y, down);
+            return 1;
+
+        /* the wheel arrives as a press and release of buttons 4 and 5 */
+        case Button4:
+            if (down)
+                nk_input_scroll(ctx, nk_vec2(0, 1.0f));
+            return 1;
+
+        case Button5:
+            if (down)
+                nk_input_scroll(ctx, nk_vec2(0, -1.0f));
+            return 1;
+        }
+        return 0;
+    }
+
+    case MotionNotify:
+        nk_input_motion(ctx, event->xmotion.x, event->xmotion.y);
+        return 1;
+    }
+
+    return 0;
+}
+
+NK_API void
+nk_x11_draw(struct nk_color clear)
+{
+    if (x11.pending) {
+        XSync(x11.display, False);
+        x11.pending = 0;
+    }
+
+    nk_raster_render(clear);
+}
+
+NK_API void
+nk_x11_present(void)
+{
+    nk_x11_blit();
+}
+
+NK_API void
+nk_x11_render(struct nk_color clear)
+{
+    nk_x11_draw(clear);
+    nk_x11_present();
+}
+
+NK_API void
+nk_x11_shutdown(void)
+{
+    nk_x11_destroy_image();
+    nk_raster_shutdown();
+    XFreeGC(x11.display, x11.gc);
+    memset(&x11, 0, sizeof(x11));
+}
+
+#endif
@@ -1,9 +1,20 @@
-#define _WIN32_LEAN_AND_MEAN
-#include <windows.h>
+#include <string.h>  // memset, memcpy
+#include <algorithm> // std::remove_if
+#include <atomic>    // std::atomic
+#include <chrono>    // std::chrono::steady_clock
+#include <mutex>     // std::mutex, std::lock_guard
+#include <vector>    // std::vector
 
 #include "nvapi.h"
+#include "nvapi_sim.h"
+#include "nvapi_fault.h"
 #include "log.h"
 
+#ifndef NVFC_SIMULATE
+#define _WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#endif
+
 // Constructors for NvAPI structures that just zero the memory and set the right version
 NV_DELTA_ENTRY::NV_DELTA_ENTRY()
 {
@@ -46,6 +57,12 @@ NV_GPU_POWER_POLICIES_STATUS_V1::NV_GPU_POWER_POLICIES_STATUS_V1()
 	version = NV_STRUCT_VERSION(NV_GPU_POWER_POLICIES_STATUS_V1, 1);
 }
 
+NV_GPU_POWER_TOPOLOGY_STATUS_V1::NV_GPU_POWER_TOPOLOGY_STATUS_V1()
+{
+	memset(this, 0, sizeof *this);
+	version = NV_STRUCT_VERSION(NV_GPU_POWER_TOPOLOGY_STATUS_V1, 1);
+}
+
 NV_GPU_VOLTAGE_DOMAINS_STATUS_V1::NV_GPU_VOLTAGE_DOMAINS_STATUS_V1()
 {
 	memset(this, 0, sizeof *this);
@@ -165,6 +182,11 @@ static NV_STATUS (*pNvAPI_GPU_GetPowerPoliciesStatus)(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_POWER_POLICIES_STATUS_V1 *policies_status);
 
+// Interface: 0EDCF624E
+static NV_STATUS (*pNvAPI_GPU_ClientPowerTopologyGetStatus)(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_TOPOLOGY_STATUS_V1 *topology_status);
+
 // Interface: 0C16C7E2C
 static NV_STATUS (*pNvAPI_GPU_GetVoltageDomainStatus)(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
@@ -221,9 +243,12 @@ static NV_STATUS (*pNvAPI_GPU_GetPCIIdentifiers)(
 	NV_U32 *revision_id,
 	NV_U32 *ext_device_id);
 
-static bool QueryInterfaceOpaque(FARPROC query_interface, NV_U32 id, void **result)
+// Signature of nvapi_QueryInterface
+typedef void *(*QueryInterfaceFunction)(NV_U32 id);
+
+static bool QueryInterfaceOpaque(QueryInterfaceFunction query_interface, NV_U32 id, void **result)
 {
-	void *address = ((void *(*)(NV_U32))query_interface)(id);
+	void *address = query_interface(id);
 	if (address) {
 		*result = address;
 		return true;
@@ -231,19 +256,55 @@ static bool QueryInterfaceOpaque(FARPROC query_interface, NV_U32 id, void **resu
 	return false;
 }
 
-template<typename F>
-static void QueryInterfaceCast(FARPROC query_interface, NV_U32 id, const char *function_name, F &function_pointer)
+// Stands in for interface [ID] when it has a fault rule, one instantiation per interface
+// as several interfaces share a signature
+template<NV_U32 ID, typename F>
+struct Injected;
+
+template<NV_U32 ID, typename... Args>
+struct Injected<ID, NV_STATUS (*)(Args...)> {
+	static NV_STATUS (*target)(Args...);
+	static int slot;
+
+	static NV_STATUS Call(Args... args)
+	{
+		NV_STATUS status;
+		if (!NvFaultInject(slot, &status)) {
+			return status;
+		}
+		return (*target)(args...);
+	}
+};
+
+template<NV_U32 ID, typename... Args>
+NV_STATUS (*Injected<ID, NV_STATUS (*)(Args...)>::target)(Args...);
+
+template<NV_U32 ID, typename... Args>
+int Injected<ID, NV_STATUS (*)(Args...)>::slot;
+
+template<NV_U32 ID, typename F>
+static void QueryInterfaceCast(QueryInterfaceFunction query_interface, const char *function_name, F &function_pointer)
 {
-	const bool result = QueryInterfaceOpaque(query_interface, id, (void **)&function_pointer);
-	Log::write("%s querying interface '0x%08x' '%s'", result ? "success" : "failure", id, function_name);
+	const bool result = QueryInterfaceOpaque(query_interface, ID, (void **)&function_pointer);
+	Log::write("%s querying interface '0x%08x' '%s'", result ? "success" : "failure", ID, function_name);
+	if (!result) {
+		return;
+	}
+
+	const int slot = NvFaultAttach(function_name);
+	if (slot >= 0) {
+		Injected<ID, F>::target = function_pointer;
+		Injected<ID, F>::slot = slot;
+		function_pointer = &Injected<ID, F>::Call;
+	}
 }
 
 #define QueryInterface(query_interface, id, function) \
-	QueryInterfaceCast((query_interface), (id), #function, p ## function)
+	QueryInterfaceCast<(id)>((query_interface), #function, p ## function)
 
-static void QueryInterfaces(FARPROC query_interface)
+static void QueryInterfaces(QueryInterfaceFunction query_interface)
 {
-	Log::write("querying interfaces with '0x%p'", query_interface);
+	Log::write("querying interfaces with '0x%p'", reinterpret_cast<void *>(query_interface));
 
 	QueryInterface(query_interface, 0x0150E828, NvAPI_Initialize);
 	QueryInterface(query_interface, 0xD22BDD7E, NvAPI_Unload);
@@ -261,6 +322,7 @@ static void QueryInterfaces(FARPROC query_interface)
 	QueryInterface(query_interface, 0x60DED2ED, NvAPI_GPU_GetDynamicPStates); 
 	QueryInterface(query_interface, 0x34206D86, NvAPI_GPU_GetPowerPoliciesInfo);
 	QueryInterface(query_interface, 0x70916171, NvAPI_GPU_GetPowerPoliciesStatus);
+	QueryInterface(query_interface, 0x0EDCF624E, NvAPI_GPU_ClientPowerTopologyGetStatus);
 	QueryInterface(query_interface, 0x0C16C7E2C, NvAPI_GPU_GetVoltageDomainStatus);
 	QueryInterface(query_interface, 0x0E3640A56, NvAPI_GPU_GetThermalSettings);
 	QueryInterface(query_interface, 0x014B83A5F, NvAPI_GPU_GetSerialNumber);
@@ -273,9 +335,189 @@ static void QueryInterfaces(FARPROC query_interface)
 	QueryInterface(query_interface, 0x2DDFB66E, NvAPI_GPU_GetPCIIdentifiers);
 }
 
+// Response cache, one list of entries per interface as there are only ever a few handles
+struct CacheEntry {
+	const void *handle;
+	NV_S32 argument;
+	double time;
+	std::vector<unsigned char> response;
+};
+
+static constexpr NV_U32 kCacheInterfaces = static_cast<NV_U32>(NV_CACHE_INTERFACE::LAST);
+
+static struct {
+	std::atomic<double> windows[kCacheInterfaces];
+	std::mutex mutex;
+	std::vector<CacheEntry> entries[kCacheInterfaces];
+	uint64_t generations[kCacheInterfaces];
+	NV_CACHE_STATS stats[kCacheInterfaces];
+} s_cache;
+
+static thread_local uint64_t s_thread_hits = 0;
+
+static double CacheTime()
+{
+	static const auto start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Serves [response] from the cache when it is fresh, otherwise calls [call] and caches what it returned
+template<typename T, typename Call>
+static NV_STATUS Cached(NV_CACHE_INTERFACE cache_interface, const void *handle, NV_S32 argument, T *response, Call call)
+{
+	const NV_U32 index = static_cast<NV_U32>(cache_interface);
+	const double window = s_cache.windows[index].load(std::memory_order_relaxed);
+	if (window <= 0.0 || !response) {
+		return call();
+	}
+
+	uint64_t generation;
+	{
+		const double now = CacheTime();
+		std::lock_guard<std::mutex> lock(s_cache.mutex);
+		generation = s_cache.generations[index];
+		for (const auto &entry : s_cache.entries[index]) {
+			if (entry.handle == handle && entry.argument == argument && now - entry.time < window) {
+				memcpy(response, entry.response.data(), sizeof(T));
+				s_cache.stats[index].hits++;
+				s_thread_hits++;
+				return 0;
+			}
+		}
+		s_cache.stats[index].misses++;
+	}
+
+	// The lock is not held across the driver call, two threads missing at once both call it
+	const NV_STATUS status = call();
+	if (status != 0) {
+		return status;
+	}
+
+	// A write which invalidated the interface during the call may have changed the response already
+	const double now = CacheTime();
+	std::lock_guard<std::mutex> lock(s_cache.mutex);
+	if (s_cache.generations[index] != generation) {
+		return status;
+	}
+	auto &entries = s_cache.entries[index];
+	CacheEntry *entry = nullptr;
+	for (auto &candidate : entries) {
+		if (candidate.handle == handle && candidate.argument == argument) {
+			entry = &candidate;
+			break;
+		}
+	}
+	if (!entry) {
+		entries.push_back({ handle, argument, 0.0, std::vector<unsigned char>(sizeof(T)) });
+		entry = &entries.back();
+	}
+	entry->time = now;
+	memcpy(entry->response.data(), response, sizeof(T));
+	return status;
+}
+
+// Called by writes once the driver returned, together with the generation check in
+// Cached no response from before the write is served after it
+static void Invalidate(NV_CACHE_INTERFACE cache_interface, const void *handle)
+{
+	const NV_U32 index = static_cast<NV_U32>(cache_interface);
+	std::lock_guard<std::mutex> lock(s_cache.mutex);
+	s_cache.generations[index]++;
+	auto &entries = s_cache.entries[index];
+	entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const CacheEntry &entry) {
+		return entry.handle == handle;
+	}), entries.end());
+}
+
+void NvAPI_SetCacheWindow(NV_CACHE_INTERFACE cache_interface, double seconds)
+{
+	s_cache.windows[static_cast<NV_U32>(cache_interface)].store(seconds);
+}
+
+void NvAPI_SetCacheWindow(double seconds)
+{
+	for (NV_U32 i = 0; i < kCacheInterfaces; i++) {
+		NvAPI_SetCacheWindow(static_cast<NV_CACHE_INTERFACE>(i), seconds);
+	}
+}
+
+void NvAPI_FlushCache()
+{
+	// Reads in flight must not put back what they got from before the flush
+	std::lock_guard<std::mutex> lock(s_cache.mutex);
+	for (NV_U32 i = 0; i < kCacheInterfaces; i++) {
+		s_cache.generations[i]++;
+		s_cache.entries[i].clear();
+	}
+}
+
+NV_CACHE_STATS NvAPI_GetCacheStats(NV_CACHE_INTERFACE cache_interface)
+{
+	std::lock_guard<std::mutex> lock(s_cache.mutex);
+	return s_cache.stats[static_cast<NV_U32>(cache_interface)];
+}
+
+uint64_t NvAPI_GetThreadCacheHits()
+{
+	return s_thread_hits;
+}
+
+const char *NvAPI_GetCacheInterfaceName(NV_CACHE_INTERFACE cache_interface)
+{
+	switch (cache_interface) {
+	case NV_CACHE_INTERFACE::MEMORY_INFO:
+		return "NvAPI_GetMemoryInfo";
+	case NV_CACHE_INTERFACE::PSTATES20:
+		return "NvAPI_GPU_GetPStates20";
+	case NV_CACHE_INTERFACE::ALL_CLOCK_FREQUENCIES:
+		return "NvAPI_GPU_GetAllClockFrequencies";
+	case NV_CACHE_INTERFACE::DYNAMIC_PSTATES:
+		return "NvAPI_GPU_GetDynamicPStates";
+	case NV_CACHE_INTERFACE::POWER_POLICIES_INFO:
+		return "NvAPI_GPU_GetPowerPoliciesInfo";
+	case NV_CACHE_INTERFACE::POWER_POLICIES_STATUS:
+		return "NvAPI_GPU_GetPowerPoliciesStatus";
+	case NV_CACHE_INTERFACE::POWER_TOPOLOGY_STATUS:
+		return "NvAPI_GPU_ClientPowerTopologyGetStatus";
+	case NV_CACHE_INTERFACE::VOLTAGE_DOMAIN_STATUS:
+		return "NvAPI_GPU_GetVoltageDomainStatus";
+	case NV_CACHE_INTERFACE::THERMAL_SETTINGS:
+		return "NvAPI_GPU_GetThermalSettings";
+	case NV_CACHE_INTERFACE::THERMAL_POLICIES_INFO:
+		return "NvAPI_GPU_GetThermalPoliciesInfo";
+	case NV_CACHE_INTERFACE::THERMAL_POLICIES_STATUS:
+		return "NvAPI_GPU_GetThermalPoliciesStatus";
+	case NV_CACHE_INTERFACE::COOLER_SETTINGS:
+		return "NvAPI_GPU_GetCoolerSettings";
+	case NV_CACHE_INTERFACE::LAST:
+		break;
+	}
+	return "unknown";
+}
+
+void NvAPI_LogCacheStats()
+{
+	for (NV_U32 i = 0; i < kCacheInterfaces; i++) {
+		const auto cache_interface = static_cast<NV_CACHE_INTERFACE>(i);
+		if (s_cache.windows[i].load() <= 0.0) {
+			continue;
+		}
+		const NV_CACHE_STATS stats = NvAPI_GetCacheStats(cache_interface);
+		const uint64_t total = stats.hits + stats.misses;
+		Log::write("cache '%s': %.1f%% hits of %llu reads",
+			NvAPI_GetCacheInterfaceName(cache_interface),
+			total ? 100.0 * stats.hits / total : 0.0,
+			static_cast<unsigned long long>(total));
+	}
+}
+
 NV_STATUS NvAPI_Initialize()
 {
 	if (!pNvAPI_Initialize) {
+#ifdef NVFC_SIMULATE
+		Log::write("using the simulated driver");
+		QueryInterfaces(NvSimQueryInterface);
+#else
 		const char *name = sizeof(void*) == 4 ? "nvapi.dll" : "nvapi64.dll";
 		HMODULE nvapi = LoadLibraryA(name);
 		if (!nvapi) {
@@ -291,7 +533,8 @@ NV_STATUS NvAPI_Initialize()
 			return -1;
 		}
 
-		QueryInterfaces(query_interface);
+		QueryInterfaces(reinterpret_cast<QueryInterfaceFunction>(query_interface));
+#endif
 	}
 
 	return pNvAPI_Initialize
@@ -355,9 +598,11 @@ NV_STATUS NvAPI_GetMemoryInfo(
 	NV_DISPLAY_HANDLE display_handle,
 	NV_MEMORY_INFO_V2 *memory_info)
 {
-	return pNvAPI_GetMemoryInfo
-		? (*pNvAPI_GetMemoryInfo)(display_handle, memory_info)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::MEMORY_INFO, display_handle, 0, memory_info, [&] {
+		return pNvAPI_GetMemoryInfo
+			? (*pNvAPI_GetMemoryInfo)(display_handle, memory_info)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_GetFullName(
@@ -373,63 +618,90 @@ NV_STATUS NvAPI_GPU_GetPStates20(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_PSTATES20_V2 *pstates)
 {
-	return pNvAPI_GPU_GetPStates20
-		? (*pNvAPI_GPU_GetPStates20)(physical_gpu_handle, pstates)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::PSTATES20, physical_gpu_handle, 0, pstates, [&] {
+		return pNvAPI_GPU_GetPStates20
+			? (*pNvAPI_GPU_GetPStates20)(physical_gpu_handle, pstates)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_SetPStates20(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_PSTATES20_V2 *pstates)
 {
-	return pNvAPI_GPU_SetPStates20
-		? (*pNvAPI_GPU_GetPStates20)(physical_gpu_handle, pstates)
+	const NV_STATUS status = pNvAPI_GPU_SetPStates20
+		? (*pNvAPI_GPU_SetPStates20)(physical_gpu_handle, pstates)
 		: -1;
+
+	Invalidate(NV_CACHE_INTERFACE::PSTATES20, physical_gpu_handle);
+	Invalidate(NV_CACHE_INTERFACE::ALL_CLOCK_FREQUENCIES, physical_gpu_handle);
+	return status;
 }
 
 NV_STATUS NvAPI_GPU_GetAllClockFrequencies(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_CLOCK_FREQUENCIES_V2 *frequencies)
 {
-	return pNvAPI_GPU_GetAllClockFrequencies
-		? (*pNvAPI_GPU_GetAllClockFrequencies)(physical_gpu_handle, frequencies)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::ALL_CLOCK_FREQUENCIES, physical_gpu_handle, frequencies ? static_cast<NV_S32>(frequencies->clock_type) : 0, frequencies, [&] {
+		return pNvAPI_GPU_GetAllClockFrequencies
+			? (*pNvAPI_GPU_GetAllClockFrequencies)(physical_gpu_handle, frequencies)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_GetDynamicPStates(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_DYNAMIC_PSTATES_V1 *dynamic_pstates)
 {
-	return pNvAPI_GPU_GetDynamicPStates
-		? (*pNvAPI_GPU_GetDynamicPStates)(physical_gpu_handle, dynamic_pstates)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::DYNAMIC_PSTATES, physical_gpu_handle, 0, dynamic_pstates, [&] {
+		return pNvAPI_GPU_GetDynamicPStates
+			? (*pNvAPI_GPU_GetDynamicPStates)(physical_gpu_handle, dynamic_pstates)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_GetPowerPoliciesInfo(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_POWER_POLICIES_INFO_V1 *policies_info)
 {
-	return pNvAPI_GPU_GetPowerPoliciesInfo
-		? (*pNvAPI_GPU_GetPowerPoliciesInfo)(physical_gpu_handle, policies_info)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::POWER_POLICIES_INFO, physical_gpu_handle, 0, policies_info, [&] {
+		return pNvAPI_GPU_GetPowerPoliciesInfo
+			? (*pNvAPI_GPU_GetPowerPoliciesInfo)(physical_gpu_handle, policies_info)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_GetPowerPoliciesStatus(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_POWER_POLICIES_STATUS_V1 *policies_status)
 {
-	return pNvAPI_GPU_GetPowerPoliciesStatus
-		? (*NvAPI_GPU_GetPowerPoliciesStatus)(physical_gpu_handle, policies_status)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::POWER_POLICIES_STATUS, physical_gpu_handle, 0, policies_status, [&] {
+		return pNvAPI_GPU_GetPowerPoliciesStatus
+			? (*pNvAPI_GPU_GetPowerPoliciesStatus)(physical_gpu_handle, policies_status)
+			: -1;
+	});
+}
+
+NV_STATUS NvAPI_GPU_ClientPowerTopologyGetStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_TOPOLOGY_STATUS_V1 *topology_status)
+{
+	return Cached(NV_CACHE_INTERFACE::POWER_TOPOLOGY_STATUS, physical_gpu_handle, 0, topology_status, [&] {
+		return pNvAPI_GPU_ClientPowerTopologyGetStatus
+			? (*pNvAPI_GPU_ClientPowerTopologyGetStatus)(physical_gpu_handle, topology_status)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_GetVoltageDomainStatus(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_VOLTAGE_DOMAINS_STATUS_V1 *voltage_domains_status)
 {
-	return pNvAPI_GPU_GetVoltageDomainStatus
-		? (*pNvAPI_GPU_GetVoltageDomainStatus)(physical_gpu_handle, voltage_domains_status)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::VOLTAGE_DOMAIN_STATUS, physical_gpu_handle, 0, voltage_domains_status, [&] {
+		return pNvAPI_GPU_GetVoltageDomainStatus
+			? (*pNvAPI_GPU_GetVoltageDomainStatus)(physical_gpu_handle, voltage_domains_status)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_GetThermalSettings(
@@ -437,9 +709,11 @@ NV_STATUS NvAPI_GPU_GetThermalSettings(
 	NV_THERMAL_TARGET sensor_index,
 	NV_GPU_THERMAL_SETTINGS_V2 *thermal_settings)
 {
-	return pNvAPI_GPU_GetThermalSettings
-		? (*pNvAPI_GPU_GetThermalSettings)(physical_gpu_handle, sensor_index, thermal_settings)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::THERMAL_SETTINGS, physical_gpu_handle, static_cast<NV_S32>(sensor_index), thermal_settings, [&] {
+		return pNvAPI_GPU_GetThermalSettings
+			? (*pNvAPI_GPU_GetThermalSettings)(physical_gpu_handle, sensor_index, thermal_settings)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_GetSerialNumber(
@@ -455,36 +729,46 @@ NV_STATUS NvAPI_GPU_SetPowerPoliciesStatus(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_POWER_POLICIES_STATUS_V1* policies_status)
 {
-	return pNvAPI_GPU_SetPowerPoliciesStatus
+	const NV_STATUS status = pNvAPI_GPU_SetPowerPoliciesStatus
 		? (*pNvAPI_GPU_SetPowerPoliciesStatus)(physical_gpu_handle, policies_status)
 		: -1;
+
+	Invalidate(NV_CACHE_INTERFACE::POWER_POLICIES_STATUS, physical_gpu_handle);
+	return status;
 }
 
 NV_STATUS NvAPI_GPU_GetThermalPoliciesInfo(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_THERMAL_POLICIES_INFO_V2* thermal_info)
 {
-	return pNvAPI_GPU_GetThermalPoliciesInfo
-		? (*pNvAPI_GPU_GetThermalPoliciesInfo)(physical_gpu_handle, thermal_info)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::THERMAL_POLICIES_INFO, physical_gpu_handle, 0, thermal_info, [&] {
+		return pNvAPI_GPU_GetThermalPoliciesInfo
+			? (*pNvAPI_GPU_GetThermalPoliciesInfo)(physical_gpu_handle, thermal_info)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_GetThermalPoliciesStatus(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_THERMAL_POLICIES_STATUS_V2* thermal_status)
 {
-	return pNvAPI_GPU_GetThermalPoliciesStatus
-		? (*pNvAPI_GPU_GetThermalPoliciesStatus)(physical_gpu_handle, thermal_status)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::THERMAL_POLICIES_STATUS, physical_gpu_handle, 0, thermal_status, [&] {
+		return pNvAPI_GPU_GetThermalPoliciesStatus
+			? (*pNvAPI_GPU_GetThermalPoliciesStatus)(physical_gpu_handle, thermal_status)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_SetThermalPoliciesStatus(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_THERMAL_POLICIES_STATUS_V2* thermal_status)
 {
-	return pNvAPI_GPU_SetThermalPoliciesStatus
+	const NV_STATUS status = pNvAPI_GPU_SetThermalPoliciesStatus
 		? (*pNvAPI_GPU_SetThermalPoliciesStatus)(physical_gpu_handle, thermal_status)
 		: -1;
+
+	Invalidate(NV_CACHE_INTERFACE::THERMAL_POLICIES_STATUS, physical_gpu_handle);
+	return status;
 }
 
 NV_STATUS NvAPI_GPU_GetCoolerSettings(
@@ -492,9 +776,11 @@ NV_STATUS NvAPI_GPU_GetCoolerSettings(
 	NV_S32 cooler_index,
 	NV_GPU_COOLER_SETTINGS_V2 *cooler_settings)
 {
-	return pNvAPI_GPU_GetCoolerSettings
-		? (*pNvAPI_GPU_GetCoolerSettings)(physical_gpu_handle, cooler_index, cooler_settings)
-		: -1;
+	return Cached(NV_CACHE_INTERFACE::COOLER_SETTINGS, physical_gpu_handle, cooler_index, cooler_settings, [&] {
+		return pNvAPI_GPU_GetCoolerSettings
+			? (*pNvAPI_GPU_GetCoolerSettings)(physical_gpu_handle, cooler_index, cooler_settings)
+			: -1;
+	});
 }
 
 NV_STATUS NvAPI_GPU_SetCoolerLevels(
@@ -502,9 +788,12 @@ NV_STATUS NvAPI_GPU_SetCoolerLevels(
 	NV_S32 cooler_index,
 	NV_GPU_COOLER_LEVELS_V1 *cooler_levels)
 {
-	return pNvAPI_GPU_SetCoolerLevels
+	const NV_STATUS status = pNvAPI_GPU_SetCoolerLevels
 		? (*pNvAPI_GPU_SetCoolerLevels)(physical_gpu_handle, cooler_index, cooler_levels)
 		: -1;
+
+	Invalidate(NV_CACHE_INTERFACE::COOLER_SETTINGS, physical_gpu_handle);
+	return status;
 }
 
 NV_STATUS NvAPI_GPU_GetPCIIdentifiers(
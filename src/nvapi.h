@@ -161,6 +161,18 @@ struct NV_GPU_POWER_POLICIES_STATUS_V1 {
 	} entries[4];
 };
 
+struct NV_GPU_POWER_TOPOLOGY_STATUS_V1 {
+	NV_GPU_POWER_TOPOLOGY_STATUS_V1();
+	NV_U32 version;
+	NV_U32 count;
+	struct {
+		NV_U32 domain;            // NOTE(dweiler): 0 = gpu, 1 = board
+		NV_U32 : 32;              // NOTE(dweiler): unknown value
+		NV_U32 power;             // NOTE(dweiler): percentage of default power target, multiples of 1000
+		NV_U32 : 32;              // NOTE(dweiler): unknown value
+	} entries[4];
+};
+
 struct NV_GPU_VOLTAGE_DOMAINS_STATUS_V1 {
 	NV_GPU_VOLTAGE_DOMAINS_STATUS_V1();
 	NV_U32 version;
@@ -358,6 +370,16 @@ NV_STATUS NvAPI_GPU_GetPowerPoliciesStatus(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
 	NV_GPU_POWER_POLICIES_STATUS_V1 *policies_status);
 
+// Get the current power draw of the GPU
+//
+// Power is reported per topology domain as a percentage of the default power
+// target, the same unit used by the power policies interfaces.
+//
+// Interface: 0EDCF624E
+NV_STATUS NvAPI_GPU_ClientPowerTopologyGetStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_TOPOLOGY_STATUS_V1 *topology_status);
+
 // Interface: 0C16C7E2C
 NV_STATUS NvAPI_GPU_GetVoltageDomainStatus(
 	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
@@ -424,4 +446,51 @@ NV_STATUS NvAPI_GPU_GetPCIIdentifiers(
 	NV_U32 *revision_id,
 	NV_U32 *ext_device_id);
 
+// Response cache of the wrapper layer
+//
+// Reads of one interface for the same handle, and the same clock type, sensor or
+// cooler where the interface takes one, are served from memory while the last
+// successful response is younger than the window of the interface. Failed reads
+// are never cached. Writes drop the cached responses they change: SetCoolerLevels
+// those of GetCoolerSettings, SetPStates20 those of GetPStates20 and
+// GetAllClockFrequencies, Set*PoliciesStatus those of Get*PoliciesStatus. Every
+// window starts at zero, which disables the cache for that interface.
+enum class NV_CACHE_INTERFACE : NV_U32 {
+	MEMORY_INFO,
+	PSTATES20,
+	ALL_CLOCK_FREQUENCIES,
+	DYNAMIC_PSTATES,
+	POWER_POLICIES_INFO,
+	POWER_POLICIES_STATUS,
+	POWER_TOPOLOGY_STATUS,
+	VOLTAGE_DOMAIN_STATUS,
+	THERMAL_SETTINGS,
+	THERMAL_POLICIES_INFO,
+	THERMAL_POLICIES_STATUS,
+	COOLER_SETTINGS,
+	LAST
+};
+
+struct NV_CACHE_STATS {
+	uint64_t hits;
+	uint64_t misses;
+};
+
+// Freshness window in seconds of one interface, or of every interface
+void NvAPI_SetCacheWindow(NV_CACHE_INTERFACE cache_interface, double seconds);
+void NvAPI_SetCacheWindow(double seconds);
+
+// Drops every cached response
+void NvAPI_FlushCache();
+
+NV_CACHE_STATS NvAPI_GetCacheStats(NV_CACHE_INTERFACE cache_interface);
+
+// Responses served from the cache to the calling thread so far, a call which did not
+// move it reached the driver
+uint64_t NvAPI_GetThreadCacheHits();
+const char *NvAPI_GetCacheInterfaceName(NV_CACHE_INTERFACE cache_interface);
+
+// Writes the hit rate of every interface with a window to the log
+void NvAPI_LogCacheStats();
+
 #endif
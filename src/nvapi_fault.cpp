@@ -0,0 +1,266 @@
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>  // std::atomic
+#include <chrono>  // std::chrono::duration
+#include <mutex>   // std::mutex, std::lock_guard
+#include <random>  // std::mt19937_64, std::uniform_real_distribution, std::exponential_distribution
+#include <string>  // std::string
+#include <thread>  // std::this_thread::sleep_for
+#include <vector>  // std::vector
+
+#include "nvapi_fault.h"
+#include "log.h"
+
+struct Rule {
+	std::string name;
+	NV_FAULT_RULE rule;
+};
+
+struct Slot {
+	std::string name;
+	bool specific;      // has a rule of its own rather than the "*" one
+	NV_FAULT_RULE rule;
+	NV_FAULT_STATS stats;
+};
+
+static std::mutex s_mutex;
+static std::vector<Rule> s_rules;
+static std::vector<Slot> s_slots;
+static std::atomic<uint64_t> s_seed { 0x4E564643 };
+static bool s_environment_read = false;
+
+// Name without the NvAPI_ or NvAPI_GPU_ prefix
+static const char *ShortName(const char *name)
+{
+	if (strncmp(name, "NvAPI_GPU_", 10) == 0) {
+		return name + 10;
+	}
+	if (strncmp(name, "NvAPI_", 6) == 0) {
+		return name + 6;
+	}
+	return name;
+}
+
+static bool Matches(const std::string &rule_name, const std::string &function_name)
+{
+	return rule_name == function_name || rule_name == ShortName(function_name.c_str());
+}
+
+NV_FAULT_RULE NvFaultDefaultRule()
+{
+	return { 0.0, -1, 0.0, 0.0, 0.0, 0.0 };
+}
+
+void NvFaultSetRule(const char *name, const NV_FAULT_RULE &rule)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const std::string rule_name = name;
+	const bool any = rule_name == "*";
+
+	bool found = false;
+	for (auto &entry : s_rules) {
+		if (entry.name == rule_name) {
+			entry.rule = rule;
+			found = true;
+		}
+	}
+	if (!found) {
+		s_rules.push_back({ rule_name, rule });
+	}
+
+	// Interfaces wrapped already pick the rule up at once
+	for (auto &slot : s_slots) {
+		if (any ? !slot.specific : Matches(rule_name, slot.name)) {
+			slot.rule = rule;
+			slot.specific |= !any;
+		}
+	}
+}
+
+void NvFaultClearRules()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	s_rules.clear();
+	for (auto &slot : s_slots) {
+		slot.specific = false;
+		slot.rule = NvFaultDefaultRule();
+	}
+}
+
+static bool ParseRule(const char *text, const char *end)
+{
+	const char *colon = static_cast<const char *>(memchr(text, ':', end - text));
+	if (!colon || colon == text) {
+		return false;
+	}
+
+	const std::string name(text, colon);
+	NV_FAULT_RULE rule = NvFaultDefaultRule();
+	const char *field = colon + 1;
+	while (field < end) {
+		const char *comma = static_cast<const char *>(memchr(field, ',', end - field));
+		const char *field_end = comma ? comma : end;
+		const char *equals = static_cast<const char *>(memchr(field, '=', field_end - field));
+		if (!equals) {
+			return false;
+		}
+
+		const std::string key(field, equals);
+		const std::string text_value(equals + 1, field_end);
+		char *parsed = nullptr;
+		const double value = strtod(text_value.c_str(), &parsed);
+		if (text_value.empty() || *parsed != '\0') {
+			return false;
+		}
+
+		if (key == "error_rate") {
+			rule.error_rate = value;
+		} else if (key == "error") {
+			rule.error = static_cast<NV_STATUS>(value);
+		} else if (key == "latency") {
+			rule.latency = value;
+		} else if (key == "jitter") {
+			rule.jitter = value;
+		} else if (key == "stall_rate") {
+			rule.stall_rate = value;
+		} else if (key == "stall") {
+			rule.stall = value;
+		} else {
+			return false;
+		}
+		field = field_end + 1;
+	}
+
+	NvFaultSetRule(name.c_str(), rule);
+	return true;
+}
+
+bool NvFaultParse(const char *rules)
+{
+	const char *text = rules;
+	const char *end = rules + strlen(rules);
+	while (text < end) {
+		const char *semicolon = static_cast<const char *>(memchr(text, ';', end - text));
+		const char *rule_end = semicolon ? semicolon : end;
+		if (rule_end != text && !ParseRule(text, rule_end)) {
+			return false;
+		}
+		text = rule_end + 1;
+	}
+	return true;
+}
+
+void NvFaultSeed(uint64_t seed)
+{
+	s_seed.store(seed);
+}
+
+int NvFaultAttach(const char *function_name)
+{
+	if (!s_environment_read) {
+		s_environment_read = true;
+		if (const char *rules = getenv("NVFC_FAULTS")) {
+			if (NvFaultParse(rules)) {
+				Log::write("injecting faults '%s'", rules);
+			} else {
+				Log::write("failed to parse NVFC_FAULTS '%s'", rules);
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const Rule *any = nullptr;
+	const Rule *specific = nullptr;
+	for (const auto &rule : s_rules) {
+		if (rule.name == "*") {
+			any = &rule;
+		} else if (Matches(rule.name, function_name)) {
+			specific = &rule;
+		}
+	}
+	if (!any && !specific) {
+		return -1;
+	}
+
+	const Rule &rule = specific ? *specific : *any;
+	s_slots.push_back({ function_name, specific != nullptr, rule.rule, {} });
+	return static_cast<int>(s_slots.size() - 1);
+}
+
+bool NvFaultInject(int slot, NV_STATUS *status)
+{
+	// Every thread draws from its own generator, seeded from the shared seed and the order threads first inject in
+	static std::atomic<uint64_t> s_threads { 0 };
+	thread_local std::mt19937_64 generator(s_seed.load() + 0x9E3779B97F4A7C15ull * s_threads++);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	NV_FAULT_RULE rule;
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		rule = s_slots[slot].rule;
+	}
+
+	double delay = rule.latency;
+	if (rule.jitter > 0.0) {
+		delay += std::exponential_distribution<double>(1.0 / rule.jitter)(generator);
+	}
+	const bool stall = rule.stall_rate > 0.0 && uniform(generator) < rule.stall_rate;
+	if (stall) {
+		delay += rule.stall;
+	}
+	const bool error = rule.error_rate > 0.0 && uniform(generator) < rule.error_rate;
+
+	if (delay > 0.0) {
+		std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		NV_FAULT_STATS &stats = s_slots[slot].stats;
+		stats.calls++;
+		stats.errors += error;
+		stats.stalls += stall;
+		stats.delay += delay;
+	}
+
+	if (error) {
+		*status = rule.error;
+		return false;
+	}
+	return true;
+}
+
+NV_FAULT_STATS NvFaultGetStats(const char *name)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	for (const auto &slot : s_slots) {
+		if (Matches(name, slot.name)) {
+			return slot.stats;
+		}
+	}
+	return {};
+}
+
+void NvFaultResetStats()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	for (auto &slot : s_slots) {
+		slot.stats = {};
+	}
+}
+
+void NvFaultLogStats()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	for (const auto &slot : s_slots) {
+		if (slot.stats.calls == 0) {
+			continue;
+		}
+		Log::write("faults '%s': %llu calls, %llu failed, %llu stalled, %.3fs added",
+			slot.name.c_str(),
+			static_cast<unsigned long long>(slot.stats.calls),
+			static_cast<unsigned long long>(slot.stats.errors),
+			static_cast<unsigned long long>(slot.stats.stalls),
+			slot.stats.delay);
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef NVAPI_FAULT_H
+#define NVAPI_FAULT_H
+#include <stdint.h>
+
+#include "nvapi.h"
+
+// Fault and latency injection between NVFC and the driver
+//
+// Every interface with a rule is wrapped when NvAPI_Initialize queries it, the
+// wrapper delays each call and fails some of them before they reach the driver,
+// simulated or real. A rule is set for one interface by its function name, with
+// or without the NvAPI_ and NvAPI_GPU_ prefix, or for every interface without a
+// rule of its own with "*". Only interfaces with a rule at initialization are
+// wrapped, their rules may be changed afterwards. Rules are also read from the
+// NVFC_FAULTS environment variable, in the form
+//
+//   GetPowerPoliciesStatus:error_rate=0.3;*:latency=0.0005,jitter=0.001
+struct NV_FAULT_RULE {
+	double error_rate;  // fraction of calls failing with [error] without reaching the driver
+	NV_STATUS error;
+	double latency;     // seconds added to every call
+	double jitter;      // mean of an exponentially distributed number of seconds added on top
+	double stall_rate;  // fraction of calls stalled for [stall] seconds on top
+	double stall;
+};
+
+struct NV_FAULT_STATS {
+	uint64_t calls;
+	uint64_t errors;
+	uint64_t stalls;
+	double delay;       // seconds added in total
+};
+
+NV_FAULT_RULE NvFaultDefaultRule();
+
+void NvFaultSetRule(const char *name, const NV_FAULT_RULE &rule);
+
+// Drops every rule, interfaces wrapped already keep passing through the default rule
+void NvFaultClearRules();
+
+// Adds the rules in [rules], false when they do not parse
+bool NvFaultParse(const char *rules);
+
+// Seed of the random numbers deciding which calls fail or stall
+void NvFaultSeed(uint64_t seed);
+
+// Slot tracking [function_name], -1 when it has no rule and is left alone
+int NvFaultAttach(const char *function_name);
+
+// Delays a call of the interface in [slot], false when the call has to fail with [status]
+bool NvFaultInject(int slot, NV_STATUS *status);
+
+// Statistics of one wrapped interface, zero for interfaces which were not wrapped
+NV_FAULT_STATS NvFaultGetStats(const char *name);
+void NvFaultResetStats();
+void NvFaultLogStats();
+
+#endif
@@ -0,0 +1,720 @@
+#include <algorithm> // std::clamp, std::min, std::max
+#include <chrono>    // std::chrono::steady_clock
+#include <cmath>     // std::sin, std::exp, std::fmod, std::floor
+#include <cstdio>    // snprintf
+#include <cstdlib>   // std::getenv, std::atoi
+#include <cstring>   // memcpy
+#include <mutex>     // std::mutex, std::lock_guard
+#include <vector>    // std::vector
+
+#include "nvapi_sim.h"
+
+// NvAPI status codes the simulation returns
+static constexpr NV_STATUS kOk = 0;
+static constexpr NV_STATUS kInvalidArgument = -5;
+static constexpr NV_STATUS kEndEnumeration = -7;
+static constexpr NV_STATUS kExpectedDisplayHandle = -9;
+static constexpr NV_STATUS kExpectedPhysicalGPUHandle = -101;
+
+// Most GPUs a host is simulated with, the UI enumerates at most this many
+static constexpr int kMaxGPUs = 64;
+
+// Seconds for temperature to cover two thirds of the way to where load takes it
+static constexpr double kThermalTau = 15.0;
+
+struct Model {
+	const char *name;
+	NV_U32 device_id;
+	float base_clock;   // MHz
+	float boost_clock;  // MHz
+	float memory_clock; // MHz
+	NV_U32 memory;      // KiB
+};
+
+static const Model kModels[] = {
+	{ "GeForce GTX 1080 Ti", 0x1B06, 1480.0f, 1582.0f, 5505.0f, 11 * 1024 * 1024 },
+	{ "GeForce RTX 2080",    0x1E87, 1515.0f, 1710.0f, 7000.0f,  8 * 1024 * 1024 },
+	{ "GeForce GTX 1070",    0x1B81, 1506.0f, 1683.0f, 4006.0f,  8 * 1024 * 1024 },
+	{ "GeForce GTX 980",     0x13C0, 1126.0f, 1216.0f, 3505.0f,  4 * 1024 * 1024 },
+};
+
+struct SimulatedGPU {
+	const Model *model;
+	int index;
+	double period;          // seconds per load cycle
+	double phase;
+
+	double time;            // time the thermal state was last advanced to
+	float temperature;
+	float fan_level;
+	bool custom_fan;
+	NV_S32 custom_fan_level;
+	NV_U32 power_limit;     // percentage of default power target, multiples of 1000
+	NV_S32 thermal_limit;   // degrees, multiples of 256
+	NV_S32 core_offset;     // kHz
+	NV_S32 memory_offset;   // kHz
+};
+
+// Values of a GPU at a point in time, derived from its load and thermal state
+struct Sample {
+	float load;             // 0 to 1
+	float temperature;
+	float fan_level;
+	float core_clock;       // MHz
+	float memory_clock;     // MHz
+	float power;            // percentage of default power target
+	float voltage;          // V
+};
+
+static std::mutex s_mutex;
+static std::vector<SimulatedGPU> s_gpus;
+static NV_S32 s_gpu_handles[kMaxGPUs];
+static NV_S32 s_display_handles[kMaxGPUs];
+
+static double Now()
+{
+	static const auto start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void Setup()
+{
+	if (!s_gpus.empty()) {
+		return;
+	}
+
+	int count = 4;
+	if (const char *value = std::getenv("NVFC_SIM_GPUS")) {
+		count = std::clamp(std::atoi(value), 1, kMaxGPUs);
+	}
+
+	s_gpus.resize(count);
+	for (int i = 0; i < count; i++) {
+		auto &gpu = s_gpus[i];
+		gpu.model = &kModels[i % (sizeof kModels / sizeof *kModels)];
+		gpu.index = i;
+		gpu.period = 90.0 + 37.0 * i;
+		gpu.phase = 1.7 * i;
+		gpu.time = Now();
+		gpu.temperature = 35.0f + i % 5;
+		gpu.fan_level = 30.0f;
+		gpu.custom_fan = false;
+		gpu.custom_fan_level = 0;
+		gpu.power_limit = 100 * 1000;
+		gpu.thermal_limit = 83 * 256;
+		gpu.core_offset = 0;
+		gpu.memory_offset = 0;
+	}
+}
+
+// Small deterministic noise in [-1, 1] that changes ten times a second
+static float Jitter(int index, double time)
+{
+	uint32_t hash = static_cast<uint32_t>(index) * 2654435761u ^ static_cast<uint32_t>(std::floor(time * 10.0));
+	hash ^= hash >> 15;
+	hash *= 2246822519u;
+	hash ^= hash >> 13;
+	return (hash & 0xffff) / 32767.5f - 1.0f;
+}
+
+static float Load(const SimulatedGPU &gpu, double time)
+{
+	// Slow wave between idle and busy, with a short burst every 45 seconds
+	const double wave = 0.5 + 0.5 * std::sin(6.283185307179586 * time / gpu.period + gpu.phase);
+	const double burst = std::fmod(time + 10.0 * gpu.phase, 45.0) < 4.0 ? 1.0 : 0.0;
+	const double load = std::max(wave * wave, burst) + 0.03 * Jitter(gpu.index, time);
+	return static_cast<float>(std::clamp(load, 0.0, 1.0));
+}
+
+static Sample Evaluate(SimulatedGPU &gpu)
+{
+	const double now = Now();
+	const Model &model = *gpu.model;
+
+	Sample sample;
+	sample.load = Load(gpu, now);
+
+	// Power draw follows load up to the power limit, anything above is taken off the clocks
+	const float demand = 15.0f + 95.0f * sample.load;
+	const float limit = gpu.power_limit / 1000.0f;
+	sample.power = std::min(demand, limit);
+
+	// Temperature settles where the power draw and the fans balance out
+	const double elapsed = now - gpu.time;
+	if (elapsed > 0.0) {
+		const float target = 28.0f + 0.55f * sample.power - 8.0f * (gpu.fan_level - 30.0f) / 70.0f;
+		gpu.temperature += (target - gpu.temperature) * static_cast<float>(1.0 - std::exp(-elapsed / kThermalTau));
+		gpu.time = now;
+	}
+	sample.temperature = gpu.temperature;
+
+	gpu.fan_level = gpu.custom_fan
+		? static_cast<float>(gpu.custom_fan_level)
+		: std::clamp(30.0f + 2.0f * (gpu.temperature - 50.0f), 30.0f, 100.0f);
+	sample.fan_level = gpu.fan_level;
+
+	if (sample.load < 0.05f) {
+		sample.core_clock = 139.0f;
+		sample.memory_clock = 405.0f;
+	} else {
+		sample.core_clock = model.base_clock + (model.boost_clock - model.base_clock) * std::min(1.0f, 1.5f * sample.load);
+		sample.memory_clock = model.memory_clock + gpu.memory_offset / 1000.0f;
+	}
+	sample.core_clock += gpu.core_offset / 1000.0f;
+
+	// Throttle 13 MHz per degree above the thermal limit and in proportion to the power cut
+	const float over = gpu.temperature - gpu.thermal_limit / 256.0f;
+	if (over > 0.0f) {
+		sample.core_clock -= 13.0f * over;
+	}
+	sample.core_clock *= sample.power / demand;
+	sample.core_clock = std::max(sample.core_clock, 139.0f);
+
+	sample.voltage = 0.65f + 0.4f * (sample.core_clock - 139.0f) / (model.boost_clock - 139.0f);
+
+	return sample;
+}
+
+static SimulatedGPU *FindGPU(NV_PHYSICAL_GPU_HANDLE handle)
+{
+	for (auto &gpu : s_gpus) {
+		if (handle == &s_gpu_handles[gpu.index]) {
+			return &gpu;
+		}
+	}
+	return nullptr;
+}
+
+static SimulatedGPU *FindDisplay(NV_DISPLAY_HANDLE handle)
+{
+	for (auto &gpu : s_gpus) {
+		if (handle == &s_display_handles[gpu.index]) {
+			return &gpu;
+		}
+	}
+	return nullptr;
+}
+
+static void Copy(NV_SHORT_STRING destination, const char *source)
+{
+	snprintf(destination, sizeof(NV_SHORT_STRING), "%s", source);
+}
+
+static NV_STATUS NvSim_Initialize()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	Setup();
+	return kOk;
+}
+
+static NV_STATUS NvSim_Unload()
+{
+	return kOk;
+}
+
+static NV_STATUS NvSim_EnumDisplayHandle(
+	NV_S32 this_enum,
+	NV_DISPLAY_HANDLE *display_handle)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (this_enum < 0 || this_enum >= static_cast<NV_S32>(s_gpus.size())) {
+		return kEndEnumeration;
+	}
+	*display_handle = &s_display_handles[this_enum];
+	return kOk;
+}
+
+static NV_STATUS NvSim_EnumPhysicalGPUs(
+	NV_PHYSICAL_GPU_HANDLE *physical_gpu_handles,
+	NV_S32 *gpu_count)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	for (const auto &gpu : s_gpus) {
+		physical_gpu_handles[gpu.index] = &s_gpu_handles[gpu.index];
+	}
+	*gpu_count = static_cast<NV_S32>(s_gpus.size());
+	return kOk;
+}
+
+static NV_STATUS NvSim_GetDisplayDriverVersion(
+	NV_DISPLAY_HANDLE display_handle,
+	NV_DISPLAY_DRIVER_VERSION_V1 *display_driver_version)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const SimulatedGPU *gpu = FindDisplay(display_handle);
+	if (!gpu) {
+		return kExpectedDisplayHandle;
+	}
+	display_driver_version->driver_version = 41171;
+	Copy(display_driver_version->build_branch, "r410_00");
+	Copy(display_driver_version->adapter, gpu->model->name);
+	return kOk;
+}
+
+static NV_STATUS NvSim_GetInterfaceVersionString(
+	NV_SHORT_STRING version)
+{
+	Copy(version, "NVFC simulated driver");
+	return kOk;
+}
+
+static NV_STATUS NvSim_GetPhysicalGPUsFromDisplay(
+	NV_DISPLAY_HANDLE display_handle,
+	NV_PHYSICAL_GPU_HANDLE *gpu_handles,
+	NV_U32 *gpu_count)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const SimulatedGPU *gpu = FindDisplay(display_handle);
+	if (!gpu) {
+		return kExpectedDisplayHandle;
+	}
+	gpu_handles[0] = &s_gpu_handles[gpu->index];
+	*gpu_count = 1;
+	return kOk;
+}
+
+static NV_STATUS NvSim_GetMemoryInfo(
+	NV_DISPLAY_HANDLE display_handle,
+	NV_MEMORY_INFO_V2 *memory_info)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindDisplay(display_handle);
+	if (!gpu) {
+		return kExpectedDisplayHandle;
+	}
+	const Sample sample = Evaluate(*gpu);
+	const NV_U32 total = gpu->model->memory;
+	const NV_U32 used = static_cast<NV_U32>(total * (0.1f + 0.6f * sample.load));
+	memory_info->values[0] = total;
+	memory_info->values[1] = total;
+	memory_info->values[2] = 0;
+	memory_info->values[3] = total;
+	memory_info->values[4] = total - used;
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetFullName(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_SHORT_STRING name)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	Copy(name, gpu->model->name);
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetPStates20(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_PSTATES20_V2 *pstates)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+
+	// P0 runs a dynamic core clock and a fixed memory clock, both offsets are editable
+	pstates->state_count = 1;
+	pstates->clock_count = 2;
+	pstates->voltage_count = 1;
+
+	auto &state = pstates->states[0];
+	state.state_num = 0;
+
+	auto &core = state.clocks[0];
+	core.domain = static_cast<NV_U32>(NV_CLOCK_SYSTEM::GPU);
+	core.type = 1;
+	core.frequency_delta.value = gpu->core_offset;
+	core.frequency_delta.value_min = -200000;
+	core.frequency_delta.value_max = 200000;
+	core.min_or_single_frequency = static_cast<NV_U32>(gpu->model->base_clock * 1000.0f);
+	core.max_frequency = static_cast<NV_U32>(gpu->model->boost_clock * 1000.0f);
+	core.voltage_domain = 0;
+	core.min_voltage = 650000;
+	core.max_voltage = 1050000;
+
+	auto &memory = state.clocks[1];
+	memory.domain = static_cast<NV_U32>(NV_CLOCK_SYSTEM::MEMORY);
+	memory.type = 0;
+	memory.frequency_delta.value = gpu->memory_offset;
+	memory.frequency_delta.value_min = -500000;
+	memory.frequency_delta.value_max = 1000000;
+	memory.min_or_single_frequency = static_cast<NV_U32>(gpu->model->memory_clock * 1000.0f);
+
+	state.base_voltages[0].domain = 0;
+	state.base_voltages[0].voltage = 800000;
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_SetPStates20(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_PSTATES20_V2 *pstates)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+
+	for (NV_U32 i = 0; i < pstates->state_count; i++) {
+		const auto &state = pstates->states[i];
+		if (state.state_num != 0) {
+			continue;
+		}
+		for (NV_U32 j = 0; j < pstates->clock_count; j++) {
+			const auto &clock = state.clocks[j];
+			if (clock.domain == static_cast<NV_U32>(NV_CLOCK_SYSTEM::GPU)) {
+				gpu->core_offset = std::clamp(clock.frequency_delta.value, -200000, 200000);
+			} else if (clock.domain == static_cast<NV_U32>(NV_CLOCK_SYSTEM::MEMORY)) {
+				gpu->memory_offset = std::clamp(clock.frequency_delta.value, -500000, 1000000);
+			}
+		}
+	}
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetAllClockFrequencies(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_CLOCK_FREQUENCIES_V2 *frequencies)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+
+	float core = 0.0f;
+	float memory = 0.0f;
+	switch (static_cast<NV_CLOCK_FREQUENCY_TYPE>(frequencies->clock_type)) {
+	case NV_CLOCK_FREQUENCY_TYPE::CURRENT: {
+		const Sample sample = Evaluate(*gpu);
+		core = sample.core_clock;
+		memory = sample.memory_clock;
+		break;
+	}
+	case NV_CLOCK_FREQUENCY_TYPE::BASE:
+		core = gpu->model->base_clock;
+		memory = gpu->model->memory_clock;
+		break;
+	case NV_CLOCK_FREQUENCY_TYPE::BOOST:
+		core = gpu->model->boost_clock;
+		memory = gpu->model->memory_clock;
+		break;
+	default:
+		return kInvalidArgument;
+	}
+
+	// Frequencies are in kHz, there is no separate shader clock on these boards
+	auto &entries = frequencies->entries;
+	entries[static_cast<size_t>(NV_CLOCK_SYSTEM::GPU)] = { 1, static_cast<NV_U32>(core * 1000.0f) };
+	entries[static_cast<size_t>(NV_CLOCK_SYSTEM::MEMORY)] = { 1, static_cast<NV_U32>(memory * 1000.0f) };
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetDynamicPStates(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_DYNAMIC_PSTATES_V1 *dynamic_pstates)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+
+	const Sample sample = Evaluate(*gpu);
+	auto set = [&](NV_DYNAMIC_PSTATES_SYSTEM system, float value) {
+		dynamic_pstates->pstates[static_cast<size_t>(system)] = { 1, static_cast<NV_U32>(value) };
+	};
+	set(NV_DYNAMIC_PSTATES_SYSTEM::GPU, 100.0f * sample.load);
+	set(NV_DYNAMIC_PSTATES_SYSTEM::FB, 60.0f * sample.load);
+	set(NV_DYNAMIC_PSTATES_SYSTEM::VID, 0.0f);
+	set(NV_DYNAMIC_PSTATES_SYSTEM::BUS, 8.0f * sample.load);
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetPowerPoliciesInfo(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_POLICIES_INFO_V1 *policies_info)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (!FindGPU(physical_gpu_handle)) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	policies_info->entries[0].pstate = 0;
+	policies_info->entries[0].min_power = 50 * 1000;
+	policies_info->entries[0].default_power = 100 * 1000;
+	policies_info->entries[0].max_power = 120 * 1000;
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetPowerPoliciesStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_POLICIES_STATUS_V1 *policies_status)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	policies_status->count = 1;
+	policies_status->entries[0].pstate = 0;
+	policies_status->entries[0].power = gpu->power_limit;
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_SetPowerPoliciesStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_POLICIES_STATUS_V1 *policies_status)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	for (NV_U32 i = 0; i < policies_status->count && i < 4; i++) {
+		if (policies_status->entries[i].pstate == 0) {
+			gpu->power_limit = std::clamp(policies_status->entries[i].power, 50u * 1000u, 120u * 1000u);
+		}
+	}
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_ClientPowerTopologyGetStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_POWER_TOPOLOGY_STATUS_V1 *topology_status)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	const Sample sample = Evaluate(*gpu);
+	topology_status->count = 2;
+	topology_status->entries[0].domain = 0;
+	topology_status->entries[0].power = static_cast<NV_U32>(sample.power * 1000.0f);
+	topology_status->entries[1].domain = 1;
+	topology_status->entries[1].power = static_cast<NV_U32>(sample.power * 1100.0f);
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetVoltageDomainStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_VOLTAGE_DOMAINS_STATUS_V1 *voltage_domains_status)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	const Sample sample = Evaluate(*gpu);
+	voltage_domains_status->count = 1;
+	voltage_domains_status->entries[0].voltage_domain = 0;
+	voltage_domains_status->entries[0].current_voltage = static_cast<NV_U32>(sample.voltage * 1'000'000.0f);
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetThermalSettings(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_THERMAL_TARGET sensor_index,
+	NV_GPU_THERMAL_SETTINGS_V2 *thermal_settings)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+
+	const Sample sample = Evaluate(*gpu);
+	auto add = [&](NV_THERMAL_TARGET target, float temperature) {
+		if (sensor_index != NV_THERMAL_TARGET::ALL && sensor_index != target) {
+			return;
+		}
+		auto &sensor = thermal_settings->sensor[thermal_settings->count++];
+		sensor.controller = NV_THERMAL_CONTROLLER::GPU_INTERNAL;
+		sensor.default_min = 0;
+		sensor.default_max = 127;
+		sensor.current_temperature = static_cast<NV_S32>(temperature);
+		sensor.target = target;
+	};
+	add(NV_THERMAL_TARGET::GPU, sample.temperature);
+	add(NV_THERMAL_TARGET::MEMORY, sample.temperature + 4.0f);
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetSerialNumber(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_SHORT_STRING serial_number)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	// Serials are binary, the bytes up to the first zero byte make up the number
+	const char serial[] = { 0x03, 0x24, 0x17, 0x05, static_cast<char>(0x10 + gpu->index), 0 };
+	memcpy(serial_number, serial, sizeof serial);
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetThermalPoliciesInfo(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_THERMAL_POLICIES_INFO_V2 *thermal_info)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	if (!FindGPU(physical_gpu_handle)) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	thermal_info->entries[0].controller = static_cast<NV_U32>(NV_THERMAL_CONTROLLER::GPU_INTERNAL);
+	thermal_info->entries[0].min = 65 * 256;
+	thermal_info->entries[0].default_ = 83 * 256;
+	thermal_info->entries[0].max = 90 * 256;
+	thermal_info->entries[0].default_flags = 1;
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetThermalPoliciesStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_THERMAL_POLICIES_STATUS_V2 *thermal_status)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	thermal_status->count = 1;
+	thermal_status->entries[0].controller = static_cast<NV_U32>(NV_THERMAL_CONTROLLER::GPU_INTERNAL);
+	thermal_status->entries[0].value = static_cast<NV_U32>(gpu->thermal_limit);
+	thermal_status->entries[0].flags = 1;
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_SetThermalPoliciesStatus(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_GPU_THERMAL_POLICIES_STATUS_V2 *thermal_status)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	for (NV_U32 i = 0; i < thermal_status->count && i < 4; i++) {
+		if (thermal_status->entries[i].controller == static_cast<NV_U32>(NV_THERMAL_CONTROLLER::GPU_INTERNAL)) {
+			gpu->thermal_limit = std::clamp(static_cast<NV_S32>(thermal_status->entries[i].value), 65 * 256, 90 * 256);
+		}
+	}
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetCoolerSettings(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_S32 cooler_index,
+	NV_GPU_COOLER_SETTINGS_V2 *cooler_settings)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	if (cooler_index != 0) {
+		return kInvalidArgument;
+	}
+
+	const Sample sample = Evaluate(*gpu);
+	cooler_settings->count = 1;
+	auto &cooler = cooler_settings->coolers[0];
+	cooler.type = 1;
+	cooler.controller = 2;
+	cooler.default_min = 30;
+	cooler.default_max = 100;
+	cooler.current_min = 30;
+	cooler.current_max = 100;
+	cooler.current_level = static_cast<NV_S32>(sample.fan_level);
+	cooler.default_policy = 0x20;
+	cooler.current_policy = gpu->custom_fan ? 0x01 : 0x20;
+	cooler.target = 1;
+	cooler.control_type = 1;
+	cooler.active = 1;
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_SetCoolerLevels(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_S32 cooler_index,
+	NV_GPU_COOLER_LEVELS_V1 *cooler_levels)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	if (cooler_index != 0) {
+		return kInvalidArgument;
+	}
+
+	const auto &level = cooler_levels->levels[cooler_index];
+	gpu->custom_fan = level.policy == 0x01;
+	gpu->custom_fan_level = std::clamp(level.level, 30, 100);
+	return kOk;
+}
+
+static NV_STATUS NvSim_GPU_GetPCIIdentifiers(
+	NV_PHYSICAL_GPU_HANDLE physical_gpu_handle,
+	NV_U32 *device_id,
+	NV_U32 *sub_system_id,
+	NV_U32 *revision_id,
+	NV_U32 *ext_device_id)
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+	const SimulatedGPU *gpu = FindGPU(physical_gpu_handle);
+	if (!gpu) {
+		return kExpectedPhysicalGPUHandle;
+	}
+	*device_id = (gpu->model->device_id << 16) | 0x10DE;
+	*sub_system_id = ((0x3600 + gpu->index) << 16) | 0x3842;
+	*revision_id = 0xA1;
+	*ext_device_id = gpu->model->device_id;
+	return kOk;
+}
+
+template<typename F>
+static void *Interface(F *function)
+{
+	return reinterpret_cast<void *>(function);
+}
+
+void *NvSimQueryInterface(NV_U32 id)
+{
+	switch (id) {
+	case 0x0150E828: return Interface(NvSim_Initialize);
+	case 0xD22BDD7E: return Interface(NvSim_Unload);
+	case 0x9ABDD40D: return Interface(NvSim_EnumDisplayHandle);
+	case 0xE5AC921F: return Interface(NvSim_EnumPhysicalGPUs);
+	case 0xF951A4D1: return Interface(NvSim_GetDisplayDriverVersion);
+	case 0x01053FA5: return Interface(NvSim_GetInterfaceVersionString);
+	case 0x34EF9506: return Interface(NvSim_GetPhysicalGPUsFromDisplay);
+	case 0x774AA982: return Interface(NvSim_GetMemoryInfo);
+
+	case 0x0CEEE8E9F: return Interface(NvSim_GPU_GetFullName);
+	case 0x6FF81213: return Interface(NvSim_GPU_GetPStates20);
+	case 0x0F4DAE6B: return Interface(NvSim_GPU_SetPStates20);
+	case 0xDCB616C3: return Interface(NvSim_GPU_GetAllClockFrequencies);
+	case 0x60DED2ED: return Interface(NvSim_GPU_GetDynamicPStates);
+	case 0x34206D86: return Interface(NvSim_GPU_GetPowerPoliciesInfo);
+	case 0x70916171: return Interface(NvSim_GPU_GetPowerPoliciesStatus);
+	case 0x0EDCF624E: return Interface(NvSim_GPU_ClientPowerTopologyGetStatus);
+	case 0x0C16C7E2C: return Interface(NvSim_GPU_GetVoltageDomainStatus);
+	case 0x0E3640A56: return Interface(NvSim_GPU_GetThermalSettings);
+	case 0x014B83A5F: return Interface(NvSim_GPU_GetSerialNumber);
+	case 0x0AD95F5ED: return Interface(NvSim_GPU_SetPowerPoliciesStatus);
+	case 0x00D258BB5: return Interface(NvSim_GPU_GetThermalPoliciesInfo);
+	case 0x0E9C425A1: return Interface(NvSim_GPU_GetThermalPoliciesStatus);
+	case 0x034C0B13D: return Interface(NvSim_GPU_SetThermalPoliciesStatus);
+	case 0xDA141340: return Interface(NvSim_GPU_GetCoolerSettings);
+	case 0x891FA0AE: return Interface(NvSim_GPU_SetCoolerLevels);
+	case 0x2DDFB66E: return Interface(NvSim_GPU_GetPCIIdentifiers);
+	}
+	return nullptr;
+}
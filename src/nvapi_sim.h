@@ -0,0 +1,22 @@
+#ifndef NVAPI_SIM_H
+#define NVAPI_SIM_H
+
+#include "nvapi.h"
+
+// Builds without nvapi.dll to load use the simulated driver, define NVFC_SIMULATE
+// to use it on Windows as well
+#if !defined(_WIN32) && !defined(NVFC_SIMULATE)
+#define NVFC_SIMULATE
+#endif
+
+// Simulated stand in for nvapi_QueryInterface
+//
+// Serves every interface NVFC queries from a set of simulated GPUs whose load
+// follows a slow wave with bursts, temperature lags behind load, the fans
+// follow temperature and clocks drop when the GPU is idle or too hot. Writes
+// to power limits, thermal limits and coolers are applied to the simulation.
+// The number of GPUs is taken from the NVFC_SIM_GPUS environment variable and
+// defaults to four.
+void *NvSimQueryInterface(NV_U32 id);
+
+#endif
@@ -0,0 +1,245 @@
+#include <string.h>
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+#include "nvfc.h"
+#include "gpu.h"
+
+static_assert(NVFC_METRIC_COUNT == static_cast<int>(Metric::LAST), "nvfc_metric must mirror Metric");
+static_assert(NVFC_METRIC_FAN_LEVEL == static_cast<int>(Metric::FAN_LEVEL), "nvfc_metric must mirror Metric");
+static_assert(sizeof(nvfc_sample::values) == sizeof(Snapshot::values), "nvfc_sample must mirror Snapshot");
+
+// Everything a query reads is prepared by nvfc_init or nvfc_gpu_update, so the
+// queries never touch the std::optional and std::string interface of GPU
+struct nvfc_gpu {
+	GPU *gpu;
+	nvfc_gpu_info info;
+	Snapshot snapshot;
+	nvfc_limit power_limit;
+	nvfc_limit thermal_limit;
+};
+
+static struct {
+	bool initialized;
+	NV_SHORT_STRING version;
+	std::vector<nvfc_gpu> gpus;
+} g_nvfc;
+
+static void CopyString(char *destination, size_t size, const std::string &source)
+{
+	const size_t length = source.size() < size - 1 ? source.size() : size - 1;
+	memcpy(destination, source.data(), length);
+	destination[length] = '\0';
+}
+
+static nvfc_limit Limit(const std::optional<GPU::OverclockSetting> &setting)
+{
+	if (!setting) {
+		return { 0.0f, 0.0f, 0.0f, 0 };
+	}
+	return { setting->min_value, setting->current_value, setting->max_value, setting->editable ? 1 : 0 };
+}
+
+nvfc_status nvfc_init(void)
+{
+	if (g_nvfc.initialized) {
+		nvfc_shutdown();
+	}
+
+	if (NvAPI_Initialize() != 0) {
+		return NVFC_ERROR_DRIVER;
+	}
+
+	if (NvAPI_GetInterfaceVersionString(g_nvfc.version) != 0) {
+		g_nvfc.version[0] = '\0';
+	}
+
+	NV_PHYSICAL_GPU_HANDLE gpu_handles[64];
+	NV_S32 gpu_count = 0;
+	if (NvAPI_EnumPhysicalGPUs(gpu_handles, &gpu_count) != 0) {
+		NvAPI_Unload();
+		return NVFC_ERROR_DRIVER;
+	}
+
+	// Only GPUs driving a display have a display handle to read them through
+	std::unordered_map<NV_PHYSICAL_GPU_HANDLE, NV_DISPLAY_HANDLE> display_handles;
+	for (NV_S32 i = 0; i < gpu_count; i++) {
+		NV_DISPLAY_HANDLE display_handle;
+		if (NvAPI_EnumDisplayHandle(i, &display_handle) != 0) {
+			break;
+		}
+
+		NV_PHYSICAL_GPU_HANDLE handles_from_display[64];
+		NV_U32 count_from_display = 0;
+		if (NvAPI_GetPhysicalGPUsFromDisplay(display_handle, handles_from_display, &count_from_display) == 0) {
+			for (NV_U32 handle = 0; handle < count_from_display; handle++) {
+				display_handles.try_emplace(handles_from_display[handle], display_handle);
+			}
+		}
+	}
+
+	for (NV_S32 i = 0; i < gpu_count; i++) {
+		auto search = display_handles.find(gpu_handles[i]);
+		if (search == display_handles.end()) {
+			continue;
+		}
+
+		nvfc_gpu gpu = {};
+		gpu.gpu = new GPU(i, gpu_handles[i], search->second);
+		CopyString(gpu.info.name, sizeof gpu.info.name, gpu.gpu->GetName());
+		CopyString(gpu.info.serial_number, sizeof gpu.info.serial_number, gpu.gpu->GetSerialNumber());
+		const auto &pci_identifiers = gpu.gpu->GetPCIIdentifiers();
+		for (std::size_t j = 0; j < pci_identifiers.size(); j++) {
+			gpu.info.pci_identifiers[j] = pci_identifiers[j];
+		}
+		g_nvfc.gpus.push_back(gpu);
+	}
+
+	g_nvfc.initialized = true;
+	return NVFC_OK;
+}
+
+void nvfc_shutdown(void)
+{
+	if (!g_nvfc.initialized) {
+		return;
+	}
+
+	for (auto &gpu : g_nvfc.gpus) {
+		delete gpu.gpu;
+	}
+	g_nvfc.gpus.clear();
+	g_nvfc.version[0] = '\0';
+	g_nvfc.initialized = false;
+	NvAPI_Unload();
+}
+
+const char *nvfc_get_interface_version(void)
+{
+	return g_nvfc.version;
+}
+
+int nvfc_get_gpu_count(void)
+{
+	return static_cast<int>(g_nvfc.gpus.size());
+}
+
+nvfc_gpu *nvfc_get_gpu(int index)
+{
+	if (index < 0 || index >= nvfc_get_gpu_count()) {
+		return nullptr;
+	}
+	return &g_nvfc.gpus[index];
+}
+
+nvfc_status nvfc_gpu_get_info(const nvfc_gpu *gpu, nvfc_gpu_info *info)
+{
+	if (!gpu || !info) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	*info = gpu->info;
+	return NVFC_OK;
+}
+
+nvfc_status nvfc_gpu_subscribe(nvfc_gpu *gpu, uint64_t metrics, uint32_t *subscription)
+{
+	if (!gpu || !subscription || (metrics & ~ALL_METRICS)) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	*subscription = gpu->gpu->Subscribe(metrics);
+	return NVFC_OK;
+}
+
+nvfc_status nvfc_gpu_unsubscribe(nvfc_gpu *gpu, uint32_t subscription)
+{
+	if (!gpu) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	gpu->gpu->Unsubscribe(subscription);
+	return NVFC_OK;
+}
+
+nvfc_status nvfc_gpu_update(nvfc_gpu *gpu)
+{
+	if (!gpu) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+
+	const bool updated = gpu->gpu->Update();
+	gpu->gpu->GetSnapshot(gpu->snapshot);
+	gpu->power_limit = Limit(gpu->gpu->GetPowerLimit());
+	gpu->thermal_limit = Limit(gpu->gpu->GetThermalLimit());
+	return updated ? NVFC_OK : NVFC_ERROR_DRIVER;
+}
+
+nvfc_status nvfc_gpu_get_sample(const nvfc_gpu *gpu, nvfc_sample *sample)
+{
+	if (!gpu || !sample) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	sample->sequence = gpu->snapshot.sequence;
+	sample->time = gpu->snapshot.time;
+	sample->present = gpu->snapshot.present;
+	memcpy(sample->values, gpu->snapshot.values, sizeof sample->values);
+	return NVFC_OK;
+}
+
+nvfc_status nvfc_gpu_get_metric(const nvfc_gpu *gpu, nvfc_metric metric, float *value)
+{
+	if (!gpu || !value || metric < 0 || metric >= NVFC_METRIC_COUNT) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	if (!gpu->snapshot.Has(static_cast<Metric>(metric))) {
+		return NVFC_ERROR_UNAVAILABLE;
+	}
+	*value = gpu->snapshot.Get(static_cast<Metric>(metric));
+	return NVFC_OK;
+}
+
+nvfc_status nvfc_gpu_get_power_limit(const nvfc_gpu *gpu, nvfc_limit *limit)
+{
+	if (!gpu || !limit) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	if (!gpu->snapshot.Has(Metric::POWER_LIMIT)) {
+		return NVFC_ERROR_UNAVAILABLE;
+	}
+	*limit = gpu->power_limit;
+	return NVFC_OK;
+}
+
+nvfc_status nvfc_gpu_get_thermal_limit(const nvfc_gpu *gpu, nvfc_limit *limit)
+{
+	if (!gpu || !limit) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	if (!gpu->snapshot.Has(Metric::THERMAL_LIMIT)) {
+		return NVFC_ERROR_UNAVAILABLE;
+	}
+	*limit = gpu->thermal_limit;
+	return NVFC_OK;
+}
+
+nvfc_status nvfc_gpu_set_fan_level(nvfc_gpu *gpu, uint32_t percent)
+{
+	if (!gpu || percent > 100) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	return gpu->gpu->SetCustomFanSpeed(percent) ? NVFC_OK : NVFC_ERROR_DRIVER;
+}
+
+nvfc_status nvfc_gpu_set_default_fan(nvfc_gpu *gpu)
+{
+	if (!gpu) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	return gpu->gpu->SetDefaultFanSpeed() ? NVFC_OK : NVFC_ERROR_DRIVER;
+}
+
+nvfc_status nvfc_gpu_set_power_limit(nvfc_gpu *gpu, float percent)
+{
+	if (!gpu) {
+		return NVFC_ERROR_INVALID_ARGUMENT;
+	}
+	return gpu->gpu->SetPowerLimit(percent) ? NVFC_OK : NVFC_ERROR_DRIVER;
+}
@@ -0,0 +1,145 @@
+#ifndef NVFC_H
+#define NVFC_H
+#include <stdint.h>
+
+/*
+ * C interface to NVFC for embedding it in games and engines
+ *
+ * Every GPU is an opaque handle owned by the library, results are written to
+ * structures owned by the caller. nvfc_init and nvfc_gpu_update are the only
+ * functions which call into the driver or allocate. Every other function is
+ * O(1), never allocates and never calls into the driver: nvfc_gpu_update takes
+ * one sample of the GPU and the queries read that sample. A game can therefore
+ * call the queries every frame and move nvfc_gpu_update to wherever driver
+ * calls fit its frame budget.
+ *
+ * The library is not thread safe, a GPU must not be updated while another
+ * thread queries it.
+ */
+
+#if defined(_WIN32) && !defined(NVFC_STATIC)
+#  ifdef NVFC_EXPORTS
+#    define NVFC_API __declspec(dllexport)
+#  else
+#    define NVFC_API __declspec(dllimport)
+#  endif
+#elif defined(__GNUC__)
+#  define NVFC_API __attribute__((visibility("default")))
+#else
+#  define NVFC_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum nvfc_status {
+	NVFC_OK = 0,
+	NVFC_ERROR_INVALID_ARGUMENT,
+	NVFC_ERROR_NOT_INITIALIZED,
+	NVFC_ERROR_DRIVER,                // the driver rejected a call
+	NVFC_ERROR_UNAVAILABLE            // the GPU does not report the value
+} nvfc_status;
+
+/* Same values as Metric in metric.h */
+typedef enum nvfc_metric {
+	NVFC_METRIC_TEMPERATURE_GPU,
+	NVFC_METRIC_TEMPERATURE_MEMORY,
+	NVFC_METRIC_TEMPERATURE_POWER_SUPPLY,
+	NVFC_METRIC_TEMPERATURE_BOARD,
+	NVFC_METRIC_VOLTAGE,
+	NVFC_METRIC_CURRENT_CLOCK_CORE,
+	NVFC_METRIC_CURRENT_CLOCK_MEMORY,
+	NVFC_METRIC_CURRENT_CLOCK_SHADER,
+	NVFC_METRIC_BASE_CLOCK_CORE,
+	NVFC_METRIC_BASE_CLOCK_MEMORY,
+	NVFC_METRIC_BASE_CLOCK_SHADER,
+	NVFC_METRIC_BOOST_CLOCK_CORE,
+	NVFC_METRIC_BOOST_CLOCK_MEMORY,
+	NVFC_METRIC_BOOST_CLOCK_SHADER,
+	NVFC_METRIC_USAGE_GPU,
+	NVFC_METRIC_USAGE_FB,
+	NVFC_METRIC_USAGE_VID,
+	NVFC_METRIC_USAGE_BUS,
+	NVFC_METRIC_MEMORY_TOTAL,
+	NVFC_METRIC_MEMORY_FREE,
+	NVFC_METRIC_MEMORY_USED,
+	NVFC_METRIC_POWER_USAGE,
+	NVFC_METRIC_POWER_LIMIT,
+	NVFC_METRIC_THERMAL_LIMIT,
+	NVFC_METRIC_FAN_LEVEL,
+	NVFC_METRIC_COUNT
+} nvfc_metric;
+
+#define NVFC_METRIC_BIT(metric) ((uint64_t)1 << (metric))
+
+typedef struct nvfc_gpu nvfc_gpu;
+
+typedef struct nvfc_gpu_info {
+	char name[64];
+	char serial_number[64];
+	uint32_t pci_identifiers[4];      // device, subsystem, revision, extended device
+} nvfc_gpu_info;
+
+/* Every metric of a GPU at one point in time */
+typedef struct nvfc_sample {
+	uint64_t sequence;                // incremented by every nvfc_gpu_update
+	double time;                      // seconds on a monotonic clock
+	uint64_t present;                 // NVFC_METRIC_BIT of every metric with a valid value
+	float values[NVFC_METRIC_COUNT];
+} nvfc_sample;
+
+typedef struct nvfc_limit {
+	float min_value;
+	float current_value;
+	float max_value;
+	int editable;
+} nvfc_limit;
+
+/* Loads the driver and finds every GPU driving a display, calling it again
+ * after nvfc_shutdown starts over. Not O(1) */
+NVFC_API nvfc_status nvfc_init(void);
+NVFC_API void nvfc_shutdown(void);
+
+/* Version string of the driver interface, empty before nvfc_init. O(1) */
+NVFC_API const char *nvfc_get_interface_version(void);
+
+/* O(1) */
+NVFC_API int nvfc_get_gpu_count(void);
+NVFC_API nvfc_gpu *nvfc_get_gpu(int index);
+
+/* Name, serial number and PCI identifiers, read once by nvfc_init. O(1) */
+NVFC_API nvfc_status nvfc_gpu_get_info(const nvfc_gpu *gpu, nvfc_gpu_info *info);
+
+/* Limits nvfc_gpu_update to the driver calls needed for [metrics], a mask of
+ * NVFC_METRIC_BIT, until the subscription is removed. Without subscriptions
+ * every metric is read. Not O(1), meant to be called on setup */
+NVFC_API nvfc_status nvfc_gpu_subscribe(nvfc_gpu *gpu, uint64_t metrics, uint32_t *subscription);
+NVFC_API nvfc_status nvfc_gpu_unsubscribe(nvfc_gpu *gpu, uint32_t subscription);
+
+/* Reads the GPU from the driver and takes a new sample. Not O(1), allocates
+ * and issues up to a dozen driver calls */
+NVFC_API nvfc_status nvfc_gpu_update(nvfc_gpu *gpu);
+
+/* Copies the last sample. O(1) */
+NVFC_API nvfc_status nvfc_gpu_get_sample(const nvfc_gpu *gpu, nvfc_sample *sample);
+
+/* One metric of the last sample, NVFC_ERROR_UNAVAILABLE when the sample has no
+ * value for it. O(1) */
+NVFC_API nvfc_status nvfc_gpu_get_metric(const nvfc_gpu *gpu, nvfc_metric metric, float *value);
+
+/* Limits as of the last sample, in percent of the default power limit and in
+ * degrees Celsius. O(1) */
+NVFC_API nvfc_status nvfc_gpu_get_power_limit(const nvfc_gpu *gpu, nvfc_limit *limit);
+NVFC_API nvfc_status nvfc_gpu_get_thermal_limit(const nvfc_gpu *gpu, nvfc_limit *limit);
+
+/* Writes to the driver. Not O(1) */
+NVFC_API nvfc_status nvfc_gpu_set_fan_level(nvfc_gpu *gpu, uint32_t percent);
+NVFC_API nvfc_status nvfc_gpu_set_default_fan(nvfc_gpu *gpu);
+NVFC_API nvfc_status nvfc_gpu_set_power_limit(nvfc_gpu *gpu, float percent);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
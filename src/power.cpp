@@ -0,0 +1,206 @@
+#include <algorithm> // std::clamp, std::min, std::max
+#include <cmath>     // std::fabs
+
+#include "power.h"
+#include "gpu.h"
+#include "log.h"
+
+// A device drawing at least this fraction of its limit is considered power bound
+static constexpr float kSaturation = 0.95f;
+
+// Devices that are not power bound are given this much room above their draw, this
+// has to stay above 1 / kSaturation or an idle device would look power bound next tick
+static constexpr float kHeadroom = 1.10f;
+
+// Fraction of the distance to the target limit that is moved every tick
+static constexpr float kSmoothing = 0.5f;
+
+// Once every limit is closer than this many watts to its target they all snap to it
+static constexpr float kSnap = 1.0f;
+
+// Water-fill [amount] over [count] slots proportionally to [weights], without
+// handing any slot more than its [caps], returns how much was handed out
+static float Distribute(float amount, const float *caps, const float *weights, float *out, std::size_t count)
+{
+	std::vector<float> given(count, 0.0f);
+	std::vector<bool> full(count, false);
+	float remaining = amount;
+
+	while (remaining > 0.0f) {
+		float weight = 0.0f;
+		for (std::size_t i = 0; i < count; i++) {
+			if (!full[i]) {
+				weight += weights[i];
+			}
+		}
+		if (weight <= 0.0f) {
+			break;
+		}
+
+		// When a slot would overflow its cap it is filled and the round restarts
+		// with what is left, otherwise every open slot takes its share and we're done
+		bool capped = false;
+		for (std::size_t i = 0; i < count; i++) {
+			if (!full[i] && given[i] + remaining * weights[i] / weight >= caps[i]) {
+				remaining -= caps[i] - given[i];
+				given[i] = caps[i];
+				full[i] = true;
+				capped = true;
+			}
+		}
+
+		if (!capped) {
+			for (std::size_t i = 0; i < count; i++) {
+				if (!full[i]) {
+					given[i] += remaining * weights[i] / weight;
+				}
+			}
+			remaining = 0.0f;
+		}
+	}
+
+	for (std::size_t i = 0; i < count; i++) {
+		out[i] += given[i];
+	}
+
+	return amount - std::max(remaining, 0.0f);
+}
+
+PowerScheduler::PowerScheduler(float budget)
+	: m_budget { budget }
+{
+}
+
+bool PowerScheduler::Schedule(const Device *devices, std::size_t count, float *limits) const
+{
+	float floor = 0.0f;
+	for (std::size_t i = 0; i < count; i++) {
+		floor += devices[i].min_limit;
+	}
+
+	if (floor > m_budget) {
+		for (std::size_t i = 0; i < count; i++) {
+			limits[i] = devices[i].min_limit;
+		}
+		return false;
+	}
+
+	std::vector<float> targets(count);
+	std::vector<float> caps(count);
+	std::vector<float> weights(count);
+	for (std::size_t i = 0; i < count; i++) {
+		const auto &device = devices[i];
+		const bool saturated = device.power >= device.limit * kSaturation;
+
+		// Power bound devices ask for everything they can get, the weights decide
+		// how contended headroom is split between them
+		const float demand = saturated
+			? device.max_limit
+			: std::clamp(device.power * kHeadroom, device.min_limit, device.max_limit);
+
+		targets[i] = device.min_limit;
+		caps[i] = demand - device.min_limit;
+		weights[i] = std::max(device.usage, 1.0f);
+	}
+
+	// Satisfy demand first, then spread whatever is left so every device has room to spike
+	float remaining = m_budget - floor;
+	remaining -= Distribute(remaining, caps.data(), weights.data(), targets.data(), count);
+	for (std::size_t i = 0; i < count; i++) {
+		caps[i] = devices[i].max_limit - targets[i];
+	}
+	Distribute(remaining, caps.data(), weights.data(), targets.data(), count);
+
+	// Moving part of the way keeps limits from oscillating. Every device moves by the same
+	// fraction, so the new limits are a blend of the applied limits and the targets and fit
+	// the budget whenever both do. Once every device is close they all snap to the targets
+	float applied = 0.0f;
+	float distance = 0.0f;
+	for (std::size_t i = 0; i < count; i++) {
+		const float limit = std::clamp(devices[i].limit, devices[i].min_limit, devices[i].max_limit);
+		applied += limit;
+		distance = std::max(distance, std::fabs(targets[i] - limit));
+	}
+
+	const float smoothing = applied > m_budget || distance < kSnap ? 1.0f : kSmoothing;
+	for (std::size_t i = 0; i < count; i++) {
+		const auto &device = devices[i];
+		const float limit = std::clamp(device.limit, device.min_limit, device.max_limit);
+		limits[i] = smoothing == 1.0f ? targets[i] : limit + (targets[i] - limit) * smoothing;
+	}
+
+	return true;
+}
+
+void PowerScheduler::Add(GPU *gpu, float rated_power)
+{
+	m_entries.push_back({ gpu, rated_power });
+}
+
+bool PowerScheduler::Tick()
+{
+	const auto count = m_entries.size();
+	m_devices.resize(count);
+	m_limits.resize(count);
+
+	std::vector<bool> controllable(count);
+	for (std::size_t i = 0; i < count; i++) {
+		const auto &entry = m_entries[i];
+		const float scale = entry.rated_power / 100.0f;
+
+		const auto limit = entry.gpu->GetPowerLimit();
+		const auto power = entry.gpu->GetPowerUsage();
+		const auto usage = entry.gpu->GetUsage();
+
+		controllable[i] = limit && power;
+		if (controllable[i]) {
+			m_devices[i] = {
+				entry.rated_power,
+				limit->min_value * scale,
+				limit->max_value * scale,
+				limit->current_value * scale,
+				*power * scale,
+				usage && usage->gpu_usage ? *usage->gpu_usage : 0.0f
+			};
+		} else {
+			// A GPU we cannot observe cannot be controlled either, reserve what it may
+			// be drawing so the rest of the host still fits the budget
+			const float reserved = limit ? limit->current_value * scale : entry.rated_power;
+			m_devices[i] = { entry.rated_power, reserved, reserved, reserved, reserved, 0.0f };
+		}
+	}
+
+	bool result = Schedule(m_devices.data(), count, m_limits.data());
+	if (!result) {
+		Log::write("power budget of %.2fW cannot cover the minimum limits of %zu GPU(s)", m_budget, count);
+	}
+
+	auto apply = [&](std::size_t i) {
+		const auto &entry = m_entries[i];
+		if (!entry.gpu->SetPowerLimit(m_limits[i] / entry.rated_power * 100.0f)) {
+			Log::write("failed to set power limit of %.2fW on '%s'", m_limits[i], entry.gpu->GetName().c_str());
+			return false;
+		}
+		return true;
+	};
+
+	// Decreases are always written and go first, so the budget also holds between the writes
+	bool decreased = true;
+	for (std::size_t i = 0; i < count; i++) {
+		if (controllable[i] && m_limits[i] < m_devices[i].limit) {
+			decreased &= apply(i);
+		}
+	}
+	result &= decreased;
+
+	// Increases rely on the headroom the decreases freed, small ones are not worth a write
+	if (decreased) {
+		for (std::size_t i = 0; i < count; i++) {
+			if (controllable[i] && m_limits[i] - m_devices[i].limit >= 0.5f) {
+				result &= apply(i);
+			}
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,67 @@
+#ifndef POWER_H
+#define POWER_H
+#include <vector> // std::vector
+
+class GPU;
+
+// Shares a fixed power budget between all GPUs in a host
+//
+// Every tick the scheduler looks at how much power each GPU draws against its
+// current limit and how busy it is. GPUs pinned against their limit are handed
+// spare headroom, GPUs drawing well below their limit give it back. All values
+// the scheduler works with are in watts, NvAPI only reports power as a
+// percentage of the default power target so each GPU is registered together
+// with its rated power.
+class PowerScheduler {
+public:
+	struct Device {
+		float rated_power; // watts at 100% of the default power target
+		float min_limit;   // lowest limit the driver accepts, in watts
+		float max_limit;   // highest limit the driver accepts, in watts
+		float limit;       // currently applied limit, in watts
+		float power;       // current power draw, in watts
+		float usage;       // GPU usage in percent
+	};
+
+	PowerScheduler(float budget);
+
+	// Computes new limits for [count] devices into [limits]
+	//
+	// The sum of the resulting limits never exceeds the budget. When the budget
+	// cannot even cover the minimum limit of every device all devices are given
+	// their minimum limit and false is returned.
+	bool Schedule(const Device *devices, std::size_t count, float *limits) const;
+
+	void Add(GPU *gpu, float rated_power);
+
+	// Samples every registered GPU, schedules and applies the new limits. Decreases are
+	// written before increases, which are held back when any decrease failed. Returns
+	// false when the budget could not be met or any write failed
+	bool Tick();
+
+	float GetBudget() const;
+	void SetBudget(float budget);
+
+private:
+	struct Entry {
+		GPU *gpu;
+		float rated_power;
+	};
+
+	float m_budget;
+	std::vector<Entry> m_entries;
+	std::vector<Device> m_devices;
+	std::vector<float> m_limits;
+};
+
+inline float PowerScheduler::GetBudget() const
+{
+	return m_budget;
+}
+
+inline void PowerScheduler::SetBudget(float budget)
+{
+	m_budget = budget;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include <algorithm> // std::max, std::find_if
+#include <chrono>    // std::chrono::duration
+#include <utility>   // std::move
+
+#include "publisher.h"
+
+Publisher::Publisher()
+	: m_next_subscription { 1 }
+{
+}
+
+NV_U32 Publisher::Subscribe(int gpu, MetricSet metrics, Callback callback)
+{
+	auto subscription = std::make_shared<Subscription>();
+	subscription->gpu = gpu;
+	subscription->metrics = metrics;
+	subscription->delivery = Delivery::LATEST;
+	subscription->callback = std::move(callback);
+	return Add(subscription);
+}
+
+NV_U32 Publisher::Subscribe(int gpu, MetricSet metrics, Delivery delivery, std::size_t capacity)
+{
+	auto subscription = std::make_shared<Subscription>();
+	subscription->gpu = gpu;
+	subscription->metrics = metrics;
+	subscription->delivery = delivery;
+	subscription->ring.resize(delivery == Delivery::LATEST ? 1 : std::max<std::size_t>(capacity, 1));
+	return Add(subscription);
+}
+
+NV_U32 Publisher::Add(const std::shared_ptr<Subscription> &subscription)
+{
+	subscription->head = 0;
+	subscription->stats = {};
+	subscription->closed = false;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	subscription->id = m_next_subscription++;
+	m_subscriptions.push_back(subscription);
+	return subscription->id;
+}
+
+void Publisher::Unsubscribe(NV_U32 subscription)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto search = std::find_if(m_subscriptions.begin(), m_subscriptions.end(), [&](const auto &entry) {
+		return entry->id == subscription;
+	});
+	if (search != m_subscriptions.end()) {
+		(*search)->closed = true;
+		(*search)->ready.notify_all();
+		m_subscriptions.erase(search);
+	}
+}
+
+void Publisher::Publish(std::size_t gpu, const Snapshot &snapshot)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto &entry : m_subscriptions) {
+		Subscription &subscription = *entry;
+		if (subscription.gpu >= 0 && static_cast<std::size_t>(subscription.gpu) != gpu) {
+			continue;
+		}
+		if (!(snapshot.present & subscription.metrics)) {
+			continue;
+		}
+
+		Stats &stats = subscription.stats;
+		stats.published++;
+
+		if (subscription.callback) {
+			subscription.callback(gpu, snapshot);
+			stats.delivered++;
+			continue;
+		}
+
+		const std::size_t capacity = subscription.ring.size();
+		if (subscription.delivery == Delivery::LATEST) {
+			if (stats.pending) {
+				stats.coalesced++;
+			}
+			subscription.ring[0] = { gpu, snapshot };
+			stats.pending = 1;
+		} else if (stats.pending == capacity) {
+			stats.dropped++;
+			continue;
+		} else {
+			subscription.ring[(subscription.head + stats.pending) % capacity] = { gpu, snapshot };
+			stats.pending++;
+		}
+		stats.peak = std::max(stats.peak, stats.pending);
+		subscription.ready.notify_one();
+	}
+}
+
+std::shared_ptr<Publisher::Subscription> Publisher::Find(NV_U32 subscription) const
+{
+	for (const auto &entry : m_subscriptions) {
+		if (entry->id == subscription) {
+			return entry;
+		}
+	}
+	return nullptr;
+}
+
+bool Publisher::Take(Subscription &subscription, std::size_t &gpu, Snapshot &snapshot)
+{
+	if (subscription.stats.pending == 0) {
+		return false;
+	}
+
+	const Entry &entry = subscription.ring[subscription.head];
+	gpu = entry.gpu;
+	snapshot = entry.snapshot;
+	subscription.head = (subscription.head + 1) % subscription.ring.size();
+	subscription.stats.pending--;
+	subscription.stats.delivered++;
+	return true;
+}
+
+bool Publisher::Receive(NV_U32 subscription, std::size_t &gpu, Snapshot &snapshot)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto found = Find(subscription);
+	return found && Take(*found, gpu, snapshot);
+}
+
+bool Publisher::Wait(NV_U32 subscription, std::size_t &gpu, Snapshot &snapshot, double timeout)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	auto found = Find(subscription);
+	if (!found || found->callback) {
+		return false;
+	}
+
+	found->ready.wait_for(lock, std::chrono::duration<double>(timeout), [&] {
+		return found->stats.pending != 0 || found->closed;
+	});
+	return Take(*found, gpu, snapshot);
+}
+
+Publisher::Stats Publisher::GetStats(NV_U32 subscription) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto found = Find(subscription);
+	return found ? found->stats : Stats {};
+}
@@ -0,0 +1,86 @@
+#ifndef PUBLISHER_H
+#define PUBLISHER_H
+#include <condition_variable> // std::condition_variable
+#include <functional>         // std::function
+#include <memory>             // std::shared_ptr
+#include <mutex>              // std::mutex
+#include <vector>             // std::vector
+
+#include "metric.h"
+
+// Pushes every new snapshot of a GPU to the consumers subscribed to it
+//
+// A consumer either registers a callback, which runs on the publishing thread,
+// or receives from a queue, which any one thread may drain or block on. Queues
+// deliver either the latest snapshot only, coalescing the ones the consumer did
+// not get to, or every snapshot up to their capacity. Storage is allocated on
+// subscription, publishing never allocates.
+class Publisher {
+public:
+	enum class Delivery {
+		LATEST,   // only the newest snapshot is kept, older undelivered ones are coalesced
+		LOSSLESS  // every snapshot is kept until [capacity] are pending, later ones are dropped
+	};
+
+	using Callback = std::function<void(std::size_t gpu, const Snapshot &snapshot)>;
+
+	// Backpressure of one subscription
+	struct Stats {
+		uint64_t published;  // snapshots offered to the subscription
+		uint64_t delivered;  // snapshots handed to the consumer
+		uint64_t coalesced;  // snapshots replaced by a newer one before delivery
+		uint64_t dropped;    // snapshots refused by a full queue
+		std::size_t pending; // snapshots waiting to be delivered
+		std::size_t peak;    // most snapshots ever waiting at once
+	};
+
+	Publisher();
+
+	// Snapshots of [gpu] holding at least one of [metrics] are delivered to the
+	// subscription, [gpu] is -1 to follow every GPU. Callbacks run with the
+	// publisher locked and must not call back into it
+	NV_U32 Subscribe(int gpu, MetricSet metrics, Callback callback);
+	NV_U32 Subscribe(int gpu, MetricSet metrics, Delivery delivery, std::size_t capacity = 64);
+	void Unsubscribe(NV_U32 subscription);
+
+	// Offers [snapshot] of [gpu] to every matching subscription
+	void Publish(std::size_t gpu, const Snapshot &snapshot);
+
+	// Takes the oldest pending snapshot of a queue, false when there is none
+	bool Receive(NV_U32 subscription, std::size_t &gpu, Snapshot &snapshot);
+
+	// Like Receive but waits up to [timeout] seconds for a snapshot to be published.
+	// Unsubscribing from another thread wakes the waiter
+	bool Wait(NV_U32 subscription, std::size_t &gpu, Snapshot &snapshot, double timeout);
+
+	Stats GetStats(NV_U32 subscription) const;
+
+private:
+	struct Entry {
+		std::size_t gpu;
+		Snapshot snapshot;
+	};
+
+	struct Subscription {
+		NV_U32 id;
+		int gpu;
+		MetricSet metrics;
+		Delivery delivery;
+		Callback callback;
+		std::vector<Entry> ring;  // one entry for Delivery::LATEST
+		std::size_t head;         // index of the oldest pending entry
+		Stats stats;
+		bool closed;
+		std::condition_variable ready;
+	};
+
+	NV_U32 Add(const std::shared_ptr<Subscription> &subscription);
+	std::shared_ptr<Subscription> Find(NV_U32 subscription) const;
+	bool Take(Subscription &subscription, std::size_t &gpu, Snapshot &snapshot);
+
+	mutable std::mutex m_mutex;
+	std::vector<std::shared_ptr<Subscription>> m_subscriptions;
+	NV_U32 m_next_subscription;
+};
+
+#endif
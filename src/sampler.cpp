@@ -0,0 +1,183 @@
+#include <algorithm> // std::min, std::max
+#include <cmath>     // std::sqrt
+
+#include "sampler.h"
+#include "gpu.h"
+#include "publisher.h"
+#include "log.h"
+
+// Weight of the newest sample in the running mean and variance
+static constexpr float kAlpha = 0.2f;
+
+// A sample this many deviations away from the running mean is a transient
+static constexpr float kJump = 3.0f;
+
+// Factor the interval may grow by per sample when backing off
+static constexpr double kBackoff = 1.25;
+
+// Deviations which count as fully active, in the unit of the metric
+static constexpr float kTemperatureScale = 1.0f; // degrees
+static constexpr float kClockScale = 15.0f;      // MHz
+static constexpr float kUsageScale = 5.0f;       // percent
+
+Sampler::Sampler(const Config &config)
+	: m_config    { config }
+	, m_publisher { nullptr }
+{
+}
+
+void Sampler::Add(GPU *gpu)
+{
+	Entry entry = {};
+	entry.gpu = gpu;
+	entry.interval = m_config.min_interval;
+	m_entries.push_back(entry);
+}
+
+void Sampler::Attach(Publisher *publisher)
+{
+	m_publisher = publisher;
+}
+
+bool Sampler::Poll(double now)
+{
+	bool updated = false;
+	for (std::size_t i = 0; i < m_entries.size(); i++) {
+		Entry &entry = m_entries[i];
+		if (entry.samples != 0 && now < entry.next) {
+			continue;
+		}
+
+		const auto driver_calls = entry.gpu->GetDriverCalls();
+		const bool result = entry.gpu->Update();
+		entry.driver_calls += entry.gpu->GetDriverCalls() - driver_calls;
+
+		if (entry.samples++ == 0) {
+			entry.first = now;
+		}
+		entry.last = now;
+
+		if (!result) {
+			entry.failures++;
+		} else {
+			entry.gpu->GetSnapshot(entry.snapshot);
+			Adapt(entry);
+			if (m_publisher) {
+				m_publisher->Publish(i, entry.snapshot);
+			}
+		}
+
+		entry.next = now + entry.interval;
+		updated = true;
+	}
+	return updated;
+}
+
+void Sampler::Adapt(Entry &entry)
+{
+	const auto &snapshot = entry.snapshot;
+
+	bool escalate = false;
+	float activity = 0.0f;
+	auto observe = [&](Signal &signal, Metric metric, float scale) {
+		if (!snapshot.Has(metric)) {
+			return;
+		}
+
+		const float value = snapshot.Get(metric);
+		if (!entry.has_signals) {
+			signal = { value, 0.0f };
+			return;
+		}
+
+		const float deviation = value - signal.mean;
+		const float spread = std::max(signal.variance, scale * scale);
+		if (deviation * deviation > kJump * kJump * spread) {
+			escalate = true;
+		}
+
+		const float increment = kAlpha * deviation;
+		signal.mean += increment;
+		signal.variance = (1.0f - kAlpha) * (signal.variance + deviation * increment);
+		activity = std::max(activity, std::sqrt(signal.variance) / scale);
+	};
+
+	observe(entry.temperature, Metric::TEMPERATURE_GPU, kTemperatureScale);
+	observe(entry.clock, Metric::CURRENT_CLOCK_CORE, kClockScale);
+	observe(entry.usage, Metric::USAGE_GPU, kUsageScale);
+	entry.has_signals = true;
+
+	for (const auto &threshold : m_config.thresholds) {
+		if (snapshot.Has(threshold.metric) && snapshot.Get(threshold.metric) >= threshold.value - threshold.margin) {
+			escalate = true;
+		}
+	}
+
+	const double min_interval = m_config.min_interval;
+	const double max_interval = m_config.max_interval;
+	const double target = escalate || activity >= 1.0f
+		? min_interval
+		: max_interval - (max_interval - min_interval) * activity;
+
+	// Speed up at once but only back off gradually, a transient is rarely a single sample
+	if (target < entry.interval) {
+		entry.interval = target;
+	} else {
+		entry.interval = std::min(target, entry.interval * kBackoff);
+	}
+}
+
+Sampler::Report Sampler::GetReport(std::size_t gpu) const
+{
+	const auto &entry = m_entries[gpu];
+
+	Report report = {};
+	report.elapsed = entry.last - entry.first;
+	report.samples = entry.samples;
+	report.failures = entry.failures;
+	report.driver_calls = entry.driver_calls;
+	if (report.elapsed > 0.0) {
+		report.effective_rate = (entry.samples - 1) / report.elapsed;
+	}
+
+	// A fixed rate sampler would have sampled at the minimum interval the whole time
+	const auto baseline = static_cast<uint64_t>(report.elapsed / m_config.min_interval) + 1;
+	if (entry.samples != 0 && baseline > entry.samples) {
+		report.driver_calls_saved = (baseline - entry.samples) * entry.driver_calls / entry.samples;
+	}
+
+	return report;
+}
+
+Sampler::Report Sampler::GetReport() const
+{
+	Report total = {};
+	for (std::size_t i = 0; i < m_entries.size(); i++) {
+		const auto report = GetReport(i);
+		total.elapsed = std::max(total.elapsed, report.elapsed);
+		total.effective_rate += report.effective_rate;
+		total.samples += report.samples;
+		total.failures += report.failures;
+		total.driver_calls += report.driver_calls;
+		total.driver_calls_saved += report.driver_calls_saved;
+	}
+	return total;
+}
+
+void Sampler::LogReport() const
+{
+	auto write = [](const char *name, const Report &report) {
+		Log::write("%s: %.2f samples/s over %.2fs, %llu failed, %llu driver calls, %llu saved",
+			name,
+			report.effective_rate,
+			report.elapsed,
+			static_cast<unsigned long long>(report.failures),
+			static_cast<unsigned long long>(report.driver_calls),
+			static_cast<unsigned long long>(report.driver_calls_saved));
+	};
+
+	for (std::size_t i = 0; i < m_entries.size(); i++) {
+		write(m_entries[i].gpu->GetName().c_str(), GetReport(i));
+	}
+	write("total", GetReport());
+}
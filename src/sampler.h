@@ -0,0 +1,96 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+#include <vector> // std::vector
+
+#include "metric.h"
+
+class GPU;
+class Publisher;
+
+// Samples GPUs at an interval adapted to how much their metrics move
+//
+// Every GPU keeps a running variance of its temperature, core clock and usage.
+// A GPU whose metrics are steady backs off towards the maximum interval, one
+// whose metrics move speeds up towards the minimum interval. A GPU approaching
+// one of the configured thresholds, or jumping far outside its running
+// variance, is sampled at the minimum interval immediately.
+class Sampler {
+public:
+	struct Threshold {
+		Metric metric;
+		float value;
+		float margin;  // sample at the minimum interval once the metric is within this of the value
+	};
+
+	struct Config {
+		double min_interval;
+		double max_interval;
+		std::vector<Threshold> thresholds;
+	};
+
+	struct Report {
+		double elapsed;         // seconds between the first and last sample
+		double effective_rate;  // samples per second
+		uint64_t samples;
+		uint64_t failures;      // samples whose update failed and left the snapshot as it was
+		uint64_t driver_calls;
+		uint64_t driver_calls_saved; // compared to sampling at the minimum interval
+	};
+
+	Sampler(const Config &config);
+
+	void Add(GPU *gpu);
+
+	// Every snapshot taken by Poll is published to [publisher] under the index of its GPU
+	void Attach(Publisher *publisher);
+
+	// Updates every GPU which is due at [now], returns true if any was updated
+	bool Poll(double now);
+
+	const Snapshot &GetSnapshot(std::size_t gpu) const;
+	double GetInterval(std::size_t gpu) const;
+
+	Report GetReport(std::size_t gpu) const;
+	Report GetReport() const;
+	void LogReport() const;
+
+private:
+	struct Signal {
+		float mean;
+		float variance;
+	};
+
+	struct Entry {
+		GPU *gpu;
+		Snapshot snapshot;
+		double interval;
+		double next;
+		double first;
+		double last;
+		uint64_t samples;
+		uint64_t failures;
+		uint64_t driver_calls;
+		bool has_signals;
+		Signal temperature;
+		Signal clock;
+		Signal usage;
+	};
+
+	void Adapt(Entry &entry);
+
+	Config m_config;
+	std::vector<Entry> m_entries;
+	Publisher *m_publisher;
+};
+
+inline const Snapshot &Sampler::GetSnapshot(std::size_t gpu) const
+{
+	return m_entries[gpu].snapshot;
+}
+
+inline double Sampler::GetInterval(std::size_t gpu) const
+{
+	return m_entries[gpu].interval;
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include "throttle.h"
+
+// Clocks within this fraction of the boost clock are not considered throttled
+static constexpr float kClockTolerance = 0.03f;
+
+// Degrees below the thermal limit at which the thermal limiter kicks in
+static constexpr float kThermalMargin = 2.0f;
+
+// Fraction of the power limit at which the power limiter kicks in
+static constexpr float kPowerMargin = 0.97f;
+
+// GPU usage below which a clock drop is caused by a lack of work
+static constexpr float kUtilizationThreshold = 90.0f;
+
+// Gaps between snapshots longer than this are not accounted, the GPU was not observed
+static constexpr double kMaximumGap = 5.0;
+
+ThrottleAnalyzer::ThrottleAnalyzer()
+{
+	Reset();
+}
+
+void ThrottleAnalyzer::Reset()
+{
+	m_reason = Reason::NONE;
+	m_has_previous = false;
+	m_previous_time = 0.0;
+	m_below_base_time = 0.0;
+	for (auto &totals : m_totals) {
+		totals = {};
+	}
+}
+
+ThrottleAnalyzer::Reason ThrottleAnalyzer::Classify(const Snapshot &snapshot) const
+{
+	const float current = snapshot.Get(Metric::CURRENT_CLOCK_CORE);
+	const float boost = snapshot.Get(Metric::BOOST_CLOCK_CORE);
+	if (current >= boost * (1.0f - kClockTolerance)) {
+		return Reason::NONE;
+	}
+
+	// Limiters are checked from the hardest to the softest, a GPU that is both hot
+	// and at its power limit is reported as thermally throttled
+	if (snapshot.Has(Metric::TEMPERATURE_GPU) && snapshot.Has(Metric::THERMAL_LIMIT)) {
+		if (snapshot.Get(Metric::TEMPERATURE_GPU) >= snapshot.Get(Metric::THERMAL_LIMIT) - kThermalMargin) {
+			return Reason::THERMAL;
+		}
+	}
+
+	if (snapshot.Has(Metric::POWER_USAGE) && snapshot.Has(Metric::POWER_LIMIT)) {
+		if (snapshot.Get(Metric::POWER_USAGE) >= snapshot.Get(Metric::POWER_LIMIT) * kPowerMargin) {
+			return Reason::POWER;
+		}
+	}
+
+	if (snapshot.Has(Metric::USAGE_GPU) && snapshot.Get(Metric::USAGE_GPU) < kUtilizationThreshold) {
+		return Reason::UTILIZATION;
+	}
+
+	return Reason::UNKNOWN;
+}
+
+ThrottleAnalyzer::Reason ThrottleAnalyzer::Add(const Snapshot &snapshot)
+{
+	const MetricSet required = MetricBit(Metric::CURRENT_CLOCK_CORE) | MetricBit(Metric::BOOST_CLOCK_CORE);
+	if ((snapshot.present & required) != required || snapshot.Get(Metric::BOOST_CLOCK_CORE) <= 0.0f) {
+		m_has_previous = false;
+		return m_reason = Reason::NONE;
+	}
+
+	m_reason = Classify(snapshot);
+
+	const double elapsed = snapshot.time - m_previous_time;
+	if (m_has_previous && elapsed > 0.0 && elapsed <= kMaximumGap) {
+		const float current = snapshot.Get(Metric::CURRENT_CLOCK_CORE);
+		const float boost = snapshot.Get(Metric::BOOST_CLOCK_CORE);
+
+		auto &totals = m_totals[static_cast<int>(m_reason)];
+		totals.time += elapsed;
+		if (m_reason != Reason::NONE) {
+			totals.lost += elapsed * (boost - current) / boost;
+		}
+
+		if (snapshot.Has(Metric::BASE_CLOCK_CORE) && current < snapshot.Get(Metric::BASE_CLOCK_CORE)) {
+			m_below_base_time += elapsed;
+		}
+	}
+
+	m_has_previous = true;
+	m_previous_time = snapshot.time;
+
+	return m_reason;
+}
+
+const char *ThrottleAnalyzer::ReasonName(Reason reason)
+{
+	switch (reason) {
+	case Reason::NONE:
+		return "none";
+	case Reason::THERMAL:
+		return "thermal";
+	case Reason::POWER:
+		return "power";
+	case Reason::UTILIZATION:
+		return "utilization";
+	case Reason::UNKNOWN:
+	case Reason::LAST:
+		break;
+	}
+	return "unknown";
+}
@@ -0,0 +1,65 @@
+#ifndef THROTTLE_H
+#define THROTTLE_H
+#include "metric.h"
+
+// Explains why the core clock of a GPU is below its boost clock
+//
+// Every snapshot is classified by correlating the current core clock against
+// the base and boost clocks, the GPU temperature against the thermal limit,
+// the power draw against the power limit and the GPU usage. The time spent in
+// every reason is accumulated together with the throughput lost to it, which
+// is expressed in seconds of running at the boost clock.
+class ThrottleAnalyzer {
+public:
+	enum class Reason {
+		NONE,        // running at or above the boost clock
+		THERMAL,     // at the thermal limit
+		POWER,       // at the power limit
+		UTILIZATION, // not enough work to keep the clocks up
+		UNKNOWN,     // below boost without any limiter we can observe
+		LAST
+	};
+
+	struct Totals {
+		double time; // seconds spent in the reason
+		double lost; // seconds of boost clock throughput lost to the reason
+	};
+
+	ThrottleAnalyzer();
+
+	// Classifies [snapshot] and accounts the time since the previous snapshot to it
+	Reason Add(const Snapshot &snapshot);
+
+	Reason GetReason() const;
+	const Totals &GetTotals(Reason reason) const;
+	double GetBelowBaseTime() const;
+	void Reset();
+
+	static const char *ReasonName(Reason reason);
+
+private:
+	Reason Classify(const Snapshot &snapshot) const;
+
+	Reason m_reason;
+	bool m_has_previous;
+	double m_previous_time;
+	double m_below_base_time;
+	Totals m_totals[static_cast<int>(Reason::LAST)];
+};
+
+inline ThrottleAnalyzer::Reason ThrottleAnalyzer::GetReason() const
+{
+	return m_reason;
+}
+
+inline const ThrottleAnalyzer::Totals &ThrottleAnalyzer::GetTotals(Reason reason) const
+{
+	return m_totals[static_cast<int>(reason)];
+}
+
+inline double ThrottleAnalyzer::GetBelowBaseTime() const
+{
+	return m_below_base_time;
+}
+
+#endif
@@ -0,0 +1,164 @@
+#include <stdio.h>
+#include <string.h>
+#include <algorithm> // std::max, std::min
+#include <cmath>     // std::ldexp, std::ceil
+
+#include "timing.h"
+
+// Sub buckets per octave, taken from the top bits of the mantissa
+static constexpr int kSubBucketBits = 2;
+static constexpr int kSubBuckets = 1 << kSubBucketBits;
+
+static int Bucket(double seconds)
+{
+	const double microseconds = seconds * 1e6;
+	if (!(microseconds >= 1.0)) {
+		return 0;
+	}
+
+	// Read the octave and sub bucket straight from the bits of the double, which
+	// is several times cheaper than std::frexp and runs for every record
+	uint64_t bits;
+	memcpy(&bits, &microseconds, sizeof bits);
+	const int octave = static_cast<int>(bits >> 52) - 1023;
+	const int sub = static_cast<int>(bits >> (52 - kSubBucketBits)) & (kSubBuckets - 1);
+	return std::min(1 + octave * kSubBuckets + sub, Histogram::BUCKETS - 1);
+}
+
+Histogram::Histogram(uint32_t window)
+	: m_current { 0 }
+	, m_window  { std::max(window, 1u) }
+	, m_last    { 0.0 }
+{
+	Reset(m_generations[0]);
+	Reset(m_generations[1]);
+}
+
+void Histogram::Reset(Generation &generation)
+{
+	generation.counts.fill(0);
+	generation.count = 0;
+	generation.sum = 0.0;
+	generation.max = 0.0;
+}
+
+void Histogram::Record(double seconds)
+{
+	Generation *generation = &m_generations[m_current];
+	if (generation->count == m_window) {
+		m_current ^= 1;
+		generation = &m_generations[m_current];
+		Reset(*generation);
+	}
+
+	generation->counts[Bucket(seconds)]++;
+	generation->count++;
+	generation->sum += seconds;
+	generation->max = std::max(generation->max, seconds);
+	m_last = seconds;
+}
+
+double Histogram::GetMean() const
+{
+	const uint64_t count = GetCount();
+	return count ? (m_generations[0].sum + m_generations[1].sum) / count : 0.0;
+}
+
+double Histogram::GetMax() const
+{
+	return std::max(m_generations[0].max, m_generations[1].max);
+}
+
+double Histogram::GetPercentile(double percentile) const
+{
+	const uint64_t count = GetCount();
+	if (count == 0) {
+		return 0.0;
+	}
+
+	// The middle of the bucket holding the record at [percentile], never above the largest record
+	const uint64_t rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(percentile / 100.0 * count)), 1);
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < BUCKETS - 1; bucket++) {
+		seen += GetBucket(bucket);
+		if (seen >= rank) {
+			return std::min((GetBucketStart(bucket) + GetBucketStart(bucket + 1)) / 2, GetMax());
+		}
+	}
+	return GetMax();
+}
+
+uint64_t Histogram::GetBucket(int bucket) const
+{
+	return uint64_t(m_generations[0].counts[bucket]) + m_generations[1].counts[bucket];
+}
+
+double Histogram::GetBucketStart(int bucket)
+{
+	if (bucket == 0) {
+		return 0.0;
+	}
+	const int octave = (bucket - 1) / kSubBuckets;
+	const int sub = (bucket - 1) % kSubBuckets;
+	return std::ldexp(1.0 + sub / double(kSubBuckets), octave) * 1e-6;
+}
+
+const char *StageName(Stage stage)
+{
+	switch (stage) {
+	case Stage::PUMP:
+		return "pump";
+	case Stage::POLL:
+		return "poll";
+	case Stage::BUILD:
+		return "build";
+	case Stage::RENDER:
+		return "render";
+	case Stage::BLIT:
+		return "blit";
+	case Stage::FRAME:
+		return "frame";
+	case Stage::SAMPLE_AGE:
+		return "sample age";
+	case Stage::INPUT_LATENCY:
+		return "input latency";
+	case Stage::LAST:
+		break;
+	}
+	return "unknown";
+}
+
+bool FrameTiming::Dump(const char *path) const
+{
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		return false;
+	}
+
+	// Every duration is in microseconds, buckets are [start, count] pairs of the non empty buckets
+	fprintf(file, "{\n  \"unit\": \"us\",\n  \"stages\": {");
+	for (uint32_t i = 0; i < static_cast<uint32_t>(Stage::LAST); i++) {
+		const Histogram &histogram = m_stages[i];
+		fprintf(file, "%s\n    \"%s\": {\n", i ? "," : "", StageName(static_cast<Stage>(i)));
+		fprintf(file, "      \"count\": %llu,\n", static_cast<unsigned long long>(histogram.GetCount()));
+		fprintf(file, "      \"last\": %.3f,\n", histogram.GetLast() * 1e6);
+		fprintf(file, "      \"mean\": %.3f,\n", histogram.GetMean() * 1e6);
+		fprintf(file, "      \"p50\": %.3f,\n", histogram.GetPercentile(50.0) * 1e6);
+		fprintf(file, "      \"p90\": %.3f,\n", histogram.GetPercentile(90.0) * 1e6);
+		fprintf(file, "      \"p99\": %.3f,\n", histogram.GetPercentile(99.0) * 1e6);
+		fprintf(file, "      \"max\": %.3f,\n", histogram.GetMax() * 1e6);
+		fprintf(file, "      \"buckets\": [");
+		bool first = true;
+		for (int bucket = 0; bucket < Histogram::BUCKETS; bucket++) {
+			const uint64_t count = histogram.GetBucket(bucket);
+			if (count) {
+				fprintf(file, "%s[%.3f, %llu]", first ? "" : ", ", Histogram::GetBucketStart(bucket) * 1e6, static_cast<unsigned long long>(count));
+				first = false;
+			}
+		}
+		fprintf(file, "]\n    }");
+	}
+	fprintf(file, "\n  }\n}\n");
+
+	return fclose(file) == 0;
+}
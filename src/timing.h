@@ -0,0 +1,100 @@
+#ifndef TIMING_H
+#define TIMING_H
+#include <stdint.h>
+#include <array> // std::array
+
+// Rolling histogram of durations
+//
+// Durations are counted in buckets a quarter of an octave wide, from one
+// microsecond up to about 16 seconds, so percentiles come out within 10% of the
+// real value with a fixed footprint and without allocating. Two generations are
+// kept and a new one is started every [window] records, dropping the oldest, so
+// the statistics cover the last one to two windows of records. Recording is a
+// handful of arithmetic on the current generation.
+class Histogram {
+public:
+	// Bucket 0 holds everything below a microsecond, the last one everything above its start
+	static constexpr int BUCKETS = 1 + 4 * 25;
+
+	Histogram(uint32_t window = 1024);
+
+	void Record(double seconds);
+
+	// Statistics over both generations, in seconds
+	uint64_t GetCount() const;
+	double GetLast() const;
+	double GetMean() const;
+	double GetMax() const;
+	double GetPercentile(double percentile) const;
+
+	// Records in [bucket] over both generations
+	uint64_t GetBucket(int bucket) const;
+
+	// Lower bound of [bucket] in seconds
+	static double GetBucketStart(int bucket);
+
+private:
+	struct Generation {
+		std::array<uint32_t, BUCKETS> counts;
+		uint32_t count;
+		double sum;
+		double max;
+	};
+
+	void Reset(Generation &generation);
+
+	Generation m_generations[2];
+	int m_current;
+	uint32_t m_window;
+	double m_last;
+};
+
+// Stages of a frame and the latencies measured around them
+enum class Stage : uint32_t {
+	PUMP,                  // draining window messages into nuklear
+	POLL,                  // sampling the GPUs which are due
+	BUILD,                 // laying out the UI
+	RENDER,                // drawing the command buffer into the back buffer
+	BLIT,                  // handing the back buffer to the window
+	FRAME,                 // whole frame
+	SAMPLE_AGE,            // age of the newest snapshot when the frame showing it was presented
+	INPUT_LATENCY,         // from draining input to presenting the frame built from it
+	LAST
+};
+
+const char *StageName(Stage stage);
+
+// Histograms of every stage of the main loop
+class FrameTiming {
+public:
+	void Record(Stage stage, double seconds);
+	const Histogram &Get(Stage stage) const;
+
+	// Writes the statistics and buckets of every stage to [path] as JSON
+	bool Dump(const char *path) const;
+
+private:
+	Histogram m_stages[static_cast<uint32_t>(Stage::LAST)];
+};
+
+inline uint64_t Histogram::GetCount() const
+{
+	return uint64_t(m_generations[0].count) + m_generations[1].count;
+}
+
+inline double Histogram::GetLast() const
+{
+	return m_last;
+}
+
+inline void FrameTiming::Record(Stage stage, double seconds)
+{
+	m_stages[static_cast<uint32_t>(stage)].Record(seconds);
+}
+
+inline const Histogram &FrameTiming::Get(Stage stage) const
+{
+	return m_stages[static_cast<uint32_t>(stage)];
+}
+
+#endif
@@ -0,0 +1,376 @@
+#ifndef UI_H
+#define UI_H
+#include <algorithm> // std::min, std::max
+#include <cmath>     // std::fmin, std::fmax, std::isnan
+#include <string.h>
+#include <string>    // std::string, std::to_string
+#include <vector>    // std::vector
+
+#include "gpu.h"
+#include "history.h"
+#include "sampler.h"
+#include "view.h"
+
+// Panels of the main window
+//
+// nuklear is compiled with NK_PRIVATE, so its functions only exist in the
+// translation unit which implements it. The panels are built there as well,
+// include this after the nuklear implementation, which is how the window and
+// bench/ui_bench.cpp build the same frames.
+
+// Size of a GPU cell in the overview grid
+static constexpr int CELL_WIDTH = 200;
+static constexpr int CELL_HEIGHT = 76;
+
+// Number of GPU tabs shown next to the overview tab at once
+static constexpr int VISIBLE_TABS = 5;
+
+// Seconds of history shown by the overview sparklines and the detail charts
+static constexpr double SPARKLINE_WINDOW = 60.0;
+static constexpr double CHART_WINDOW = 300.0;
+
+// Selected tab, -1 is the overview
+static int g_tab = -1;
+static int g_first_tab = 0;
+
+// One name per GPU tab, set by NameTabs once the GPUs are enumerated
+static std::vector<std::string> g_tab_names;
+
+static void NameTabs(std::size_t gpu_count)
+{
+	g_tab_names.clear();
+	for (std::size_t i = 0; i < gpu_count; i++) {
+		g_tab_names.push_back("GPU " + std::to_string(i));
+	}
+}
+
+static void Tabs(struct nk_context *ctx)
+{
+	const int count = static_cast<int>(g_tab_names.size());
+
+	// Keep the selected GPU tab in view when it was picked from the overview
+	if (g_tab >= 0 && g_tab < g_first_tab) {
+		g_first_tab = g_tab;
+	} else if (g_tab >= g_first_tab + VISIBLE_TABS) {
+		g_first_tab = g_tab - VISIBLE_TABS + 1;
+	}
+
+	nk_layout_row_begin(ctx, NK_STATIC, 24, VISIBLE_TABS + 3);
+	{
+		nk_layout_row_push(ctx, 90);
+		if (nk_select_label(ctx, "Overview", NK_TEXT_CENTERED, g_tab == -1)) {
+			g_tab = -1;
+		}
+
+		nk_layout_row_push(ctx, 24);
+		if (nk_button_symbol(ctx, NK_SYMBOL_TRIANGLE_LEFT) && g_first_tab > 0) {
+			g_first_tab--;
+		}
+
+		const int last_tab = std::min(g_first_tab + VISIBLE_TABS, count);
+		for (int i = g_first_tab; i < last_tab; i++) {
+			nk_layout_row_push(ctx, 80);
+			if (nk_select_label(ctx, g_tab_names[i].c_str(), NK_TEXT_CENTERED, g_tab == i)) {
+				g_tab = i;
+			}
+		}
+
+		nk_layout_row_push(ctx, 24);
+		if (nk_button_symbol(ctx, NK_SYMBOL_TRIANGLE_RIGHT) && g_first_tab + VISIBLE_TABS < count) {
+			g_first_tab++;
+		}
+	}
+	nk_layout_row_end(ctx);
+}
+
+// Plots [metric] over the last [window] seconds of [history] into [bounds] scaled to
+// fit, returns false when there was nothing to plot
+//
+// Every pixel column is reduced to the min/max of the samples it covers and the
+// columns are joined into a single polyline going from the max to the min of a
+// column, so the cost depends on the width of the plot and not on how many
+// samples the window covers. Gaps in the history split the line.
+static bool Plot(struct nk_command_buffer *canvas, struct nk_rect bounds, const History &history, Metric metric, double window, struct nk_color color, float *low = nullptr, float *high = nullptr)
+{
+	// Reused every frame so plotting does not allocate
+	static std::vector<float> minimums;
+	static std::vector<float> maximums;
+	static std::vector<float> points;
+
+	const int columns = static_cast<int>(bounds.w);
+	if (columns <= 0 || history.GetSize() == 0) {
+		return false;
+	}
+
+	minimums.resize(columns);
+	maximums.resize(columns);
+	points.resize(4 * columns);
+
+	const double end = history.GetNewestTime();
+	history.Decimate(metric, end - window, end, columns, minimums.data(), maximums.data());
+
+	// Empty columns are NaN which fmin and fmax skip
+	float minimum = NAN;
+	float maximum = NAN;
+	for (int column = 0; column < columns; column++) {
+		minimum = std::fmin(minimum, minimums[column]);
+		maximum = std::fmax(maximum, maximums[column]);
+	}
+	if (std::isnan(maximum)) {
+		return false;
+	}
+
+	// Keep a flat line off the edges
+	if (maximum - minimum < 1.0f) {
+		minimum -= 0.5f;
+		maximum += 0.5f;
+	}
+	if (low) *low = minimum;
+	if (high) *high = maximum;
+
+	const float scale = (bounds.h - 1) / (maximum - minimum);
+	const float bottom = bounds.y + bounds.h - 1;
+
+	int count = 0;
+	auto flush = [&]() {
+		if (count > 1) {
+			nk_stroke_polyline(canvas, points.data(), count, 1.0f, color);
+		}
+		count = 0;
+	};
+
+	for (int column = 0; column < columns; column++) {
+		if (std::isnan(maximums[column])) {
+			flush();
+			continue;
+		}
+
+		const float x = bounds.x + column;
+		points[2 * count + 0] = x;
+		points[2 * count + 1] = bottom - (maximums[column] - minimum) * scale;
+		count++;
+
+		points[2 * count + 0] = x;
+		points[2 * count + 1] = bottom - (minimums[column] - minimum) * scale;
+		count++;
+	}
+	flush();
+
+	return true;
+}
+
+static void Cell(struct nk_context *ctx, struct nk_rect bounds, const GPU &gpu, const History &history, const GPUView &view)
+{
+	struct nk_command_buffer *canvas = nk_window_get_canvas(ctx);
+	const struct nk_user_font *font = ctx->style.font;
+	const struct nk_color background = nk_rgba(60, 67, 71, 255);
+	const struct nk_color foreground = ctx->style.text.color;
+
+	nk_fill_rect(canvas, bounds, 0, background);
+
+	float y = bounds.y + 2;
+	auto line = [&](const char *text) {
+		nk_draw_text(canvas, nk_rect(bounds.x + 4, y, bounds.w - 8, font->height), text, static_cast<int>(strlen(text)), font, background, foreground);
+		y += font->height;
+	};
+
+	line(gpu.GetName().c_str());
+	for (std::size_t i = 0; i < GPUView::CELL_LINES; i++) {
+		line(view.GetCellLine(i));
+	}
+
+	// Temperature sparkline to the right of the metrics, below the name
+	const struct nk_rect sparkline = nk_rect(bounds.x + bounds.w - 64, bounds.y + font->height + 6, 60, bounds.h - font->height - 10);
+	Plot(canvas, sparkline, history, Metric::TEMPERATURE_GPU, SPARKLINE_WINDOW, nk_rgba(230, 150, 60, 255));
+}
+
+// Text of a chart, reassembled only when its value or range changed
+struct ChartText {
+	Label value;
+	Label minimum;
+	Label maximum;
+	bool plotted;
+	char text[256];
+
+	ChartText(const char *suffix);
+};
+
+inline ChartText::ChartText(const char *suffix)
+	: value   { 0, suffix }
+	, minimum { 0, suffix }
+	, maximum { 0, suffix }
+	, plotted { false }
+	, text    { }
+{
+}
+
+// Chart of [metric] across the whole row with its name, current value and range
+static void Chart(struct nk_context *ctx, const History &history, const Snapshot &snapshot, Metric metric, ChartText &chart, struct nk_color color)
+{
+	if (!history.Has(metric)) {
+		return;
+	}
+
+	nk_layout_row_dynamic(ctx, 64, 1);
+
+	struct nk_rect bounds;
+	if (!nk_widget(&bounds, ctx)) {
+		return;
+	}
+
+	struct nk_command_buffer *canvas = nk_window_get_canvas(ctx);
+	const struct nk_user_font *font = ctx->style.font;
+	const struct nk_color background = nk_rgba(60, 67, 71, 255);
+	const struct nk_color foreground = ctx->style.text.color;
+
+	nk_fill_rect(canvas, bounds, 0, background);
+
+	float low = 0.0f;
+	float high = 0.0f;
+	const bool plotted = Plot(canvas, nk_rect(bounds.x + 2, bounds.y + 2, bounds.w - 4, bounds.h - 4), history, metric, CHART_WINDOW, color, &low, &high);
+
+	bool changed = chart.value.Update(snapshot.Has(metric) ? std::optional<float>(snapshot.Get(metric)) : std::nullopt);
+	if (plotted) {
+		changed = chart.minimum.Update(low) || changed;
+		changed = chart.maximum.Update(high) || changed;
+	}
+	if (changed || plotted != chart.plotted || !chart.text[0]) {
+		if (plotted) {
+			snprintf(chart.text, sizeof chart.text, "%s: %s (%s - %s)", MetricName(metric), chart.value.Get(), chart.minimum.Get(), chart.maximum.Get());
+		} else {
+			snprintf(chart.text, sizeof chart.text, "%s: %s", MetricName(metric), chart.value.Get());
+		}
+		chart.plotted = plotted;
+	}
+	nk_draw_text(canvas, nk_rect(bounds.x + 4, bounds.y + 2, bounds.w - 8, font->height), chart.text, static_cast<int>(strlen(chart.text)), font, background, foreground);
+}
+
+// Grid of every GPU, only the rows scrolled into view are built
+static void Overview(struct nk_context *ctx, float height, const std::vector<GPU*> &gpus, const std::vector<History> &histories, const std::vector<GPUView> &views)
+{
+	const float spacing = ctx->style.window.spacing.x;
+	const float width = nk_window_get_content_region(ctx).w;
+	const int columns = std::max(1, static_cast<int>(width / (CELL_WIDTH + spacing)));
+	const int rows = (static_cast<int>(gpus.size()) + columns - 1) / columns;
+
+	nk_layout_row_dynamic(ctx, height, 1);
+
+	struct nk_list_view view;
+	if (nk_list_view_begin(ctx, &view, "overview", 0, CELL_HEIGHT, rows)) {
+		nk_layout_row_static(ctx, CELL_HEIGHT, CELL_WIDTH, columns);
+		for (int row = view.begin; row < view.end; row++) {
+			for (int column = 0; column < columns; column++) {
+				const std::size_t index = row * columns + column;
+				if (index >= gpus.size()) {
+					break;
+				}
+
+				struct nk_rect bounds;
+				if (!nk_widget(&bounds, ctx)) {
+					continue;
+				}
+
+				Cell(ctx, bounds, *gpus[index], histories[index], views[index]);
+				if (nk_input_is_mouse_click_in_rect(&ctx->input, NK_BUTTON_LEFT, bounds)) {
+					g_tab = static_cast<int>(index);
+				}
+			}
+		}
+		nk_list_view_end(&view);
+	}
+}
+
+static void Details(struct nk_context *ctx, float height, const GPU *gpu, const Snapshot &snapshot, const History &history, const GPUView &view)
+{
+	nk_layout_row_dynamic(ctx, height, 1);
+	if (!nk_group_begin(ctx, "details", 0)) {
+		return;
+	}
+
+	// Shared by every GPU, switching tabs reformats them once
+	static ChartText temperature { "C" };
+	static ChartText core_clock { " MHz" };
+	static ChartText memory_clock { " MHz" };
+	static ChartText usage { "%" };
+	static ChartText fan_level { "%" };
+
+	Chart(ctx, history, snapshot, Metric::TEMPERATURE_GPU, temperature, nk_rgba(230, 150, 60, 255));
+	Chart(ctx, history, snapshot, Metric::CURRENT_CLOCK_CORE, core_clock, nk_rgba(90, 170, 230, 255));
+	Chart(ctx, history, snapshot, Metric::CURRENT_CLOCK_MEMORY, memory_clock, nk_rgba(150, 120, 230, 255));
+	Chart(ctx, history, snapshot, Metric::USAGE_GPU, usage, nk_rgba(110, 200, 110, 255));
+	Chart(ctx, history, snapshot, Metric::FAN_LEVEL, fan_level, nk_rgba(200, 200, 200, 255));
+
+	nk_layout_row_begin(ctx, NK_STATIC, 16, 2);
+	{
+		nk_layout_row_push(ctx, 150);
+		nk_label(ctx, "Serial:", NK_TEXT_LEFT);
+
+		nk_layout_row_push(ctx, 100);
+		nk_label(ctx, gpu->GetSerialNumber().c_str(), NK_TEXT_LEFT);
+	}
+	nk_layout_row_end(ctx);
+
+	const auto &identifiers = gpu->GetPCIIdentifierStrings();
+	nk_layout_row_begin(ctx, NK_STATIC, 16, 8);
+	{
+		nk_layout_row_push(ctx, 150);
+		nk_label(ctx, "PCI:", NK_TEXT_LEFT);
+
+		for (const auto &identifier : identifiers) {
+			nk_layout_row_push(ctx, 100);
+			nk_label(ctx, identifier.c_str(), NK_TEXT_LEFT);
+		}
+	}
+	nk_layout_row_end(ctx);
+
+	// Rows were prepared when the snapshot arrived, building them only lays them out
+	for (const std::size_t index : view.GetVisibleRows()) {
+		const auto &row = view.GetRow(index);
+		const bool typed = row.type[0] != '\0';
+		nk_layout_row_begin(ctx, NK_STATIC, 16, typed ? 3 : 2);
+		{
+			nk_layout_row_push(ctx, 150);
+			nk_label(ctx, row.name, NK_TEXT_LEFT);
+
+			nk_layout_row_push(ctx, typed ? 100 : 150);
+			nk_label(ctx, row.label.Get(), NK_TEXT_LEFT);
+
+			if (typed) {
+				nk_layout_row_push(ctx, 100);
+				nk_label(ctx, row.type, NK_TEXT_LEFT);
+			}
+		}
+		nk_layout_row_end(ctx);
+	}
+
+	nk_group_end(ctx);
+}
+
+// The whole main window covering [bounds], the overview or the details of the selected GPU
+static void MainWindow(struct nk_context *ctx, struct nk_rect bounds, const std::vector<GPU*> &gpus, const std::vector<History> &histories, const std::vector<GPUView> &views, const Sampler &sampler)
+{
+	struct nk_style *s = &ctx->style;
+	s->text.color = nk_rgba(255, 255, 255, 255);
+	s->window.border_color = nk_rgba(45, 45, 45, 255);
+	s->window.header.active = nk_style_item_color(nk_rgba(45, 45, 45, 255));
+	s->window.background = nk_rgba(50, 57, 61, 255);
+	s->window.fixed_background = nk_style_item_color(nk_rgba(50, 57, 61, 255));
+
+	// The window follows the client area, nk_begin only applies the rect on creation
+	nk_window_set_bounds(ctx, "NVFC", bounds);
+	if (nk_begin(ctx, "NVFC", bounds, NK_WINDOW_BORDER | NK_WINDOW_NO_SCROLLBAR | NK_WINDOW_BACKGROUND)) {
+		Tabs(ctx);
+
+		// Whatever is left below the tabs is for the selected panel
+		const struct nk_rect region = nk_window_get_content_region(ctx);
+		const float height = region.h - 24 - 2 * s->window.spacing.y;
+		if (g_tab < 0 || g_tab >= static_cast<int>(gpus.size())) {
+			Overview(ctx, height, gpus, histories, views);
+		} else {
+			Details(ctx, height, gpus[g_tab], sampler.GetSnapshot(g_tab), histories[g_tab], views[g_tab]);
+		}
+	}
+	nk_end(ctx);
+}
+
+#endif
@@ -0,0 +1,110 @@
+#include "view.h"
+
+struct RowDefinition {
+	const char *name;
+	const char *type;
+	Metric metric;
+	const char *suffix;
+};
+
+// Rows of the detail view in display order
+static const RowDefinition kRows[] = {
+	{ "Temperature:",   "GPU",          Metric::TEMPERATURE_GPU,          "C" },
+	{ "Temperature:",   "MEMORY",       Metric::TEMPERATURE_MEMORY,       "C" },
+	{ "Temperature:",   "POWER SUPPLY", Metric::TEMPERATURE_POWER_SUPPLY, "C" },
+	{ "Temperature:",   "BOARD",        Metric::TEMPERATURE_BOARD,        "C" },
+	{ "Voltage:",       "",             Metric::VOLTAGE,                  "V" },
+	{ "Current Clock:", "CORE",         Metric::CURRENT_CLOCK_CORE,       " MHz" },
+	{ "Current Clock:", "MEMORY",       Metric::CURRENT_CLOCK_MEMORY,     " MHz" },
+	{ "Current Clock:", "SHADER",       Metric::CURRENT_CLOCK_SHADER,     " MHz" },
+	{ "Base Clock:",    "CORE",         Metric::BASE_CLOCK_CORE,          " MHz" },
+	{ "Base Clock:",    "MEMORY",       Metric::BASE_CLOCK_MEMORY,        " MHz" },
+	{ "Base Clock:",    "SHADER",       Metric::BASE_CLOCK_SHADER,        " MHz" },
+	{ "Boost Clock:",   "CORE",         Metric::BOOST_CLOCK_CORE,         " MHz" },
+	{ "Boost Clock:",   "MEMORY",       Metric::BOOST_CLOCK_MEMORY,       " MHz" },
+	{ "Boost Clock:",   "SHADER",       Metric::BOOST_CLOCK_SHADER,       " MHz" },
+	{ "GPU:",           "",             Metric::USAGE_GPU,                "%" },
+	{ "Framebuffer:",   "",             Metric::USAGE_FB,                 "%" },
+	{ "Video Engine:",  "",             Metric::USAGE_VID,                "%" },
+	{ "Bus:",           "",             Metric::USAGE_BUS,                "%" },
+	{ "Total Memory:",  "",             Metric::MEMORY_TOTAL,             " MiB" },
+	{ "Free Memory:",   "",             Metric::MEMORY_FREE,              " MiB" },
+	{ "Used Memory:",   "",             Metric::MEMORY_USED,              " MiB" },
+	{ "Memory Load:",   "",             Metric::LAST,                     "%" },
+};
+
+static_assert(sizeof kRows / sizeof *kRows <= 64, "changed rows cannot hold every row");
+
+static std::optional<float> GetValue(const Snapshot &snapshot, Metric metric)
+{
+	if (metric == Metric::LAST) {
+		// Memory load is the only derived row
+		if (snapshot.Has(Metric::MEMORY_USED) && snapshot.Has(Metric::MEMORY_TOTAL) && snapshot.Get(Metric::MEMORY_TOTAL) > 0.0f) {
+			return 100.0f * snapshot.Get(Metric::MEMORY_USED) / snapshot.Get(Metric::MEMORY_TOTAL);
+		}
+		return std::nullopt;
+	}
+	if (snapshot.Has(metric)) {
+		return snapshot.Get(metric);
+	}
+	return std::nullopt;
+}
+
+GPUView::GPUView()
+	: m_sequence { 0 }
+	, m_changed  { 0 }
+	, m_seen     { false }
+{
+	for (const auto &definition : kRows) {
+		m_entries.push_back({ { definition.name, definition.type, std::nullopt, { 2, definition.suffix } }, definition.metric });
+	}
+	m_visible.reserve(m_entries.size());
+
+	m_cell[0] = { { "", "", std::nullopt, { 0, "C", "Temperature: " } }, Metric::TEMPERATURE_GPU };
+	m_cell[1] = { { "", "", std::nullopt, { 0, " MHz", "Core: " } }, Metric::CURRENT_CLOCK_CORE };
+	m_cell[2] = { { "", "", std::nullopt, { 0, "%", "Usage: " } }, Metric::USAGE_GPU };
+	for (auto &entry : m_cell) {
+		entry.row.label.Format(std::nullopt);
+	}
+}
+
+bool GPUView::Update(const Snapshot &snapshot)
+{
+	if (m_seen && snapshot.sequence == m_sequence) {
+		return false;
+	}
+	m_seen = true;
+	m_sequence = snapshot.sequence;
+
+	// Only rows whose value changed get reformatted, rows appearing or disappearing
+	// change the set of visible rows as well
+	m_changed = 0;
+	bool visibility = false;
+	for (std::size_t i = 0; i < m_entries.size(); i++) {
+		auto &row = m_entries[i].row;
+		const auto value = GetValue(snapshot, m_entries[i].metric);
+		if (value == row.value) {
+			continue;
+		}
+		visibility |= value.has_value() != row.value.has_value();
+		row.value = value;
+		row.label.Format(value);
+		m_changed |= uint64_t(1) << i;
+	}
+
+	if (visibility) {
+		m_visible.clear();
+		for (std::size_t i = 0; i < m_entries.size(); i++) {
+			if (m_entries[i].row.value) {
+				m_visible.push_back(i);
+			}
+		}
+	}
+
+	for (auto &entry : m_cell) {
+		entry.row.value = GetValue(snapshot, entry.metric);
+		entry.row.label.Format(entry.row.value);
+	}
+
+	return m_changed != 0;
+}
@@ -0,0 +1,78 @@
+#ifndef VIEW_H
+#define VIEW_H
+#include <array>    // std::array
+#include <vector>   // std::vector
+#include <optional> // std::optional
+
+#include "metric.h"
+#include "label.h"
+
+// Everything the UI shows for a GPU, prepared from its snapshots
+//
+// The rows are only touched when a new snapshot arrives, values are compared
+// against the previous snapshot and only rows whose value changed are
+// reformatted. Building a frame walks the prepared rows and never calls into
+// the GPU, so its cost depends on the rows shown rather than on the getters
+// behind them.
+class GPUView {
+public:
+	struct Row {
+		const char *name;
+		const char *type;                // shown after the value, empty when there is none
+		std::optional<float> value;
+		Label label;
+	};
+
+	// Lines of the overview cell below the name
+	static constexpr std::size_t CELL_LINES = 3;
+
+	GPUView();
+
+	// Prepares the rows for [snapshot] unless it was already seen, returns true
+	// when any row changed
+	bool Update(const Snapshot &snapshot);
+
+	// Indices of the rows with a value in display order
+	const std::vector<std::size_t> &GetVisibleRows() const;
+	const Row &GetRow(std::size_t row) const;
+
+	// Bit N is set when row N changed with the last snapshot
+	uint64_t GetChangedRows() const;
+
+	const char *GetCellLine(std::size_t line) const;
+
+private:
+	struct Entry {
+		Row row;
+		Metric metric;                   // Metric::LAST for rows derived from other metrics
+	};
+
+	std::vector<Entry> m_entries;
+	std::vector<std::size_t> m_visible;
+	std::array<Entry, CELL_LINES> m_cell;
+	uint64_t m_sequence;
+	uint64_t m_changed;
+	bool m_seen;
+};
+
+inline const std::vector<std::size_t> &GPUView::GetVisibleRows() const
+{
+	return m_visible;
+}
+
+inline const GPUView::Row &GPUView::GetRow(std::size_t row) const
+{
+	return m_entries[row].row;
+}
+
+inline uint64_t GPUView::GetChangedRows() const
+{
+	return m_changed;
+}
+
+inline const char *GPUView::GetCellLine(std::size_t line) const
+{
+	return m_cell[line].row.label.Get();
+}
+
+#endif